@@ -0,0 +1,1056 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <utility>
+
+#if defined(__AVX2__)
+	#define COMPRESSED_ID_SET_AVX2
+	#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define COMPRESSED_ID_SET_SSE2
+	#include <emmintrin.h>
+#endif
+
+#include "DynamicArray.h"
+
+/**
+ * @brief A compressed set of 32 bit ids in the style of a roaring bitmap.
+ * Ids are bucketed by their high 16 bits, and each bucket stores its low 16 bits in whichever container is smallest:
+ * a sorted array for sparse buckets, a 65536 bit bitmap for dense ones, or a list of runs for consecutive ids.
+ * Intersection and union work a bucket at a time, and bitmap buckets are combined with vector instructions.
+ * Sorted array buckets are intersected 8 values at a time against every rotation of 8 values from the other array,
+ * and united through a min and max merge network over blocks of 8, with scalar merges for what is left over.
+ */
+class CompressedIdSet
+{
+private:
+	enum class ContainerKind : uint8_t
+	{
+		Array,
+		Bitmap,
+		Run
+	};
+
+	// a run of consecutive ids, the length is stored minus one so a full bucket still fits in 16 bits
+	struct Run
+	{
+		uint16_t start = 0;
+		uint16_t lengthMinusOne = 0;
+	};
+
+	// only the dynamic array matching the kind is in use, the others stay empty
+	struct Container
+	{
+		ContainerKind kind = ContainerKind::Array;
+		uint32_t cardinality = 0;
+		DynamicArray<uint16_t> values;
+		DynamicArray<uint64_t> words;
+		DynamicArray<Run> runs;
+	};
+
+	// above this many ids a sorted array is larger than a bitmap
+	static constexpr uint32_t MAX_ARRAY_CARDINALITY = 4096;
+	static constexpr size_t BITMAP_WORDS = 65536 / 64;
+	static constexpr size_t BITMAP_BYTES = BITMAP_WORDS * sizeof(uint64_t);
+
+	DynamicArray<uint16_t> m_Keys;
+	DynamicArray<Container> m_Containers;
+	size_t m_Count = 0;
+
+	[[nodiscard]] size_t keyPosition(uint16_t key) const;
+
+	static void makeEmpty(Container& container, ContainerKind kind);
+	static void appendSorted(Container& container, uint16_t low);
+	static void convert(Container& container, ContainerKind kind);
+	static void optimize(Container& container);
+	static void materializeRuns(Container& container);
+
+	[[nodiscard]] static size_t countRuns(const Container& container);
+	[[nodiscard]] static bool containerContains(const Container& container, uint16_t low);
+	static bool containerInsert(Container& container, uint16_t low);
+	static bool containerErase(Container& container, uint16_t low);
+
+	[[nodiscard]] static Container intersectContainers(const Container& a, const Container& b);
+	[[nodiscard]] static Container uniteContainers(const Container& a, const Container& b);
+
+	static uint32_t andWords(const uint64_t* a, const uint64_t* b, uint64_t* out);
+	static uint32_t orWords(const uint64_t* a, const uint64_t* b, uint64_t* out);
+
+	static uint16_t* intersectArrays(const uint16_t* a, const uint16_t* aEnd, const uint16_t* b, const uint16_t* bEnd, uint16_t* out);
+	static uint16_t* uniteArrays(const uint16_t* a, const uint16_t* aEnd, const uint16_t* b, const uint16_t* bEnd, uint16_t* out);
+
+#if defined(COMPRESSED_ID_SET_AVX2) || defined(COMPRESSED_ID_SET_SSE2)
+	static __m128i rotateLanes(__m128i values);
+	static void mergeBlocks(__m128i& low, __m128i& high);
+#endif
+
+	template <typename Function>
+	static void forEachInContainer(const Container& container, Function&& function);
+
+public:
+	/**
+	 * @brief Construct an empty set.
+	 */
+	CompressedIdSet() = default;
+
+	/**
+	 * @brief Construct a set from an array of ids.
+	 * Sorted arrays are compressed in a single pass, unsorted arrays are sorted first. Duplicates are ignored.
+	 * @param ids Ids to add to the set.
+	 */
+	explicit CompressedIdSet(const DynamicArray<uint32_t>& ids);
+
+	/**
+	 * @brief Add an id to the set.
+	 * @param id Id to add.
+	 * @returns True if the id was added, false if it was already in the set.
+	 */
+	bool insert(uint32_t id);
+
+	/**
+	 * @brief Remove an id from the set.
+	 * @param id Id to remove.
+	 * @returns True if the id was removed, false if it was not in the set.
+	 */
+	bool erase(uint32_t id);
+
+	/**
+	 * @brief Returns whether an id is in the set.
+	 * @param id Id to look for.
+	 * @returns If the id is in the set.
+	 */
+	[[nodiscard]] bool contains(uint32_t id) const;
+
+	/**
+	 * @brief Returns the number of ids in the set.
+	 * @returns Number of ids in the set.
+	 */
+	[[nodiscard]] size_t len() const;
+
+	/**
+	 * @brief Returns whether the set is empty or not.
+	 * @returns If the set is empty or not.
+	 */
+	[[nodiscard]] bool isEmpty() const;
+
+	/**
+	 * @brief Remove every id from the set.
+	 */
+	void clear();
+
+	/**
+	 * @brief Convert every bucket to whichever container is smallest, including runs.
+	 * Inserting and erasing never create run containers, so call this after building a set up one id at a time.
+	 */
+	void runOptimize();
+
+	/**
+	 * @brief Returns the number of bytes the ids take up once compressed, not counting allocator padding.
+	 * @returns Size of the compressed ids in bytes.
+	 */
+	[[nodiscard]] size_t sizeInBytes() const;
+
+	/**
+	 * @brief Call a function on every id in the set, in ascending order.
+	 * @param function Function taking a uint32_t id.
+	 */
+	template <typename Function>
+	void forEach(Function&& function) const;
+
+	/**
+	 * @brief Returns the ids in the set as a sorted array.
+	 * @returns Sorted array of every id in the set.
+	 */
+	[[nodiscard]] DynamicArray<uint32_t> toArray() const;
+
+	/**
+	 * @brief Returns the intersection of two sets.
+	 * @param other Set to intersect with.
+	 * @returns Set of ids in both sets.
+	 */
+	[[nodiscard]] CompressedIdSet operator&(const CompressedIdSet& other) const;
+
+	/**
+	 * @brief Returns the union of two sets.
+	 * @param other Set to unite with.
+	 * @returns Set of ids in either set.
+	 */
+	[[nodiscard]] CompressedIdSet operator|(const CompressedIdSet& other) const;
+};
+
+inline CompressedIdSet::CompressedIdSet(const DynamicArray<uint32_t>& ids)
+{
+	if (ids.isEmpty()) return;
+
+	DynamicArray<uint32_t> sorted;
+	const uint32_t* data = ids.data();
+
+	if (!std::is_sorted(ids.data(), ids.data() + ids.len())) {
+		sorted = ids;
+		std::sort(sorted.data(), sorted.data() + sorted.len());
+		data = sorted.data();
+	}
+
+	const size_t count = ids.len();
+	size_t begin = 0;
+
+	while (begin < count) {
+		const uint16_t key = static_cast<uint16_t>(data[begin] >> 16);
+
+		size_t end = begin;
+		while (end < count && data[end] >> 16 == key) ++end;
+
+		// count the distinct ids and runs first, so the bucket goes straight into its smallest container
+		uint32_t cardinality = 0, runs = 0, previous = 0;
+
+		for (size_t i = begin; i < end; ++i) {
+			const uint32_t low = data[i] & 0xFFFF;
+			if (cardinality != 0 && low == previous) continue;
+
+			if (cardinality == 0 || low != previous + 1) ++runs;
+			++cardinality;
+			previous = low;
+		}
+
+		ContainerKind kind = cardinality <= MAX_ARRAY_CARDINALITY ? ContainerKind::Array : ContainerKind::Bitmap;
+		if (runs * sizeof(Run) < std::min<size_t>(cardinality * sizeof(uint16_t), BITMAP_BYTES)) {
+			kind = ContainerKind::Run;
+		}
+
+		Container container;
+		makeEmpty(container, kind);
+
+		for (size_t i = begin; i < end; ++i) {
+			const uint16_t low = static_cast<uint16_t>(data[i]);
+			if (i != begin && data[i] == data[i - 1]) continue;
+
+			appendSorted(container, low);
+		}
+
+		m_Count += container.cardinality;
+		m_Keys.append(key);
+		m_Containers.append(std::move(container));
+
+		begin = end;
+	}
+}
+
+inline bool CompressedIdSet::insert(uint32_t id)
+{
+	const uint16_t key = static_cast<uint16_t>(id >> 16);
+	const size_t pos = keyPosition(key);
+
+	if (pos == m_Keys.len() || m_Keys[pos] != key) {
+		m_Keys.insert(pos, key);
+		m_Containers.insert(pos, Container());
+	}
+
+	if (!containerInsert(m_Containers[pos], static_cast<uint16_t>(id))) return false;
+
+	++m_Count;
+	return true;
+}
+
+inline bool CompressedIdSet::erase(uint32_t id)
+{
+	const uint16_t key = static_cast<uint16_t>(id >> 16);
+	const size_t pos = keyPosition(key);
+
+	if (pos == m_Keys.len() || m_Keys[pos] != key) return false;
+	if (!containerErase(m_Containers[pos], static_cast<uint16_t>(id))) return false;
+
+	// empty buckets are dropped so every key has at least one id
+	if (m_Containers[pos].cardinality == 0) {
+		(void)m_Keys.pop(pos);
+		(void)m_Containers.pop(pos);
+	}
+
+	--m_Count;
+	return true;
+}
+
+inline bool CompressedIdSet::contains(uint32_t id) const
+{
+	const uint16_t key = static_cast<uint16_t>(id >> 16);
+	const size_t pos = keyPosition(key);
+
+	return pos != m_Keys.len() && m_Keys[pos] == key && containerContains(m_Containers[pos], static_cast<uint16_t>(id));
+}
+
+inline size_t CompressedIdSet::len() const
+{
+	return m_Count;
+}
+
+inline bool CompressedIdSet::isEmpty() const
+{
+	return m_Count == 0;
+}
+
+inline void CompressedIdSet::clear()
+{
+	m_Keys.clear();
+	m_Containers.clear();
+	m_Count = 0;
+}
+
+inline void CompressedIdSet::runOptimize()
+{
+	for (size_t i = 0; i < m_Containers.len(); ++i) {
+		optimize(m_Containers[i]);
+	}
+}
+
+inline size_t CompressedIdSet::sizeInBytes() const
+{
+	size_t bytes = m_Keys.len() * sizeof(uint16_t);
+
+	for (size_t i = 0; i < m_Containers.len(); ++i) {
+		const Container& container = m_Containers[i];
+
+		switch (container.kind) {
+		case ContainerKind::Array: bytes += container.values.len() * sizeof(uint16_t); break;
+		case ContainerKind::Bitmap: bytes += BITMAP_BYTES; break;
+		case ContainerKind::Run: bytes += container.runs.len() * sizeof(Run); break;
+		}
+	}
+
+	return bytes;
+}
+
+template <typename Function>
+void CompressedIdSet::forEach(Function&& function) const
+{
+	for (size_t i = 0; i < m_Keys.len(); ++i) {
+		const uint32_t high = static_cast<uint32_t>(m_Keys[i]) << 16;
+
+		forEachInContainer(m_Containers[i], [&](uint16_t low) { function(high | low); });
+	}
+}
+
+inline DynamicArray<uint32_t> CompressedIdSet::toArray() const
+{
+	DynamicArray<uint32_t> ids;
+	ids.resize(m_Count);
+
+	uint32_t* out = ids.data();
+	forEach([&out](uint32_t id) { *out++ = id; });
+
+	return ids;
+}
+
+inline CompressedIdSet CompressedIdSet::operator&(const CompressedIdSet& other) const
+{
+	CompressedIdSet result;
+	size_t i = 0, j = 0;
+
+	while (i < m_Keys.len() && j < other.m_Keys.len()) {
+		if (m_Keys[i] < other.m_Keys[j]) {
+			++i;
+		} else if (m_Keys[i] > other.m_Keys[j]) {
+			++j;
+		} else {
+			Container container = intersectContainers(m_Containers[i], other.m_Containers[j]);
+
+			if (container.cardinality != 0) {
+				result.m_Count += container.cardinality;
+				result.m_Keys.append(m_Keys[i]);
+				result.m_Containers.append(std::move(container));
+			}
+
+			++i;
+			++j;
+		}
+	}
+
+	return result;
+}
+
+inline CompressedIdSet CompressedIdSet::operator|(const CompressedIdSet& other) const
+{
+	CompressedIdSet result;
+	result.m_Count = m_Count + other.m_Count;
+
+	size_t i = 0, j = 0;
+
+	while (i < m_Keys.len() || j < other.m_Keys.len()) {
+		if (j == other.m_Keys.len() || (i < m_Keys.len() && m_Keys[i] < other.m_Keys[j])) {
+			result.m_Keys.append(m_Keys[i]);
+			result.m_Containers.append(m_Containers[i]);
+			++i;
+		} else if (i == m_Keys.len() || m_Keys[i] > other.m_Keys[j]) {
+			result.m_Keys.append(other.m_Keys[j]);
+			result.m_Containers.append(other.m_Containers[j]);
+			++j;
+		} else {
+			Container container = uniteContainers(m_Containers[i], other.m_Containers[j]);
+
+			// ids in both buckets were counted twice above
+			result.m_Count -= m_Containers[i].cardinality + other.m_Containers[j].cardinality - container.cardinality;
+			result.m_Keys.append(m_Keys[i]);
+			result.m_Containers.append(std::move(container));
+
+			++i;
+			++j;
+		}
+	}
+
+	return result;
+}
+
+inline size_t CompressedIdSet::keyPosition(uint16_t key) const
+{
+	if (m_Keys.isEmpty()) return 0;
+
+	return std::lower_bound(m_Keys.data(), m_Keys.data() + m_Keys.len(), key) - m_Keys.data();
+}
+
+inline void CompressedIdSet::makeEmpty(Container& container, ContainerKind kind)
+{
+	container.kind = kind;
+	container.cardinality = 0;
+	container.values.clear();
+	container.words.clear();
+	container.runs.clear();
+
+	if (kind == ContainerKind::Bitmap) {
+		container.words.resize(BITMAP_WORDS, 0);
+	}
+}
+
+inline void CompressedIdSet::appendSorted(Container& container, uint16_t low)
+{
+	switch (container.kind) {
+	case ContainerKind::Array:
+		container.values.append(low);
+		break;
+
+	case ContainerKind::Bitmap:
+		container.words.data()[low >> 6] |= uint64_t(1) << (low & 63);
+		break;
+
+	case ContainerKind::Run:
+		if (!container.runs.isEmpty()) {
+			Run& last = container.runs[container.runs.len() - 1];
+
+			if (static_cast<uint32_t>(last.start) + last.lengthMinusOne + 1 == low) {
+				++last.lengthMinusOne;
+				break;
+			}
+		}
+
+		container.runs.append({ low, 0 });
+		break;
+	}
+
+	++container.cardinality;
+}
+
+inline void CompressedIdSet::convert(Container& container, ContainerKind kind)
+{
+	if (container.kind == kind) return;
+
+	Container converted;
+	makeEmpty(converted, kind);
+
+	if (kind == ContainerKind::Array) {
+		converted.values.reserve(container.cardinality);
+	}
+
+	forEachInContainer(container, [&converted](uint16_t low) { appendSorted(converted, low); });
+
+	container = std::move(converted);
+}
+
+inline void CompressedIdSet::optimize(Container& container)
+{
+	const size_t runBytes = countRuns(container) * sizeof(Run);
+	const size_t arrayBytes = container.cardinality * sizeof(uint16_t);
+
+	if (runBytes < std::min(arrayBytes, BITMAP_BYTES)) {
+		convert(container, ContainerKind::Run);
+	} else {
+		convert(container, container.cardinality <= MAX_ARRAY_CARDINALITY ? ContainerKind::Array : ContainerKind::Bitmap);
+	}
+}
+
+inline void CompressedIdSet::materializeRuns(Container& container)
+{
+	if (container.kind != ContainerKind::Run) return;
+
+	convert(container, container.cardinality <= MAX_ARRAY_CARDINALITY ? ContainerKind::Array : ContainerKind::Bitmap);
+}
+
+inline size_t CompressedIdSet::countRuns(const Container& container)
+{
+	switch (container.kind) {
+	case ContainerKind::Array: {
+		const uint16_t* values = container.values.data();
+		size_t runs = container.values.isEmpty() ? 0 : 1;
+
+		for (size_t i = 1; i < container.values.len(); ++i) {
+			runs += values[i] != values[i - 1] + 1;
+		}
+
+		return runs;
+	}
+
+	case ContainerKind::Bitmap: {
+		const uint64_t* words = container.words.data();
+		size_t runs = 0;
+		uint64_t carry = 0;
+
+		// a run starts at every set bit whose lower neighbour is clear
+		for (size_t i = 0; i < BITMAP_WORDS; ++i) {
+			runs += std::popcount(words[i] & ~((words[i] << 1) | carry));
+			carry = words[i] >> 63;
+		}
+
+		return runs;
+	}
+
+	case ContainerKind::Run:
+		return container.runs.len();
+	}
+
+	return 0;
+}
+
+inline bool CompressedIdSet::containerContains(const Container& container, uint16_t low)
+{
+	switch (container.kind) {
+	case ContainerKind::Array: {
+		const uint16_t* values = container.values.data();
+		return container.cardinality != 0 && std::binary_search(values, values + container.values.len(), low);
+	}
+
+	case ContainerKind::Bitmap:
+		return (container.words.data()[low >> 6] >> (low & 63)) & 1;
+
+	case ContainerKind::Run: {
+		const Run* runs = container.runs.data();
+		const Run* after = std::upper_bound(runs, runs + container.runs.len(), low,
+			[](uint16_t value, const Run& run) { return value < run.start; });
+
+		if (after == runs) return false;
+
+		const Run& run = *(after - 1);
+		return low <= static_cast<uint32_t>(run.start) + run.lengthMinusOne;
+	}
+	}
+
+	return false;
+}
+
+inline bool CompressedIdSet::containerInsert(Container& container, uint16_t low)
+{
+	if (containerContains(container, low)) return false;
+
+	materializeRuns(container);
+
+	if (container.kind == ContainerKind::Array && container.cardinality == MAX_ARRAY_CARDINALITY) {
+		convert(container, ContainerKind::Bitmap);
+	}
+
+	if (container.kind == ContainerKind::Array) {
+		const uint16_t* values = container.values.data();
+		const size_t pos = container.values.isEmpty() ? 0 : std::lower_bound(values, values + container.values.len(), low) - values;
+
+		container.values.insert(pos, low);
+	} else {
+		container.words.data()[low >> 6] |= uint64_t(1) << (low & 63);
+	}
+
+	++container.cardinality;
+	return true;
+}
+
+inline bool CompressedIdSet::containerErase(Container& container, uint16_t low)
+{
+	if (!containerContains(container, low)) return false;
+
+	materializeRuns(container);
+
+	if (container.kind == ContainerKind::Array) {
+		const uint16_t* values = container.values.data();
+		(void)container.values.pop(std::lower_bound(values, values + container.values.len(), low) - values);
+
+		--container.cardinality;
+	} else {
+		container.words.data()[low >> 6] &= ~(uint64_t(1) << (low & 63));
+
+		if (--container.cardinality <= MAX_ARRAY_CARDINALITY) {
+			convert(container, ContainerKind::Array);
+		}
+	}
+
+	return true;
+}
+
+inline CompressedIdSet::Container CompressedIdSet::intersectContainers(const Container& a, const Container& b)
+{
+	Container result;
+
+	if (a.kind == ContainerKind::Run && b.kind == ContainerKind::Run) {
+		makeEmpty(result, ContainerKind::Run);
+
+		size_t i = 0, j = 0;
+		while (i < a.runs.len() && j < b.runs.len()) {
+			const uint32_t aEnd = static_cast<uint32_t>(a.runs[i].start) + a.runs[i].lengthMinusOne;
+			const uint32_t bEnd = static_cast<uint32_t>(b.runs[j].start) + b.runs[j].lengthMinusOne;
+			const uint32_t start = std::max(a.runs[i].start, b.runs[j].start);
+			const uint32_t end = std::min(aEnd, bEnd);
+
+			if (start <= end) {
+				result.runs.append({ static_cast<uint16_t>(start), static_cast<uint16_t>(end - start) });
+				result.cardinality += end - start + 1;
+			}
+
+			if (aEnd < bEnd) ++i; else ++j;
+		}
+
+		optimize(result);
+		return result;
+	}
+
+	if (a.kind == ContainerKind::Run || b.kind == ContainerKind::Run) {
+		const Container& run = a.kind == ContainerKind::Run ? a : b;
+		const Container& other = a.kind == ContainerKind::Run ? b : a;
+
+		if (other.kind == ContainerKind::Bitmap) {
+			Container bitmap = run;
+			convert(bitmap, ContainerKind::Bitmap);
+
+			return intersectContainers(bitmap, other);
+		}
+
+		// walk the sorted values and the runs together, keeping values inside a run
+		makeEmpty(result, ContainerKind::Array);
+
+		size_t r = 0;
+		for (size_t i = 0; i < other.values.len(); ++i) {
+			const uint16_t low = other.values[i];
+
+			while (r < run.runs.len() && static_cast<uint32_t>(run.runs[r].start) + run.runs[r].lengthMinusOne < low) ++r;
+			if (r == run.runs.len()) break;
+
+			if (low >= run.runs[r].start) appendSorted(result, low);
+		}
+
+		return result;
+	}
+
+	if (a.kind == ContainerKind::Bitmap && b.kind == ContainerKind::Bitmap) {
+		makeEmpty(result, ContainerKind::Bitmap);
+		result.cardinality = andWords(a.words.data(), b.words.data(), result.words.data());
+
+		if (result.cardinality <= MAX_ARRAY_CARDINALITY) {
+			convert(result, ContainerKind::Array);
+		}
+
+		return result;
+	}
+
+	makeEmpty(result, ContainerKind::Array);
+
+	if (a.kind == ContainerKind::Bitmap || b.kind == ContainerKind::Bitmap) {
+		const Container& array = a.kind == ContainerKind::Array ? a : b;
+		const uint64_t* words = (a.kind == ContainerKind::Bitmap ? a : b).words.data();
+
+		for (size_t i = 0; i < array.values.len(); ++i) {
+			const uint16_t low = array.values[i];
+			if ((words[low >> 6] >> (low & 63)) & 1) appendSorted(result, low);
+		}
+
+		return result;
+	}
+
+	if (a.cardinality == 0 || b.cardinality == 0) return result;
+
+	const Container& small = a.cardinality <= b.cardinality ? a : b;
+	const Container& large = a.cardinality <= b.cardinality ? b : a;
+	const uint16_t* smallValues = small.values.data();
+	const uint16_t* largeValues = large.values.data();
+	const uint16_t* largeEnd = largeValues + large.values.len();
+
+	// write every candidate and only advance over matches, so the merge has no unpredictable branches
+	result.values.resize(small.cardinality);
+	uint16_t* out = result.values.data();
+
+	if (small.cardinality * 32 < large.cardinality) {
+		// very different sizes, so binary search the large array rather than walking all of it
+		for (size_t i = 0; i < small.values.len() && largeValues != largeEnd; ++i) {
+			largeValues = std::lower_bound(largeValues, largeEnd, smallValues[i]);
+
+			*out = smallValues[i];
+			out += largeValues != largeEnd && *largeValues == smallValues[i];
+		}
+	} else {
+		out = intersectArrays(smallValues, smallValues + small.values.len(), largeValues, largeEnd, out);
+	}
+
+	result.cardinality = static_cast<uint32_t>(out - result.values.data());
+	result.values.resize(result.cardinality);
+
+	return result;
+}
+
+inline CompressedIdSet::Container CompressedIdSet::uniteContainers(const Container& a, const Container& b)
+{
+	Container result;
+
+	if (a.kind == ContainerKind::Run && b.kind == ContainerKind::Run) {
+		makeEmpty(result, ContainerKind::Run);
+
+		// merge the runs by start, joining any which overlap or touch
+		size_t i = 0, j = 0;
+		uint32_t start = 0, end = 0;
+		bool open = false;
+
+		while (i < a.runs.len() || j < b.runs.len()) {
+			const bool takeA = j == b.runs.len() || (i < a.runs.len() && a.runs[i].start <= b.runs[j].start);
+			const Run& run = takeA ? a.runs[i++] : b.runs[j++];
+			const uint32_t runEnd = static_cast<uint32_t>(run.start) + run.lengthMinusOne;
+
+			if (open && run.start <= end + 1) {
+				end = std::max(end, runEnd);
+				continue;
+			}
+
+			if (open) {
+				result.runs.append({ static_cast<uint16_t>(start), static_cast<uint16_t>(end - start) });
+				result.cardinality += end - start + 1;
+			}
+
+			start = run.start;
+			end = runEnd;
+			open = true;
+		}
+
+		if (open) {
+			result.runs.append({ static_cast<uint16_t>(start), static_cast<uint16_t>(end - start) });
+			result.cardinality += end - start + 1;
+		}
+
+		optimize(result);
+		return result;
+	}
+
+	if (a.kind == ContainerKind::Run || b.kind == ContainerKind::Run) {
+		const Container& run = a.kind == ContainerKind::Run ? a : b;
+		const Container& other = a.kind == ContainerKind::Run ? b : a;
+
+		// a full bucket absorbs anything
+		if (run.cardinality == 65536) return run;
+
+		Container bitmap = run;
+		convert(bitmap, ContainerKind::Bitmap);
+
+		return uniteContainers(bitmap, other);
+	}
+
+	if (a.kind == ContainerKind::Bitmap && b.kind == ContainerKind::Bitmap) {
+		makeEmpty(result, ContainerKind::Bitmap);
+		result.cardinality = orWords(a.words.data(), b.words.data(), result.words.data());
+
+		return result;
+	}
+
+	if (a.kind == ContainerKind::Bitmap || b.kind == ContainerKind::Bitmap) {
+		const Container& array = a.kind == ContainerKind::Array ? a : b;
+		result = a.kind == ContainerKind::Bitmap ? a : b;
+
+		uint64_t* words = result.words.data();
+
+		for (size_t i = 0; i < array.values.len(); ++i) {
+			const uint16_t low = array.values[i];
+			const uint64_t bit = uint64_t(1) << (low & 63);
+
+			result.cardinality += (words[low >> 6] & bit) == 0;
+			words[low >> 6] |= bit;
+		}
+
+		return result;
+	}
+
+	if (a.cardinality + b.cardinality > MAX_ARRAY_CARDINALITY) {
+		// too many for an array before duplicates are removed, so merge into a bitmap and shrink back if it fits after all
+		makeEmpty(result, ContainerKind::Bitmap);
+
+		forEachInContainer(a, [&result](uint16_t low) { result.words.data()[low >> 6] |= uint64_t(1) << (low & 63); });
+		forEachInContainer(b, [&result](uint16_t low) { result.words.data()[low >> 6] |= uint64_t(1) << (low & 63); });
+
+		for (size_t i = 0; i < BITMAP_WORDS; ++i) {
+			result.cardinality += std::popcount(result.words.data()[i]);
+		}
+
+		if (result.cardinality <= MAX_ARRAY_CARDINALITY) {
+			convert(result, ContainerKind::Array);
+		}
+
+		return result;
+	}
+
+	makeEmpty(result, ContainerKind::Array);
+	if (a.cardinality + b.cardinality == 0) return result;
+
+	result.values.resize(a.cardinality + b.cardinality);
+
+	const uint16_t* aValues = a.values.data();
+	const uint16_t* bValues = b.values.data();
+	uint16_t* out = uniteArrays(aValues, aValues + a.values.len(), bValues, bValues + b.values.len(), result.values.data());
+
+	result.cardinality = static_cast<uint32_t>(out - result.values.data());
+	result.values.resize(result.cardinality);
+
+	return result;
+}
+
+inline uint32_t CompressedIdSet::andWords(const uint64_t* a, const uint64_t* b, uint64_t* out)
+{
+	// bitmaps live in cache line aligned dynamic arrays, so aligned loads are safe
+#if defined(COMPRESSED_ID_SET_AVX2)
+	for (size_t i = 0; i < BITMAP_WORDS; i += 4) {
+		const __m256i x = _mm256_load_si256(reinterpret_cast<const __m256i*>(a + i));
+		const __m256i y = _mm256_load_si256(reinterpret_cast<const __m256i*>(b + i));
+		_mm256_store_si256(reinterpret_cast<__m256i*>(out + i), _mm256_and_si256(x, y));
+	}
+#elif defined(COMPRESSED_ID_SET_SSE2)
+	for (size_t i = 0; i < BITMAP_WORDS; i += 2) {
+		const __m128i x = _mm_load_si128(reinterpret_cast<const __m128i*>(a + i));
+		const __m128i y = _mm_load_si128(reinterpret_cast<const __m128i*>(b + i));
+		_mm_store_si128(reinterpret_cast<__m128i*>(out + i), _mm_and_si128(x, y));
+	}
+#else
+	for (size_t i = 0; i < BITMAP_WORDS; ++i) {
+		out[i] = a[i] & b[i];
+	}
+#endif
+
+	uint32_t cardinality = 0;
+	for (size_t i = 0; i < BITMAP_WORDS; ++i) {
+		cardinality += std::popcount(out[i]);
+	}
+
+	return cardinality;
+}
+
+inline uint32_t CompressedIdSet::orWords(const uint64_t* a, const uint64_t* b, uint64_t* out)
+{
+#if defined(COMPRESSED_ID_SET_AVX2)
+	for (size_t i = 0; i < BITMAP_WORDS; i += 4) {
+		const __m256i x = _mm256_load_si256(reinterpret_cast<const __m256i*>(a + i));
+		const __m256i y = _mm256_load_si256(reinterpret_cast<const __m256i*>(b + i));
+		_mm256_store_si256(reinterpret_cast<__m256i*>(out + i), _mm256_or_si256(x, y));
+	}
+#elif defined(COMPRESSED_ID_SET_SSE2)
+	for (size_t i = 0; i < BITMAP_WORDS; i += 2) {
+		const __m128i x = _mm_load_si128(reinterpret_cast<const __m128i*>(a + i));
+		const __m128i y = _mm_load_si128(reinterpret_cast<const __m128i*>(b + i));
+		_mm_store_si128(reinterpret_cast<__m128i*>(out + i), _mm_or_si128(x, y));
+	}
+#else
+	for (size_t i = 0; i < BITMAP_WORDS; ++i) {
+		out[i] = a[i] | b[i];
+	}
+#endif
+
+	uint32_t cardinality = 0;
+	for (size_t i = 0; i < BITMAP_WORDS; ++i) {
+		cardinality += std::popcount(out[i]);
+	}
+
+	return cardinality;
+}
+
+inline uint16_t* CompressedIdSet::intersectArrays(const uint16_t* a, const uint16_t* aEnd, const uint16_t* b, const uint16_t* bEnd, uint16_t* out)
+{
+	// every value is written and only kept if it matched, which never runs past a's own length
+#if defined(COMPRESSED_ID_SET_AVX2) || defined(COMPRESSED_ID_SET_SSE2)
+	while (aEnd - a >= 8 && bEnd - b >= 8) {
+		// comparing against all 8 rotations of b's block finds each of a's values wherever it is in the block
+		const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a));
+		__m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b));
+		__m128i matches = _mm_cmpeq_epi16(x, y);
+
+		for (int rotation = 1; rotation < 8; ++rotation) {
+			y = rotateLanes(y);
+			matches = _mm_or_si128(matches, _mm_cmpeq_epi16(x, y));
+		}
+
+		// two mask bits per 16 bit lane
+		const auto mask = static_cast<uint32_t>(_mm_movemask_epi8(matches));
+
+		for (int lane = 0; lane < 8; ++lane) {
+			*out = a[lane];
+			out += (mask >> (lane * 2)) & 1;
+		}
+
+		// step past whichever block ends first, or both if they end on the same value
+		const uint16_t aLast = a[7], bLast = b[7];
+		a += aLast <= bLast ? 8 : 0;
+		b += bLast <= aLast ? 8 : 0;
+	}
+#endif
+
+	while (a != aEnd && b != bEnd) {
+		const uint16_t x = *a, y = *b;
+
+		*out = x;
+		out += x == y;
+		a += x <= y;
+		b += y <= x;
+	}
+
+	return out;
+}
+
+inline uint16_t* CompressedIdSet::uniteArrays(const uint16_t* a, const uint16_t* aEnd, const uint16_t* b, const uint16_t* bEnd, uint16_t* out)
+{
+#if defined(COMPRESSED_ID_SET_AVX2) || defined(COMPRESSED_ID_SET_SSE2)
+	if (aEnd - a >= 8 && bEnd - b >= 8) {
+		// biased so the signed 16 bit min and max order the values as unsigned
+		const __m128i bias = _mm_set1_epi16(INT16_MIN);
+		const auto load = [&bias](const uint16_t* values) {
+			return _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(values)), bias);
+		};
+
+		alignas(16) uint16_t block[8];
+		const auto writeBlock = [&](__m128i values) {
+			_mm_store_si128(reinterpret_cast<__m128i*>(block), _mm_xor_si128(values, bias));
+
+			// a value in both arrays comes out of the merge twice, side by side
+			for (uint16_t value : block) {
+				*out = value;
+				out += value != out[-1];
+			}
+		};
+
+		__m128i low = load(a), high = load(b);
+		a += 8;
+		b += 8;
+
+		mergeBlocks(low, high);
+
+		// start with the lowest value so every write has one before it to compare against
+		*out++ = static_cast<uint16_t>(_mm_cvtsi128_si32(low) ^ 0x8000);
+		writeBlock(low);
+
+		// hold the highest 8 back and merge in the next block of whichever array is behind,
+		// after which nothing left in either array is smaller than the lowest 8, so they are final
+		bool takeA;
+
+		while (true) {
+			takeA = b == bEnd || (a != aEnd && *a <= *b);
+
+			const uint16_t*& next = takeA ? a : b;
+			if ((takeA ? aEnd : bEnd) - next < 8) break;
+
+			low = load(next);
+			next += 8;
+
+			mergeBlocks(low, high);
+			writeBlock(low);
+		}
+
+		// the array which ran short has fewer than 8 left, so merge those with the held back values on the stack,
+		// then merge that with the rest of the other array
+		_mm_store_si128(reinterpret_cast<__m128i*>(block), _mm_xor_si128(high, bias));
+
+		uint16_t held[16];
+		const uint16_t* heldValues = held;
+		const uint16_t* heldEnd = takeA ? std::merge(block, block + 8, a, aEnd, held) : std::merge(block, block + 8, b, bEnd, held);
+		const uint16_t* rest = takeA ? b : a;
+		const uint16_t* restEnd = takeA ? bEnd : aEnd;
+
+		while (heldValues != heldEnd && rest != restEnd) {
+			const uint16_t x = *heldValues, y = *rest;
+
+			*out = std::min(x, y);
+			out += *out != out[-1];
+			heldValues += x <= y;
+			rest += y <= x;
+		}
+
+		for (; heldValues != heldEnd; ++heldValues) {
+			*out = *heldValues;
+			out += *out != out[-1];
+		}
+
+		if (rest != restEnd && *rest == out[-1]) ++rest;
+		return std::copy(rest, restEnd, out);
+	}
+#endif
+
+	while (a != aEnd && b != bEnd) {
+		const uint16_t x = *a, y = *b;
+
+		*out++ = std::min(x, y);
+		a += x <= y;
+		b += y <= x;
+	}
+
+	out = std::copy(a, aEnd, out);
+	return std::copy(b, bEnd, out);
+}
+
+#if defined(COMPRESSED_ID_SET_AVX2) || defined(COMPRESSED_ID_SET_SSE2)
+inline __m128i CompressedIdSet::rotateLanes(__m128i values)
+{
+	// move every 16 bit lane down one, with the lowest wrapping round to the top
+	return _mm_or_si128(_mm_srli_si128(values, 2), _mm_slli_si128(values, 14));
+}
+
+inline void CompressedIdSet::mergeBlocks(__m128i& low, __m128i& high)
+{
+	// with both blocks sorted, rotating the minimums past the maximums 8 times sorts all 16 values across the pair
+	__m128i min = _mm_min_epi16(low, high);
+	__m128i max = _mm_max_epi16(low, high);
+
+	for (int step = 1; step < 8; ++step) {
+		min = rotateLanes(min);
+
+		const __m128i lower = _mm_min_epi16(min, max);
+		max = _mm_max_epi16(min, max);
+		min = lower;
+	}
+
+	low = rotateLanes(min);
+	high = max;
+}
+#endif
+
+template <typename Function>
+void CompressedIdSet::forEachInContainer(const Container& container, Function&& function)
+{
+	switch (container.kind) {
+	case ContainerKind::Array:
+		for (size_t i = 0; i < container.values.len(); ++i) {
+			function(container.values.data()[i]);
+		}
+		break;
+
+	case ContainerKind::Bitmap:
+		for (size_t i = 0; i < BITMAP_WORDS; ++i) {
+			uint64_t word = container.words.data()[i];
+
+			while (word != 0) {
+				function(static_cast<uint16_t>(i * 64 + std::countr_zero(word)));
+				word &= word - 1;
+			}
+		}
+		break;
+
+	case ContainerKind::Run:
+		for (size_t i = 0; i < container.runs.len(); ++i) {
+			const Run& run = container.runs[i];
+
+			for (uint32_t low = run.start; low <= static_cast<uint32_t>(run.start) + run.lengthMinusOne; ++low) {
+				function(static_cast<uint16_t>(low));
+			}
+		}
+		break;
+	}
+}
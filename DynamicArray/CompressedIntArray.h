@@ -0,0 +1,466 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define COMPRESSED_INT_ARRAY_SSE2
+	#include <emmintrin.h>
+#endif
+
+#include "DynamicArray.h"
+
+/**
+ * @brief An append only array of sorted unsigned integers, stored compressed in blocks of 128 values.
+ * Each block keeps its first value and the gaps between its values. The smallest gap is stored once
+ * as a frame of reference, and every gap is bit packed as its distance above that frame (PFOR). The bit width
+ * is chosen to minimise the block's size, and the few gaps too wide for it are stored as exceptions which patch
+ * their high bits back in. Regular sequences such as fixed interval timestamps pack down to zero bits per value.
+ * Gaps are packed interleaved across the lanes of a 128 bit vector, so a whole vector of gaps unpacks with
+ * one shift and mask, and a prefix sum in register turns the gaps back into values.
+ * The first and last value of every block form a skip index, so searches only decode a single block.
+ * Values are appended to an uncompressed tail which is packed once it holds a whole block.
+ * @tparam T Datatype of values, a 32 or 64 bit unsigned integer.
+ */
+template <typename T = uint64_t>
+class CompressedIntArray
+{
+	static_assert(std::is_unsigned_v<T> && (sizeof(T) == 4 || sizeof(T) == 8), "Values must be 32 or 64 bit unsigned integers.");
+
+public:
+	/**
+	 * @brief Number of values in each compressed block.
+	 */
+	static constexpr size_t BLOCK_SIZE = 128;
+
+private:
+	struct Block
+	{
+		// the smallest and largest value in the block, as values are sorted
+		T first = 0;
+		T last = 0;
+		// frame of reference every packed gap is relative to
+		T minGap = 0;
+		// index of the block's first packed word and first exception
+		size_t offset = 0;
+		size_t exceptionOffset = 0;
+		uint8_t bitWidth = 0;
+		uint8_t exceptionCount = 0;
+	};
+
+	// bits in a packed word, each word holds one lane of a 128 bit vector
+	static constexpr size_t WORD_BITS = sizeof(T) * 8;
+	static constexpr size_t LANES = 16 / sizeof(T);
+
+	// a block of 128 values at b bits each packs into exactly 128b / WORD_BITS words
+	static constexpr size_t WORDS_PER_BIT = BLOCK_SIZE / WORD_BITS;
+
+	// an exception costs its position and its high bits
+	static constexpr size_t EXCEPTION_BITS = 8 + WORD_BITS;
+
+	DynamicArray<T> m_Words;
+	DynamicArray<Block> m_Blocks;
+	// position in its block and the bits above the block's bit width of every gap too wide to pack
+	DynamicArray<uint8_t> m_ExceptionPositions;
+	DynamicArray<T> m_ExceptionHighBits;
+	std::array<T, BLOCK_SIZE> m_Tail = {};
+	size_t m_TailCount = 0;
+
+	void packTail();
+	void decodeBlock(size_t blockIndex, T* out) const;
+	void unpackGaps(const Block& block, T* out) const;
+	[[nodiscard]] T unpackGap(const Block& block, size_t index) const;
+
+	static void prefixSum(T* values);
+
+public:
+	/**
+	 * @brief Construct an empty array.
+	 */
+	CompressedIntArray() = default;
+
+	/**
+	 * @brief Construct a compressed array from sorted values.
+	 * @param values Values in ascending order.
+	 */
+	explicit CompressedIntArray(const DynamicArray<T>& values);
+
+	/**
+	 * @brief Append a value to the end of the array.
+	 * @param value Value to add, no smaller than the last value in the array.
+	 */
+	void append(T value);
+
+	/**
+	 * @brief Returns the value at the given position.
+	 * Only the gaps before the value in its block are decoded.
+	 * @param pos Position of value to return.
+	 * @returns The value at the given position.
+	 */
+	[[nodiscard]] T at(size_t pos) const;
+
+	/**
+	 * @brief Returns the value at the given position.
+	 * @param pos Position of value to return.
+	 * @returns The value at the given position.
+	 */
+	[[nodiscard]] T operator[](size_t pos) const;
+
+	/**
+	 * @brief Returns the position of the first value no smaller than a given value.
+	 * The skip index finds the one block the value could be in, and only that block is decoded.
+	 * @param value Value to search for.
+	 * @returns Position of the first value no smaller than the given value, or the length if there is none.
+	 */
+	[[nodiscard]] size_t lowerBound(T value) const;
+
+	/**
+	 * @brief Returns the number of values in the array.
+	 * @returns Number of values in the array.
+	 */
+	[[nodiscard]] size_t len() const;
+
+	/**
+	 * @brief Returns whether the array is empty or not.
+	 * @returns If the array is empty or not.
+	 */
+	[[nodiscard]] bool isEmpty() const;
+
+	/**
+	 * @brief Clear every value in the array.
+	 */
+	void clear();
+
+	/**
+	 * @brief Returns the number of bytes used by the packed values, the skip index and the tail.
+	 * @returns Size of the array in bytes.
+	 */
+	[[nodiscard]] size_t sizeInBytes() const;
+
+	/**
+	 * @brief Decode every value into a dynamic array, replacing its contents.
+	 * @param out Array to decode into.
+	 */
+	void decode(DynamicArray<T>& out) const;
+
+	/**
+	 * @brief Returns every value decoded into a dynamic array.
+	 * @returns Array of every value, in order.
+	 */
+	[[nodiscard]] DynamicArray<T> toArray() const;
+};
+
+template <typename T>
+CompressedIntArray<T>::CompressedIntArray(const DynamicArray<T>& values)
+{
+	for (size_t i = 0; i < values.len(); ++i) {
+		append(values[i]);
+	}
+}
+
+template <typename T>
+void CompressedIntArray<T>::append(T value)
+{
+	const bool smallerThanLast = m_TailCount != 0 ? value < m_Tail[m_TailCount - 1] : !m_Blocks.isEmpty() && value < m_Blocks[m_Blocks.len() - 1].last;
+
+	if (smallerThanLast)
+		throw std::range_error("Cannot append a value smaller than the last value in a sorted array.");
+
+	m_Tail[m_TailCount++] = value;
+
+	if (m_TailCount == BLOCK_SIZE) {
+		packTail();
+	}
+}
+
+template <typename T>
+T CompressedIntArray<T>::at(size_t pos) const
+{
+	ASSERT(pos < len(), "Array index out of bounds!");
+
+	const size_t blockIndex = pos / BLOCK_SIZE, index = pos % BLOCK_SIZE;
+
+	if (blockIndex == m_Blocks.len()) return m_Tail[index];
+
+	const Block& block = m_Blocks[blockIndex];
+	T value = block.first + static_cast<T>(index) * block.minGap;
+
+	if (block.bitWidth != 0) {
+		for (size_t i = 1; i <= index; ++i) {
+			value += unpackGap(block, i);
+		}
+	}
+
+	// exceptions are stored in position order, so stop at the first one past the value
+	for (size_t i = 0; i < block.exceptionCount; ++i) {
+		if (m_ExceptionPositions[block.exceptionOffset + i] > index) break;
+		value += m_ExceptionHighBits[block.exceptionOffset + i] << block.bitWidth;
+	}
+
+	return value;
+}
+
+template <typename T>
+T CompressedIntArray<T>::operator[](size_t pos) const
+{
+	return at(pos);
+}
+
+template <typename T>
+size_t CompressedIntArray<T>::lowerBound(T value) const
+{
+	const Block* blocks = m_Blocks.data();
+	const Block* blocksEnd = blocks + m_Blocks.len();
+
+	// the first block whose last value is large enough is the only one which can hold the answer
+	const Block* block = std::partition_point(blocks, blocksEnd, [value](const Block& candidate) { return candidate.last < value; });
+
+	if (block != blocksEnd) {
+		const size_t blockIndex = block - blocks;
+		if (block->first >= value) return blockIndex * BLOCK_SIZE;
+
+		T values[BLOCK_SIZE];
+		decodeBlock(blockIndex, values);
+
+		return blockIndex * BLOCK_SIZE + (std::lower_bound(values, values + BLOCK_SIZE, value) - values);
+	}
+
+	return m_Blocks.len() * BLOCK_SIZE + (std::lower_bound(m_Tail.begin(), m_Tail.begin() + m_TailCount, value) - m_Tail.begin());
+}
+
+template <typename T>
+size_t CompressedIntArray<T>::len() const
+{
+	return m_Blocks.len() * BLOCK_SIZE + m_TailCount;
+}
+
+template <typename T>
+bool CompressedIntArray<T>::isEmpty() const
+{
+	return len() == 0;
+}
+
+template <typename T>
+void CompressedIntArray<T>::clear()
+{
+	m_Words.clear();
+	m_Blocks.clear();
+	m_ExceptionPositions.clear();
+	m_ExceptionHighBits.clear();
+	m_TailCount = 0;
+}
+
+template <typename T>
+size_t CompressedIntArray<T>::sizeInBytes() const
+{
+	return m_Words.len() * sizeof(T) + m_Blocks.len() * sizeof(Block) + m_ExceptionPositions.len() * sizeof(uint8_t)
+		+ m_ExceptionHighBits.len() * sizeof(T) + m_TailCount * sizeof(T);
+}
+
+template <typename T>
+void CompressedIntArray<T>::decode(DynamicArray<T>& out) const
+{
+	out.resize(len());
+	if (out.isEmpty()) return;
+
+	T* values = out.data();
+
+	for (size_t block = 0; block < m_Blocks.len(); ++block) {
+		decodeBlock(block, values + block * BLOCK_SIZE);
+	}
+
+	std::copy(m_Tail.begin(), m_Tail.begin() + m_TailCount, values + m_Blocks.len() * BLOCK_SIZE);
+}
+
+template <typename T>
+DynamicArray<T> CompressedIntArray<T>::toArray() const
+{
+	DynamicArray<T> values;
+	decode(values);
+
+	return values;
+}
+
+template <typename T>
+void CompressedIntArray<T>::packTail()
+{
+	T minGap = m_Tail[1] - m_Tail[0];
+
+	for (size_t i = 2; i < BLOCK_SIZE; ++i) {
+		minGap = std::min(minGap, m_Tail[i] - m_Tail[i - 1]);
+	}
+
+	// count how many gaps need each bit width, slot 0 is left empty as the first value is stored in the block
+	std::array<size_t, WORD_BITS + 1> widthCounts = {};
+	for (size_t i = 1; i < BLOCK_SIZE; ++i) {
+		++widthCounts[std::bit_width(m_Tail[i] - m_Tail[i - 1] - minGap)];
+	}
+
+	// pick the bit width which makes the block smallest, every gap wider than it becomes an exception
+	size_t bitWidth = WORD_BITS, wider = 0, bestSize = BLOCK_SIZE * WORD_BITS;
+	for (size_t width = WORD_BITS; width-- > 0;) {
+		wider += widthCounts[width + 1];
+
+		const size_t size = BLOCK_SIZE * width + wider * EXCEPTION_BITS;
+		if (size <= bestSize) {
+			bitWidth = width;
+			bestSize = size;
+		}
+	}
+
+	Block block;
+	block.first = m_Tail[0];
+	block.last = m_Tail[BLOCK_SIZE - 1];
+	block.minGap = minGap;
+	block.offset = m_Words.len();
+	block.exceptionOffset = m_ExceptionPositions.len();
+	block.bitWidth = static_cast<uint8_t>(bitWidth);
+
+	if (block.bitWidth != 0) {
+		const size_t wordCount = m_Words.len() + block.bitWidth * WORDS_PER_BIT;
+
+		// resize only reserves exactly what it needs, so grow geometrically here to keep appends amortised constant
+		if (wordCount > m_Words.capacity()) {
+			m_Words.reserve(std::max(wordCount, m_Words.capacity() * 2));
+		}
+		m_Words.resize(wordCount, 0);
+	}
+
+	T* words = m_Words.data() + block.offset;
+	const T mask = block.bitWidth == WORD_BITS ? T(~T(0)) : T((T(1) << block.bitWidth) - 1);
+
+	for (size_t i = 1; i < BLOCK_SIZE; ++i) {
+		const T gap = m_Tail[i] - m_Tail[i - 1] - minGap;
+
+		if (block.bitWidth < WORD_BITS && (gap >> block.bitWidth) != 0) {
+			m_ExceptionPositions.append(static_cast<uint8_t>(i));
+			m_ExceptionHighBits.append(gap >> block.bitWidth);
+			++block.exceptionCount;
+		}
+
+		if (block.bitWidth == 0) continue;
+
+		// gap i goes to lane i % LANES, at position i / LANES of that lane's bit stream
+		const size_t lane = i % LANES, bit = i / LANES * block.bitWidth, word = bit / WORD_BITS, shift = bit % WORD_BITS;
+		const T packed = gap & mask;
+
+		words[word * LANES + lane] |= packed << shift;
+		if (shift + block.bitWidth > WORD_BITS) {
+			words[(word + 1) * LANES + lane] |= packed >> (WORD_BITS - shift);
+		}
+	}
+
+	m_Blocks.append(block);
+	m_TailCount = 0;
+}
+
+template <typename T>
+T CompressedIntArray<T>::unpackGap(const Block& block, size_t index) const
+{
+	const T* words = m_Words.data() + block.offset;
+	const size_t lane = index % LANES, bit = index / LANES * block.bitWidth, word = bit / WORD_BITS, shift = bit % WORD_BITS;
+
+	T packed = words[word * LANES + lane] >> shift;
+	if (shift + block.bitWidth > WORD_BITS) {
+		packed |= words[(word + 1) * LANES + lane] << (WORD_BITS - shift);
+	}
+
+	const T mask = block.bitWidth == WORD_BITS ? T(~T(0)) : T((T(1) << block.bitWidth) - 1);
+
+	return packed & mask;
+}
+
+template <typename T>
+void CompressedIntArray<T>::unpackGaps(const Block& block, T* out) const
+{
+#ifdef COMPRESSED_INT_ARRAY_SSE2
+	// every lane of a vector is at the same bit offset in its own stream, so one shift unpacks a whole vector of gaps
+	const __m128i* words = reinterpret_cast<const __m128i*>(m_Words.data() + block.offset);
+	const size_t width = block.bitWidth;
+
+	const __m128i minGap = sizeof(T) == 4 ? _mm_set1_epi32(static_cast<int>(block.minGap)) : _mm_set1_epi64x(static_cast<long long>(block.minGap));
+	const __m128i mask = width == WORD_BITS ? _mm_set1_epi32(-1)
+		: sizeof(T) == 4 ? _mm_set1_epi32(static_cast<int>((uint32_t(1) << width) - 1)) : _mm_set1_epi64x(static_cast<long long>((uint64_t(1) << width) - 1));
+
+	for (size_t i = 0; i < BLOCK_SIZE / LANES; ++i) {
+		const size_t bit = i * width, word = bit / WORD_BITS, shift = bit % WORD_BITS;
+
+		__m128i packed;
+
+		if constexpr (sizeof(T) == 4) {
+			packed = _mm_srl_epi32(_mm_loadu_si128(words + word), _mm_cvtsi32_si128(static_cast<int>(shift)));
+			if (shift + width > WORD_BITS) {
+				packed = _mm_or_si128(packed, _mm_sll_epi32(_mm_loadu_si128(words + word + 1), _mm_cvtsi32_si128(static_cast<int>(WORD_BITS - shift))));
+			}
+			packed = _mm_add_epi32(_mm_and_si128(packed, mask), minGap);
+		} else {
+			packed = _mm_srl_epi64(_mm_loadu_si128(words + word), _mm_cvtsi32_si128(static_cast<int>(shift)));
+			if (shift + width > WORD_BITS) {
+				packed = _mm_or_si128(packed, _mm_sll_epi64(_mm_loadu_si128(words + word + 1), _mm_cvtsi32_si128(static_cast<int>(WORD_BITS - shift))));
+			}
+			packed = _mm_add_epi64(_mm_and_si128(packed, mask), minGap);
+		}
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * LANES), packed);
+	}
+#else
+	for (size_t i = 1; i < BLOCK_SIZE; ++i) {
+		out[i] = block.minGap + unpackGap(block, i);
+	}
+#endif
+}
+
+template <typename T>
+void CompressedIntArray<T>::decodeBlock(size_t blockIndex, T* out) const
+{
+	const Block& block = m_Blocks[blockIndex];
+
+	// turn the block back into first value followed by gaps, then a prefix sum turns the gaps into values
+	if (block.bitWidth == 0) {
+		std::fill(out + 1, out + BLOCK_SIZE, block.minGap);
+	} else {
+		unpackGaps(block, out);
+	}
+
+	for (size_t i = 0; i < block.exceptionCount; ++i) {
+		out[m_ExceptionPositions[block.exceptionOffset + i]] += m_ExceptionHighBits[block.exceptionOffset + i] << block.bitWidth;
+	}
+
+	out[0] = block.first;
+
+	prefixSum(out);
+}
+
+template <typename T>
+void CompressedIntArray<T>::prefixSum(T* values)
+{
+#ifdef COMPRESSED_INT_ARRAY_SSE2
+	// each vector is summed in register with two shifted adds, then the running total of the previous vector is added on
+	__m128i carry = _mm_setzero_si128();
+
+	for (size_t i = 0; i < BLOCK_SIZE; i += 16 / sizeof(T)) {
+		__m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+
+		if constexpr (sizeof(T) == 4) {
+			x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+			x = _mm_add_epi32(x, _mm_slli_si128(x, 8));
+			x = _mm_add_epi32(x, carry);
+			carry = _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 3, 3));
+		} else {
+			x = _mm_add_epi64(x, _mm_slli_si128(x, 8));
+			x = _mm_add_epi64(x, carry);
+			carry = _mm_unpackhi_epi64(x, x);
+		}
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(values + i), x);
+	}
+#else
+	for (size_t i = 1; i < BLOCK_SIZE; ++i) {
+		values[i] += values[i - 1];
+	}
+#endif
+}
@@ -0,0 +1,310 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#include "DynamicArray.h"
+
+/**
+ * @brief A grow-only array which many threads can append to at once without locking.
+ * Elements live in a directory of segments which double in size, so an appended element never moves.
+ * Segments are allocated lazily and published with a compare-and-swap, aligned to T.
+ * Each segment also holds a flag per element which is set once the element is constructed. An append whose copy throws
+ * gives its position back when no later append has claimed one, and otherwise leaves a gap which is never read or destroyed.
+ * @tparam T Datatype of array.
+ */
+template <typename T>
+class ConcurrentAppendArray
+{
+private:
+	// the first segment holds 2^FIRST_SEGMENT_BITS elements, each following segment twice as many as the last
+	static constexpr size_t FIRST_SEGMENT_BITS = 5;
+	static constexpr size_t FIRST_SEGMENT_SIZE = size_t(1) << FIRST_SEGMENT_BITS;
+	static constexpr size_t MAX_SEGMENTS = sizeof(size_t) * 8 - FIRST_SEGMENT_BITS;
+	static constexpr size_t SEGMENT_ALIGNMENT = std::max(alignof(T), alignof(std::max_align_t));
+
+	// keep the contended counter on its own cache line so appends do not invalidate the directory
+	alignas(64) std::atomic<size_t> m_Count = 0;
+	alignas(64) std::array<std::atomic<T*>, MAX_SEGMENTS> m_Segments = {};
+
+	static size_t segmentOf(size_t pos);
+	static size_t segmentSize(size_t segment);
+	static size_t segmentStart(size_t segment);
+	static size_t segmentBytes(size_t segment);
+	static std::atomic<bool>* constructedFlags(T* data, size_t segment);
+
+	static T* allocSegment(size_t segment);
+	static void freeSegment(T* data);
+
+	T* acquireSegment(size_t segment);
+	void abandon(size_t pos);
+
+public:
+	/**
+	 * @brief Construct an empty concurrent append array.
+	 */
+	ConcurrentAppendArray() = default;
+
+	ConcurrentAppendArray(const ConcurrentAppendArray<T>& other) = delete;
+	ConcurrentAppendArray<T>& operator=(const ConcurrentAppendArray<T>& other) = delete;
+
+	~ConcurrentAppendArray();
+
+	/**
+	 * @brief Append an element to the end of the array. Safe to call from any number of threads at once.
+	 * If copying the element throws, the exception is rethrown and the element is not part of the array.
+	 * @param element Element to add.
+	 * @returns Position the element was stored at.
+	 */
+	size_t append(const T& element);
+
+	/**
+	 * @brief Returns the number of elements appended so far.
+	 * Elements still being appended by other threads are included in the count, as are gaps left by appends which threw
+	 * while a later append was already under way.
+	 * @returns Number of elements in the array.
+	 */
+	[[nodiscard]] size_t len() const;
+
+	/**
+	 * @brief Returns whether the array is empty or not.
+	 * @returns If the array is empty or not.
+	 */
+	[[nodiscard]] bool isEmpty() const;
+
+	/**
+	 * @brief Returns a reference to the element at the given position.
+	 * The append which stored the element must have returned before it is read.
+	 * @param pos Position of element to return.
+	 * @return Reference to the element at the given position.
+	 */
+	[[nodiscard]] T& at(size_t pos);
+
+	/**
+	 * @brief Returns a constant reference to the element at the given position.
+	 * The append which stored the element must have returned before it is read.
+	 * @param pos Position of element to return.
+	 * @return Constant reference to the element at the given position.
+	 */
+	[[nodiscard]] const T& at(size_t pos) const;
+
+	/**
+	 * @brief Returns a reference to the element at the given position.
+	 * @param pos Position of element to return.
+	 * @return Reference to the element at the given position.
+	 */
+	[[nodiscard]] T& operator[](size_t pos);
+
+	/**
+	 * @brief Returns a constant reference to the element at the given position.
+	 * @param pos Position of element to return.
+	 * @return Constant reference to the element at the given position.
+	 */
+	[[nodiscard]] const T& operator[](size_t pos) const;
+
+	/**
+	 * @brief Copy every element into a single contiguous dynamic array.
+	 * Every producer must have finished appending before the array is frozen. Gaps left by appends which threw are skipped.
+	 * @returns A dynamic array holding every element in order of position.
+	 */
+	[[nodiscard]] DynamicArray<T> freeze() const;
+};
+
+template <typename T>
+ConcurrentAppendArray<T>::~ConcurrentAppendArray()
+{
+	const size_t count = m_Count.load(std::memory_order_acquire);
+
+	for (size_t segment = 0; segment < MAX_SEGMENTS; ++segment) {
+		T* data = m_Segments[segment].load(std::memory_order_acquire);
+		if (data == nullptr) continue;
+
+		const std::atomic<bool>* constructed = constructedFlags(data, segment);
+		const size_t start = segmentStart(segment);
+		const size_t end = std::min(start + segmentSize(segment), count);
+
+		for (size_t pos = start; pos < end; ++pos) {
+			if (constructed[pos - start].load(std::memory_order_acquire)) data[pos - start].~T();
+		}
+
+		freeSegment(data);
+	}
+}
+
+template <typename T>
+size_t ConcurrentAppendArray<T>::segmentOf(size_t pos)
+{
+	return std::bit_width(pos + FIRST_SEGMENT_SIZE) - 1 - FIRST_SEGMENT_BITS;
+}
+
+template <typename T>
+size_t ConcurrentAppendArray<T>::segmentSize(size_t segment)
+{
+	return FIRST_SEGMENT_SIZE << segment;
+}
+
+template <typename T>
+size_t ConcurrentAppendArray<T>::segmentStart(size_t segment)
+{
+	return segmentSize(segment) - FIRST_SEGMENT_SIZE;
+}
+
+template <typename T>
+size_t ConcurrentAppendArray<T>::segmentBytes(size_t segment)
+{
+	// the elements are followed by their constructed flags, rounded up to the alignment as aligned_alloc requires
+	const size_t bytes = segmentSize(segment) * (sizeof(T) + sizeof(std::atomic<bool>));
+	return (bytes + SEGMENT_ALIGNMENT - 1) & ~(SEGMENT_ALIGNMENT - 1);
+}
+
+template <typename T>
+std::atomic<bool>* ConcurrentAppendArray<T>::constructedFlags(T* data, size_t segment)
+{
+	return reinterpret_cast<std::atomic<bool>*>(data + segmentSize(segment));
+}
+
+template <typename T>
+T* ConcurrentAppendArray<T>::allocSegment(size_t segment)
+{
+#ifdef _WIN32
+	T* data = static_cast<T*>(_aligned_malloc(segmentBytes(segment), SEGMENT_ALIGNMENT));
+#else
+	T* data = static_cast<T*>(std::aligned_alloc(SEGMENT_ALIGNMENT, segmentBytes(segment)));
+#endif
+	if (data == nullptr) throw std::bad_alloc();
+
+	std::atomic<bool>* constructed = constructedFlags(data, segment);
+	for (size_t i = 0; i < segmentSize(segment); ++i) {
+		new (&constructed[i]) std::atomic<bool>(false);
+	}
+
+	return data;
+}
+
+template <typename T>
+void ConcurrentAppendArray<T>::freeSegment(T* data)
+{
+#ifdef _WIN32
+	_aligned_free(data);
+#else
+	free(data);
+#endif
+}
+
+template <typename T>
+T* ConcurrentAppendArray<T>::acquireSegment(size_t segment)
+{
+	T* data = m_Segments[segment].load(std::memory_order_acquire);
+	if (data != nullptr) return data;
+
+	// several threads may race to allocate the same segment, only one of them gets to publish it
+	T* fresh = allocSegment(segment);
+
+	if (m_Segments[segment].compare_exchange_strong(data, fresh, std::memory_order_acq_rel, std::memory_order_acquire)) {
+		return fresh;
+	}
+
+	freeSegment(fresh);
+	return data;
+}
+
+template <typename T>
+void ConcurrentAppendArray<T>::abandon(size_t pos)
+{
+	// only the newest position can be handed back, otherwise it stays a gap with its constructed flag clear
+	size_t expected = pos + 1;
+	m_Count.compare_exchange_strong(expected, pos, std::memory_order_relaxed);
+}
+
+template <typename T>
+size_t ConcurrentAppendArray<T>::append(const T& element)
+{
+	const size_t pos = m_Count.fetch_add(1, std::memory_order_relaxed);
+	const size_t segment = segmentOf(pos);
+	const size_t offset = pos - segmentStart(segment);
+
+	T* data;
+
+	try {
+		data = acquireSegment(segment);
+		new (&data[offset]) T(element);
+	} catch (...) {
+		abandon(pos);
+		throw;
+	}
+
+	constructedFlags(data, segment)[offset].store(true, std::memory_order_release);
+
+	return pos;
+}
+
+template <typename T>
+size_t ConcurrentAppendArray<T>::len() const
+{
+	return m_Count.load(std::memory_order_acquire);
+}
+
+template <typename T>
+bool ConcurrentAppendArray<T>::isEmpty() const
+{
+	return len() == 0;
+}
+
+template <typename T>
+T& ConcurrentAppendArray<T>::at(size_t pos)
+{
+	ASSERT(pos < len(), "Array index out of bounds!");
+
+	const size_t segment = segmentOf(pos);
+	return m_Segments[segment].load(std::memory_order_acquire)[pos - segmentStart(segment)];
+}
+
+template <typename T>
+const T& ConcurrentAppendArray<T>::at(size_t pos) const
+{
+	ASSERT(pos < len(), "Array index out of bounds!");
+
+	const size_t segment = segmentOf(pos);
+	return m_Segments[segment].load(std::memory_order_acquire)[pos - segmentStart(segment)];
+}
+
+template <typename T>
+T& ConcurrentAppendArray<T>::operator[](size_t pos)
+{
+	return at(pos);
+}
+
+template <typename T>
+const T& ConcurrentAppendArray<T>::operator[](size_t pos) const
+{
+	return at(pos);
+}
+
+template <typename T>
+DynamicArray<T> ConcurrentAppendArray<T>::freeze() const
+{
+	const size_t count = len();
+
+	DynamicArray<T> frozen;
+	frozen.reserve(count);
+
+	// walk segment by segment so only one directory lookup is made per segment
+	for (size_t segment = 0; segmentStart(segment) < count; ++segment) {
+		T* data = m_Segments[segment].load(std::memory_order_acquire);
+		if (data == nullptr) continue;
+
+		const std::atomic<bool>* constructed = constructedFlags(data, segment);
+		const size_t segmentCount = std::min(segmentSize(segment), count - segmentStart(segment));
+
+		for (size_t i = 0; i < segmentCount; ++i) {
+			if (constructed[i].load(std::memory_order_acquire)) frozen.append(data[i]);
+		}
+	}
+
+	return frozen;
+}
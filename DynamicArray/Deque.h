@@ -0,0 +1,450 @@
+#pragma once
+
+#include <bit>
+#include <new>
+#include <span>
+#include <utility>
+
+#include "DynamicArray.h"
+
+/**
+ * @brief A double ended queue stored in a growable circular buffer.
+ * The buffer is a power of two in size, so positions wrap with a mask instead of a division,
+ * and pushing or popping at either end is amortised constant time. The elements are always
+ * at most two contiguous runs of the buffer, which spans exposes directly.
+ * @tparam T Datatype of deque.
+ */
+template <typename T>
+class Deque
+{
+private:
+	// raw storage so the buffer can sit in a dynamic array without every slot being constructed
+	struct Slot
+	{
+		alignas(T) unsigned char storage[sizeof(T)];
+	};
+
+	static constexpr size_t MIN_CAPACITY = 8;
+
+	DynamicArray<Slot> m_Slots;
+	size_t m_Head = 0, m_Count = 0;
+
+	[[nodiscard]] T* slotAt(size_t index) const;
+	void grow(size_t capacity);
+	void destroyElements();
+
+public:
+	/**
+	 * @brief Construct an empty deque.
+	 */
+	Deque() = default;
+
+	/**
+	 * @brief Copy a deque into another deque.
+	 * @param other The deque to copy from.
+	 */
+	Deque(const Deque<T>& other);
+
+	/**
+	 * @brief Copy a deque into another deque.
+	 * @param other The deque to copy from.
+	 * @returns A copy of the given deque.
+	 */
+	Deque<T>& operator=(const Deque<T>& other);
+
+	/**
+	 * @brief Move a deque into another deque.
+	 * @param other The deque to move from.
+	 */
+	Deque(Deque<T>&& other) noexcept;
+
+	/**
+	 * @brief Move a deque into another deque.
+	 */
+	Deque<T>& operator=(Deque<T>&& other) noexcept;
+
+	~Deque();
+
+	/**
+	 * @brief Add an element to the back of the deque.
+	 * @param element Element to add.
+	 */
+	void pushBack(const T& element);
+
+	/**
+	 * @brief Add an element to the back of the deque by moving it.
+	 * @param element Element to add.
+	 */
+	void pushBack(T&& element);
+
+	/**
+	 * @brief Add an element to the front of the deque.
+	 * @param element Element to add.
+	 */
+	void pushFront(const T& element);
+
+	/**
+	 * @brief Add an element to the front of the deque by moving it.
+	 * @param element Element to add.
+	 */
+	void pushFront(T&& element);
+
+	/**
+	 * @brief Remove and return the element at the back of the deque.
+	 * @returns Element at the back of the deque.
+	 */
+	T popBack();
+
+	/**
+	 * @brief Remove and return the element at the front of the deque.
+	 * @returns Element at the front of the deque.
+	 */
+	T popFront();
+
+	/**
+	 * @brief Returns a reference to the element at the front of the deque.
+	 * @returns Reference to the front element.
+	 */
+	[[nodiscard]] T& front();
+
+	/**
+	 * @brief Returns a reference to the element at the back of the deque.
+	 * @returns Reference to the back element.
+	 */
+	[[nodiscard]] T& back();
+
+	/**
+	 * @brief Returns a reference to the element at the given position from the front.
+	 * @param pos Position of element to return.
+	 * @return Reference to the element at the given position.
+	 */
+	[[nodiscard]] T& at(size_t pos);
+
+	/**
+	 * @brief Returns a constant reference to the element at the given position from the front.
+	 * @param pos Position of element to return.
+	 * @return Constant reference to the element at the given position.
+	 */
+	[[nodiscard]] const T& at(size_t pos) const;
+
+	/**
+	 * @brief Returns a reference to the element at the given position from the front.
+	 * @param pos Position of element to return.
+	 * @return Reference to the element at the given position.
+	 */
+	[[nodiscard]] T& operator[](size_t pos);
+
+	/**
+	 * @brief Returns a constant reference to the element at the given position from the front.
+	 * @param pos Position of element to return.
+	 * @return Constant reference to the element at the given position.
+	 */
+	[[nodiscard]] const T& operator[](size_t pos) const;
+
+	/**
+	 * @brief Returns the elements as two contiguous views, front to back.
+	 * The first runs from the front element towards the end of the buffer, the second holds whatever wrapped around
+	 * to the start of the buffer, and is empty if nothing did.
+	 * @returns The two views, in order.
+	 */
+	[[nodiscard]] std::pair<std::span<T>, std::span<T>> spans();
+
+	/**
+	 * @brief Returns the elements as two contiguous constant views, front to back.
+	 * @returns The two views, in order.
+	 */
+	[[nodiscard]] std::pair<std::span<const T>, std::span<const T>> spans() const;
+
+	/**
+	 * @brief Reserve memory for at least a given number of elements.
+	 * @param count Number of elements to allocate memory for.
+	 */
+	void reserve(size_t count);
+
+	/**
+	 * @brief Clear every element in the deque, keeping its memory.
+	 */
+	void clear();
+
+	/**
+	 * @brief Returns the number of elements in the deque.
+	 * @returns Number of elements in the deque.
+	 */
+	[[nodiscard]] size_t len() const;
+
+	/**
+	 * @brief Returns whether the deque is empty or not.
+	 * @returns If the deque is empty or not.
+	 */
+	[[nodiscard]] bool isEmpty() const;
+
+	/**
+	 * @brief Returns the number of elements the deque can hold before it has to grow.
+	 * @returns Size of the circular buffer.
+	 */
+	[[nodiscard]] size_t capacity() const;
+};
+
+template <typename T>
+Deque<T>::Deque(const Deque<T>& other)
+{
+	reserve(other.m_Count);
+
+	for (size_t i = 0; i < other.m_Count; ++i) {
+		new (slotAt(i)) T(other[i]);
+	}
+	m_Count = other.m_Count;
+}
+
+template <typename T>
+Deque<T>& Deque<T>::operator=(const Deque<T>& other)
+{
+	if (this == &other) return *this;
+
+	clear();
+	reserve(other.m_Count);
+
+	for (size_t i = 0; i < other.m_Count; ++i) {
+		new (slotAt(i)) T(other[i]);
+	}
+	m_Count = other.m_Count;
+
+	return *this;
+}
+
+template <typename T>
+Deque<T>::Deque(Deque<T>&& other) noexcept :
+	m_Slots(std::move(other.m_Slots)), m_Head(other.m_Head), m_Count(other.m_Count)
+{
+	other.m_Head = other.m_Count = 0;
+}
+
+template <typename T>
+Deque<T>& Deque<T>::operator=(Deque<T>&& other) noexcept
+{
+	if (this == &other) return *this;
+
+	destroyElements();
+
+	m_Slots = std::move(other.m_Slots);
+	m_Head = other.m_Head;
+	m_Count = other.m_Count;
+
+	other.m_Head = other.m_Count = 0;
+
+	return *this;
+}
+
+template <typename T>
+Deque<T>::~Deque()
+{
+	destroyElements();
+}
+
+template <typename T>
+T* Deque<T>::slotAt(size_t index) const
+{
+	// the capacity is a power of two, so wrapping is a mask
+	return std::launder(reinterpret_cast<T*>(m_Slots.data()[index & (m_Slots.len() - 1)].storage));
+}
+
+template <typename T>
+void Deque<T>::grow(size_t capacity)
+{
+	DynamicArray<Slot> slots;
+	slots.resize(capacity);
+
+	// unwrap the elements to the start of the new buffer
+	for (size_t i = 0; i < m_Count; ++i) {
+		T* element = slotAt(m_Head + i);
+
+		new (slots.data()[i].storage) T(std::move(*element));
+		element->~T();
+	}
+
+	m_Slots = std::move(slots);
+	m_Head = 0;
+}
+
+template <typename T>
+void Deque<T>::destroyElements()
+{
+	for (size_t i = 0; i < m_Count; ++i) {
+		slotAt(m_Head + i)->~T();
+	}
+}
+
+template <typename T>
+void Deque<T>::pushBack(const T& element)
+{
+	// the element may live in this deque, so copy it before growing moves it
+	pushBack(T(element));
+}
+
+template <typename T>
+void Deque<T>::pushBack(T&& element)
+{
+	if (m_Count == m_Slots.len()) {
+		T moved(std::move(element));
+		grow(m_Slots.isEmpty() ? MIN_CAPACITY : m_Slots.len() * 2);
+
+		new (slotAt(m_Head + m_Count)) T(std::move(moved));
+		++m_Count;
+		return;
+	}
+
+	new (slotAt(m_Head + m_Count)) T(std::move(element));
+	++m_Count;
+}
+
+template <typename T>
+void Deque<T>::pushFront(const T& element)
+{
+	pushFront(T(element));
+}
+
+template <typename T>
+void Deque<T>::pushFront(T&& element)
+{
+	if (m_Count == m_Slots.len()) {
+		T moved(std::move(element));
+		grow(m_Slots.isEmpty() ? MIN_CAPACITY : m_Slots.len() * 2);
+
+		m_Head = (m_Head - 1) & (m_Slots.len() - 1);
+		new (slotAt(m_Head)) T(std::move(moved));
+		++m_Count;
+		return;
+	}
+
+	// unsigned wrap around below zero is masked back into the buffer
+	m_Head = (m_Head - 1) & (m_Slots.len() - 1);
+	new (slotAt(m_Head)) T(std::move(element));
+	++m_Count;
+}
+
+template <typename T>
+T Deque<T>::popBack()
+{
+	ASSERT(m_Count != 0, "Cannot pop value from empty deque!");
+
+	T* element = slotAt(m_Head + m_Count - 1);
+	T value = std::move(*element);
+
+	element->~T();
+	--m_Count;
+
+	return value;
+}
+
+template <typename T>
+T Deque<T>::popFront()
+{
+	ASSERT(m_Count != 0, "Cannot pop value from empty deque!");
+
+	T* element = slotAt(m_Head);
+	T value = std::move(*element);
+
+	element->~T();
+	m_Head = (m_Head + 1) & (m_Slots.len() - 1);
+	--m_Count;
+
+	return value;
+}
+
+template <typename T>
+T& Deque<T>::front()
+{
+	ASSERT(m_Count != 0, "Cannot get front of empty deque!");
+
+	return *slotAt(m_Head);
+}
+
+template <typename T>
+T& Deque<T>::back()
+{
+	ASSERT(m_Count != 0, "Cannot get back of empty deque!");
+
+	return *slotAt(m_Head + m_Count - 1);
+}
+
+template <typename T>
+T& Deque<T>::at(size_t pos)
+{
+	ASSERT(pos < m_Count, "Deque index out of bounds!");
+
+	return *slotAt(m_Head + pos);
+}
+
+template <typename T>
+const T& Deque<T>::at(size_t pos) const
+{
+	ASSERT(pos < m_Count, "Deque index out of bounds!");
+
+	return *slotAt(m_Head + pos);
+}
+
+template <typename T>
+T& Deque<T>::operator[](size_t pos)
+{
+	return at(pos);
+}
+
+template <typename T>
+const T& Deque<T>::operator[](size_t pos) const
+{
+	return at(pos);
+}
+
+template <typename T>
+std::pair<std::span<T>, std::span<T>> Deque<T>::spans()
+{
+	if (m_Count == 0) return {};
+
+	const size_t firstCount = std::min(m_Count, m_Slots.len() - m_Head);
+
+	return { std::span<T>(slotAt(m_Head), firstCount), std::span<T>(slotAt(0), m_Count - firstCount) };
+}
+
+template <typename T>
+std::pair<std::span<const T>, std::span<const T>> Deque<T>::spans() const
+{
+	if (m_Count == 0) return {};
+
+	const size_t firstCount = std::min(m_Count, m_Slots.len() - m_Head);
+
+	return { std::span<const T>(slotAt(m_Head), firstCount), std::span<const T>(slotAt(0), m_Count - firstCount) };
+}
+
+template <typename T>
+void Deque<T>::reserve(size_t count)
+{
+	if (count <= m_Slots.len()) return;
+
+	grow(std::max(MIN_CAPACITY, std::bit_ceil(count)));
+}
+
+template <typename T>
+void Deque<T>::clear()
+{
+	destroyElements();
+
+	m_Head = m_Count = 0;
+}
+
+template <typename T>
+size_t Deque<T>::len() const
+{
+	return m_Count;
+}
+
+template <typename T>
+bool Deque<T>::isEmpty() const
+{
+	return m_Count == 0;
+}
+
+template <typename T>
+size_t Deque<T>::capacity() const
+{
+	return m_Slots.len();
+}
@@ -1,9 +1,17 @@
 #pragma once
 
 #include <algorithm>
+#include <bit>
+#include <cstdlib>
 #include <initializer_list>
 #include <iostream>
 #include <iterator>
+#include <memory>
+#include <new>
+#include <numeric>
+#include <span>
+#include <type_traits>
+#include <utility>
 #include <stdexcept>
 
 // if using msvc use debug breaks
@@ -20,6 +28,40 @@
 // toggle comment to toggle debug messages
 //#define DYNAMIC_ARRAY_DEBUG
 
+// toggle comment to record allocation and growth stats in the DynamicArrayStatsRegistry
+//#define DYNAMIC_ARRAY_STATS
+
+#ifdef DYNAMIC_ARRAY_STATS
+	#include "DynamicArrayStats.h"
+
+	// with stats on, constructors also take the call site they were called from, stats are kept per element type and call site
+	#define DYNAMIC_ARRAY_SITE_DEFAULT , const std::source_location& site = std::source_location::current()
+	#define DYNAMIC_ARRAY_SITE , const std::source_location& site
+#else
+	#define DYNAMIC_ARRAY_SITE_DEFAULT
+	#define DYNAMIC_ARRAY_SITE
+#endif
+
+#include "PageAllocation.h"
+
+// prefetch hints, these never fault so can be given any address
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	#include <xmmintrin.h>
+	#define DYNAMIC_ARRAY_PREFETCH_READ(address) _mm_prefetch(reinterpret_cast<const char*>(address), _MM_HINT_T0)
+	#define DYNAMIC_ARRAY_PREFETCH_WRITE(address) _mm_prefetch(reinterpret_cast<const char*>(address), _MM_HINT_T0)
+#elif defined(__GNUC__)
+	#define DYNAMIC_ARRAY_PREFETCH_READ(address) __builtin_prefetch((address), 0)
+	#define DYNAMIC_ARRAY_PREFETCH_WRITE(address) __builtin_prefetch((address), 1)
+#else
+	#define DYNAMIC_ARRAY_PREFETCH_READ(address)
+	#define DYNAMIC_ARRAY_PREFETCH_WRITE(address)
+#endif
+
+#ifdef __AVX2__
+	#define DYNAMIC_ARRAY_AVX2
+	#include <immintrin.h>
+#endif
+
 #define DATA_START m_Data
 #define DATA_END (m_Data + m_Count)
 
@@ -27,51 +69,91 @@
  * @brief A dynamically sized array template class.
  * @author Freddy Cansick
  * @date 26/5/2022
+ * @tparam T Datatype of array.
+ * @tparam Alignment Alignment in bytes of the internal data structure, defaults to a cache line.
  */
-template <typename T>
+template <typename T, size_t Alignment = 64>
 class DynamicArray
 {
+	static_assert(std::has_single_bit(Alignment) && Alignment >= alignof(T), "Alignment must be a power of two no smaller than the alignment of T.");
+	static_assert(Alignment <= HUGE_PAGE_SIZE, "Alignment cannot be larger than a huge page.");
+
 private:
 	size_t m_Count = 0, m_CountAlloced = 0;
 	T* m_Data = nullptr;
+	bool m_AutoShrink = true;
+
+	MemoryPlacement m_Placement;
+	bool m_PageBacked = false;
+
+#ifdef DYNAMIC_ARRAY_STATS
+	// where the array was constructed, its stats are looked up from this on the first allocation
+	std::source_location m_Site;
+	DynamicArrayStats* m_Stats = nullptr;
+
+	DynamicArrayStats& stats();
+#endif
 
 	T* allocNewArray(size_t count);
+	void freeArray();
+	void reallocate(size_t count);
+	[[nodiscard]] size_t paddedCapacity(size_t count) const;
+	void shrinkIfSparse();
 
 public:
+	/**
+	 * @brief Auto shrinking never takes the capacity below this many elements.
+	 */
+	static constexpr size_t MIN_AUTO_SHRINK_CAPACITY = 16;
+
+	/**
+	 * @brief The capacity is always a multiple of this many elements, so a whole number of aligned vectors fits in it.
+	 */
+	static constexpr size_t CAPACITY_STEP = Alignment / std::gcd(sizeof(T), Alignment);
+
+	/**
+	 * @brief How many positions ahead gather and scatter prefetch by default, enough to cover a DRAM access on current hardware.
+	 */
+	static constexpr size_t DEFAULT_PREFETCH_DISTANCE = 16;
+
 	/**
 	 * @brief Construct a dynamic array with a list of elements.
 	 * @param elements List of elements to construct array with.
 	*/
-	DynamicArray(const std::initializer_list<T>& elements);
+	DynamicArray(const std::initializer_list<T>& elements DYNAMIC_ARRAY_SITE_DEFAULT);
 
 	/**
 	 * @brief Construct an empty dynamic array.
 	*/
+#ifdef DYNAMIC_ARRAY_STATS
+	DynamicArray(const std::source_location& site = std::source_location::current());
+#else
 	DynamicArray() = default;
+#endif
 
 	/**
 	 * @brief Copy a dynamic array into another dynamic array.
 	 * @param other The array to copy from.
 	*/
-	DynamicArray(const DynamicArray<T>& other);
+	DynamicArray(const DynamicArray<T, Alignment>& other DYNAMIC_ARRAY_SITE_DEFAULT);
 
 	/**
 	 * @brief Copy a dynamic array into another dynamic array.
 	 * @param other The array to copy from.
 	 * @returns A copy of the given array.
 	*/
-	DynamicArray<T>& operator=(const DynamicArray<T>& other);
+	DynamicArray<T, Alignment>& operator=(const DynamicArray<T, Alignment>& other);
 
 	/**
 	 * @brief Move a dynamic array into another dynamic array.
 	 * @param other The array to move from.
 	*/
-	DynamicArray(DynamicArray<T>&& other) noexcept;
+	DynamicArray(DynamicArray<T, Alignment>&& other) noexcept;
 
 	/**
 	 * @brief Move a dynamic array into another dynamic array.
 	 */
-	DynamicArray<T>& operator=(DynamicArray<T>&& other) noexcept;
+	DynamicArray<T, Alignment>& operator=(DynamicArray<T, Alignment>&& other) noexcept;
 
 	~DynamicArray();
 
@@ -81,6 +163,12 @@ public:
 	 */
 	void append(const T& element);
 
+	/**
+	 * @brief Append an element to the end of the array by moving it.
+	 * @param element Element to add.
+	 */
+	void append(T&& element);
+
 	/**
 	 * @brief Remove the first instance of an element in an array.
 	 * @param element Element to remove.
@@ -108,11 +196,38 @@ public:
 	T pop(size_t pos);
 
 	/**
-	 * @brief Reserve memory for a given number of elements.
+	 * @brief Reserve memory for at least a given number of elements.
+	 * Never shrinks the array, use shrinkToFit to release memory.
 	 * @param count Number of elements to allocate memory for.
 	 */
 	void reserve(size_t count);
 
+	/**
+	 * @brief Change the number of elements in the array, filling any new elements with a given value.
+	 * @param count Number of elements the array should hold.
+	 * @param value Value to fill new elements with.
+	 */
+	void resize(size_t count, const T& value = T());
+
+	/**
+	 * @brief Release any memory not used by the elements in the array.
+	 */
+	void shrinkToFit();
+
+	/**
+	 * @brief Toggle halving the capacity whenever fewer than a quarter of it is in use.
+	 * Enabled by default. Growth doubles a full array, so the gap between the two thresholds stops repeated pushes and pops from reallocating every time.
+	 * @param autoShrink Whether to shrink the array automatically.
+	 */
+	void setAutoShrink(bool autoShrink);
+
+	/**
+	 * @brief Set the page size and NUMA placement used when the array needs more memory than the placement threshold.
+	 * Takes effect the next time the array allocates memory.
+	 * @param placement Placement of large allocations.
+	 */
+	void setPlacement(const MemoryPlacement& placement);
+
 	/**
 	 * @brief Clear every element in the array.
 	 */
@@ -131,6 +246,12 @@ public:
 	 */
 	[[nodiscard]] size_t len() const;
 
+	/**
+	 * @brief Returns the number of elements the array can hold before it has to grow.
+	 * @returns Number of elements memory is allocated for.
+	 */
+	[[nodiscard]] size_t capacity() const;
+
 	/**
 	 * @brief Returns the index of a given element in an array.
 	 * @param element Element to get index of.
@@ -173,221 +294,504 @@ public:
 	[[nodiscard]] const T& operator[](size_t pos) const;
 
 	/**
-	 * @brief Return a pointer to the internal data structure.
+	 * @brief Copy the elements at a list of positions into a buffer, so out[i] = arr[indices[i]].
+	 * Elements a prefetch distance ahead are requested early so their cache misses overlap instead of running one at a time.
+	 * With AVX2, 4 and 8 byte trivially copyable elements are loaded four at a time with vector gathers.
+	 * @param indices Positions of the elements to copy.
+	 * @param out Buffer of at least indices.size() elements to copy into.
+	 * @param prefetchDistance How many positions ahead to prefetch, 0 disables prefetching.
+	 */
+	void gather(std::span<const size_t> indices, T* out, size_t prefetchDistance = DEFAULT_PREFETCH_DISTANCE) const;
+
+	/**
+	 * @brief Copy a buffer of elements to a list of positions, so arr[indices[i]] = values[i].
+	 * Positions a prefetch distance ahead are prefetched for writing so their cache misses overlap.
+	 * @param indices Positions to copy the elements to.
+	 * @param values Buffer of at least indices.size() elements to copy from.
+	 * @param prefetchDistance How many positions ahead to prefetch, 0 disables prefetching.
+	 */
+	void scatter(std::span<const size_t> indices, const T* values, size_t prefetchDistance = DEFAULT_PREFETCH_DISTANCE);
+
+	/**
+	 * @brief Return a pointer to the internal data structure, aligned to Alignment bytes.
 	 * @returns A pointer to the internal data structure.
 	 */
 	[[nodiscard]] T* data() const;
 
-	template<typename T>
-	friend std::ostream& operator<<(std::ostream& os, const DynamicArray<T>& arr);
+	/**
+	 * @brief Returns the number of elements rounded up to a whole number of aligned vectors.
+	 * Vector loops can run up to this length without a scalar tail, the padding elements are uninitialised.
+	 * @returns Padded number of elements, never more than the capacity.
+	 */
+	[[nodiscard]] size_t paddedLen() const;
+
+	template<typename U, size_t A>
+	friend std::ostream& operator<<(std::ostream& os, const DynamicArray<U, A>& arr);
 };
 
-template <typename T>
-DynamicArray<T>::DynamicArray(const std::initializer_list<T>& elements) :
-	m_Count(elements.size()), m_CountAlloced(static_cast<size_t>(pow(2, ceil(log2(elements.size())))))
+template <typename T, size_t Alignment>
+DynamicArray<T, Alignment>::DynamicArray(const std::initializer_list<T>& elements DYNAMIC_ARRAY_SITE) :
+	m_Count(elements.size())
 {
+#ifdef DYNAMIC_ARRAY_STATS
+	m_Site = site;
+#endif
+
+	m_CountAlloced = paddedCapacity(std::bit_ceil(elements.size()));
+
 	m_Data = allocNewArray(m_CountAlloced);
+	m_PageBacked = m_Placement.usesPages(m_CountAlloced * sizeof(T));
 
-	std::copy(elements.begin(), elements.end(), m_Data);
+	std::uninitialized_copy(elements.begin(), elements.end(), m_Data);
 }
 
-template <typename T>
-DynamicArray<T>::~DynamicArray()
+template <typename T, size_t Alignment>
+DynamicArray<T, Alignment>::~DynamicArray()
 {
-#ifdef DYNAMIC_ARRAY_DEBUG
-	if (m_Data != nullptr) {
-		std::cout << "FREEING " << m_CountAlloced << " ELEMENTS (" << m_CountAlloced * sizeof(T) << " BYTES)" << std::endl;
-	}
-#endif
+	std::destroy(DATA_START, DATA_END);
+	freeArray();
+}
 
-	free(m_Data);
+#ifdef DYNAMIC_ARRAY_STATS
+template <typename T, size_t Alignment>
+DynamicArray<T, Alignment>::DynamicArray(const std::source_location& site) :
+	m_Site(site)
+{
 }
+#endif
 
-template<typename T>
-DynamicArray<T>::DynamicArray(const DynamicArray<T>& other) :
-	m_Count(other.m_Count), m_CountAlloced(other.m_CountAlloced)
+template<typename T, size_t Alignment>
+DynamicArray<T, Alignment>::DynamicArray(const DynamicArray<T, Alignment>& other DYNAMIC_ARRAY_SITE) :
+	m_Count(other.m_Count), m_CountAlloced(other.m_CountAlloced), m_AutoShrink(other.m_AutoShrink), m_Placement(other.m_Placement)
 {
+#ifdef DYNAMIC_ARRAY_STATS
+	m_Site = site;
+#endif
+
 	this->m_Data = allocNewArray(other.m_CountAlloced);
-	std::copy(other.m_Data, other.m_Data + other.m_Count, this->m_Data);
+	this->m_PageBacked = m_Placement.usesPages(other.m_CountAlloced * sizeof(T));
+	std::uninitialized_copy(other.m_Data, other.m_Data + other.m_Count, this->m_Data);
 }
 
-template<typename T>
-DynamicArray<T>& DynamicArray<T>::operator=(const DynamicArray<T>& other)
+template<typename T, size_t Alignment>
+DynamicArray<T, Alignment>& DynamicArray<T, Alignment>::operator=(const DynamicArray<T, Alignment>& other)
 {
+	if (this == &other) return *this;
+
+	std::destroy(DATA_START, DATA_END);
+	freeArray();
+
 	this->m_Count = other.m_Count;
 	this->m_CountAlloced = other.m_CountAlloced;
+	this->m_AutoShrink = other.m_AutoShrink;
+	this->m_Placement = other.m_Placement;
 
 	this->m_Data = allocNewArray(other.m_CountAlloced);
-	std::copy(other.m_Data, other.m_Data + other.m_Count, this->m_Data);
+	this->m_PageBacked = m_Placement.usesPages(other.m_CountAlloced * sizeof(T));
+	std::uninitialized_copy(other.m_Data, other.m_Data + other.m_Count, this->m_Data);
 
 	return *this;
 }
 
-template<typename T>
-DynamicArray<T>::DynamicArray(DynamicArray<T>&& other) noexcept :
-	m_Count(other.m_Count), m_CountAlloced(other.m_CountAlloced), m_Data(other.m_Data)
+template<typename T, size_t Alignment>
+DynamicArray<T, Alignment>::DynamicArray(DynamicArray<T, Alignment>&& other) noexcept :
+	m_Count(other.m_Count), m_CountAlloced(other.m_CountAlloced), m_Data(other.m_Data), m_AutoShrink(other.m_AutoShrink),
+	m_Placement(other.m_Placement), m_PageBacked(other.m_PageBacked)
 {
+#ifdef DYNAMIC_ARRAY_STATS
+	// the buffer keeps counting against the call site which allocated it
+	m_Site = other.m_Site;
+	m_Stats = other.m_Stats;
+#endif
+
 	other.m_Data = nullptr;
+	other.m_Count = other.m_CountAlloced = 0;
 }
 
-template<typename T>
-DynamicArray<T>& DynamicArray<T>::operator=(DynamicArray<T>&& other) noexcept
+template<typename T, size_t Alignment>
+DynamicArray<T, Alignment>& DynamicArray<T, Alignment>::operator=(DynamicArray<T, Alignment>&& other) noexcept
 {
+	if (this == &other) return *this;
+
+	std::destroy(DATA_START, DATA_END);
+	freeArray();
+
 	m_Count = other.m_Count;
 	m_CountAlloced = other.m_CountAlloced;
 	m_Data = other.m_Data;
+	m_AutoShrink = other.m_AutoShrink;
+	m_Placement = other.m_Placement;
+	m_PageBacked = other.m_PageBacked;
+
+#ifdef DYNAMIC_ARRAY_STATS
+	m_Site = other.m_Site;
+	m_Stats = other.m_Stats;
+#endif
 
 	other.m_Data = nullptr;
+	other.m_Count = other.m_CountAlloced = 0;
 
 	return *this;
 }
 
 
-template <typename T>
-void DynamicArray<T>::append(const T& element)
+template <typename T, size_t Alignment>
+void DynamicArray<T, Alignment>::append(const T& element)
 {
 	// if there is not enough memory allocated for new element
 	if (m_CountAlloced <= m_Count) {
 
-		m_CountAlloced *= 2;
-		reserve(m_CountAlloced);
+		// the element may live in this array, so copy it before the old memory is freed
+		T copy(element);
+		reserve(m_CountAlloced == 0 ? 1 : m_CountAlloced * 2);
+
+		new (DATA_END) T(std::move(copy));
+		++m_Count;
+		return;
 	}
 	
 	// add new element to array
-	m_Data[m_Count++] = element;
+	new (DATA_END) T(element);
+	++m_Count;
+}
+
+template <typename T, size_t Alignment>
+void DynamicArray<T, Alignment>::append(T&& element)
+{
+	if (m_CountAlloced <= m_Count) {
+
+		// the element may live in this array, so move it out before the old memory is freed
+		T moved(std::move(element));
+		reserve(m_CountAlloced == 0 ? 1 : m_CountAlloced * 2);
+
+		new (DATA_END) T(std::move(moved));
+		++m_Count;
+		return;
+	}
+
+	new (DATA_END) T(std::move(element));
+	++m_Count;
 }
 
-template<typename T>
-void DynamicArray<T>::remove(const T& element)
+template<typename T, size_t Alignment>
+void DynamicArray<T, Alignment>::remove(const T& element)
 {
 	if (const auto elementIt = std::find(DATA_START, DATA_END, element); elementIt == DATA_END) {
 		throw std::range_error("Cannot remove an element which is not in array.");
 	} else {
-		std::copy(elementIt + 1, DATA_END, elementIt);
+		std::move(elementIt + 1, DATA_END, elementIt);
 	}
 
 	--m_Count;
+	std::destroy_at(DATA_END);
+
+	shrinkIfSparse();
 }
 
-template<typename T>
-void DynamicArray<T>::clear()
+template<typename T, size_t Alignment>
+void DynamicArray<T, Alignment>::clear()
 {
+	std::destroy(DATA_START, DATA_END);
 	m_Count = 0;
+
+	shrinkIfSparse();
 }
 
-template<typename T>
-size_t DynamicArray<T>::count(const T& element) const
+template<typename T, size_t Alignment>
+size_t DynamicArray<T, Alignment>::count(const T& element) const
 {
 	if (m_Count == 0) return 0;
 
 	return std::count(DATA_START, DATA_END, element);
 }
 
-template<typename T>
-size_t DynamicArray<T>::len() const
+template<typename T, size_t Alignment>
+size_t DynamicArray<T, Alignment>::len() const
 {
 	return m_Count;
 }
 
-template<typename T>
-size_t DynamicArray<T>::index(const T& element) const
+template<typename T, size_t Alignment>
+size_t DynamicArray<T, Alignment>::capacity() const
+{
+	return m_CountAlloced;
+}
+
+template<typename T, size_t Alignment>
+size_t DynamicArray<T, Alignment>::index(const T& element) const
 {
 	return std::distance(DATA_START, std::find(DATA_START, DATA_END, element));
 }
 
-template<typename T>
-bool DynamicArray<T>::isEmpty() const
+template<typename T, size_t Alignment>
+bool DynamicArray<T, Alignment>::isEmpty() const
 {
 	return m_Count == 0;
 }
 
-template<typename T>
-void DynamicArray<T>::insert(size_t pos, const T& element)
+template<typename T, size_t Alignment>
+void DynamicArray<T, Alignment>::insert(size_t pos, const T& element)
 {
-	ASSERT(pos < m_Count, "Insert array index out of bounds!");
+	ASSERT(pos <= m_Count, "Insert array index out of bounds!");
+
+	if (pos == m_Count) {
+		append(element);
+		return;
+	}
+
+	// the element may live in this array, so copy it before anything is shifted or reallocated
+	T copy(element);
 
 	if (m_CountAlloced <= m_Count) {
 
-		m_CountAlloced *= 2;
-		reserve(m_CountAlloced);
+		reserve(m_CountAlloced == 0 ? 1 : m_CountAlloced * 2);
 	}
 
-	// shift data after given element 1 to the right
-	std::copy(DATA_START + pos, DATA_END, DATA_START + pos + 1);
-	m_Data[pos] = element;
+	// shift data after given element 1 to the right, the last element moves into uninitialised memory
+	new (DATA_END) T(std::move(m_Data[m_Count - 1]));
+	std::move_backward(DATA_START + pos, DATA_END - 1, DATA_END);
+	m_Data[pos] = std::move(copy);
 
 	++m_Count;
 }
 
-template<typename T>
-T DynamicArray<T>::pop()
+template<typename T, size_t Alignment>
+T DynamicArray<T, Alignment>::pop()
 {
 	ASSERT(m_Count != 0, "Cannot pop value from empty array!");
 
-	const auto& element = m_Data[m_Count - 1];
-	remove(element);
-	
-	return element;
+	return pop(m_Count - 1);
 }
 	
-template<typename T>
-T DynamicArray<T>::pop(size_t pos)
+template<typename T, size_t Alignment>
+T DynamicArray<T, Alignment>::pop(size_t pos)
 {
 	ASSERT(m_Count != 0, "Cannot pop value from empty array!");
 	ASSERT(pos < m_Count, "Array index out of bounds!");
 
-	const auto& element = m_Data[pos];
-	remove(element);
-	
+	// move the element out before shifting, as shrinking may free the memory it lives in
+	T element = std::move(m_Data[pos]);
+
+	std::move(DATA_START + pos + 1, DATA_END, DATA_START + pos);
+	--m_Count;
+	std::destroy_at(DATA_END);
+
+	shrinkIfSparse();
+
 	return element;
 }
 
-template<typename T>
-void DynamicArray<T>::reserve(size_t count)
+template<typename T, size_t Alignment>
+void DynamicArray<T, Alignment>::reserve(size_t count)
+{
+	if (count <= m_CountAlloced) return;
+
+	reallocate(count);
+}
+
+template<typename T, size_t Alignment>
+void DynamicArray<T, Alignment>::resize(size_t count, const T& value)
+{
+	if (count <= m_Count) {
+		std::destroy(DATA_START + count, DATA_END);
+		m_Count = count;
+		shrinkIfSparse();
+		return;
+	}
+
+	if (count > m_CountAlloced) {
+		// the value may live in this array, so copy it before the old memory is freed
+		T copy(value);
+		reserve(count);
+
+		std::uninitialized_fill(DATA_END, DATA_START + count, copy);
+		m_Count = count;
+		return;
+	}
+
+	std::uninitialized_fill(DATA_END, DATA_START + count, value);
+	m_Count = count;
+}
+
+template<typename T, size_t Alignment>
+void DynamicArray<T, Alignment>::shrinkToFit()
+{
+	reallocate(m_Count);
+}
+
+template<typename T, size_t Alignment>
+void DynamicArray<T, Alignment>::setAutoShrink(bool autoShrink)
+{
+	m_AutoShrink = autoShrink;
+}
+
+template<typename T, size_t Alignment>
+void DynamicArray<T, Alignment>::setPlacement(const MemoryPlacement& placement)
+{
+	m_Placement = placement;
+}
+
+template<typename T, size_t Alignment>
+void DynamicArray<T, Alignment>::shrinkIfSparse()
 {
+	if (!m_AutoShrink) return;
+
+	size_t count = m_CountAlloced;
+
+	// halve until at least a quarter is in use, so clearing a large array releases it in one step
+	while (count / 2 >= MIN_AUTO_SHRINK_CAPACITY && m_Count < count / 4) {
+		count /= 2;
+	}
+
+	reallocate(count);
+}
+
+template<typename T, size_t Alignment>
+void DynamicArray<T, Alignment>::reallocate(size_t count)
+{
+	ASSERT(count >= m_Count, "Cannot reallocate array to fewer elements than it holds!");
+
+	count = paddedCapacity(count);
+
 	if (count == m_CountAlloced) return;
 
+	if (count == 0) {
+		freeArray();
+		m_CountAlloced = 0;
+		return;
+	}
+
 	T* tempArr = allocNewArray(count);
 
-	std::copy(DATA_START, DATA_END, tempArr);
+	std::uninitialized_move(DATA_START, DATA_END, tempArr);
+	std::destroy(DATA_START, DATA_END);
+
+#ifdef DYNAMIC_ARRAY_STATS
+	if (m_Data != nullptr) {
+		stats().recordReallocation(m_Count);
+	}
+#endif
 
-	free(m_Data);
+	freeArray();
 
 	m_Data = tempArr;
+	m_PageBacked = m_Placement.usesPages(count * sizeof(T));
 
 	m_CountAlloced = count;
 }
 
-template<typename T>
-T& DynamicArray<T>::at(size_t pos)
+template<typename T, size_t Alignment>
+size_t DynamicArray<T, Alignment>::paddedCapacity(size_t count) const
+{
+	// page backed memory comes in whole huge pages anyway, so make all of it usable
+	if (m_Placement.usesPages(count * sizeof(T))) {
+		count = roundToHugePages(count * sizeof(T)) / sizeof(T);
+	}
+
+	// round up so the last aligned vector never reads past the allocation
+	return (count + CAPACITY_STEP - 1) / CAPACITY_STEP * CAPACITY_STEP;
+}
+
+template<typename T, size_t Alignment>
+T& DynamicArray<T, Alignment>::at(size_t pos)
 {
 	ASSERT(pos < m_Count, "Array index out of bounds!");
 
 	return m_Data[pos];
 }
 
-template<typename T>
-const T& DynamicArray<T>::at(size_t pos) const
+template<typename T, size_t Alignment>
+const T& DynamicArray<T, Alignment>::at(size_t pos) const
 {
 	ASSERT(pos < m_Count, "Array index out of bounds!");
 
 	return m_Data[pos];
 }
 
-template<typename T>
-T& DynamicArray<T>::operator[](size_t pos)
+template<typename T, size_t Alignment>
+T& DynamicArray<T, Alignment>::operator[](size_t pos)
 {
 	return at(pos);
 }
 
-template<typename T>
-const T& DynamicArray<T>::operator[](size_t pos) const
+template<typename T, size_t Alignment>
+const T& DynamicArray<T, Alignment>::operator[](size_t pos) const
 {
 	return at(pos);
 }
 
-template<typename T>
-T* DynamicArray<T>::data() const
+template<typename T, size_t Alignment>
+void DynamicArray<T, Alignment>::gather(std::span<const size_t> indices, T* out, size_t prefetchDistance) const
+{
+	const size_t count = indices.size();
+	const size_t* index = indices.data();
+
+	// positions before this one have an element a full prefetch distance ahead of them
+	const size_t prefetchEnd = prefetchDistance != 0 && count > prefetchDistance ? count - prefetchDistance : 0;
+	size_t i = 0;
+
+#ifdef DYNAMIC_ARRAY_AVX2
+	if constexpr (std::is_trivially_copyable_v<T> && (sizeof(T) == 4 || sizeof(T) == 8)) {
+		for (; i + 4 <= count; i += 4) {
+			for (size_t lane = i; lane < i + 4; ++lane) {
+				ASSERT(index[lane] < m_Count, "Gather index out of bounds!");
+
+				if (lane < prefetchEnd) DYNAMIC_ARRAY_PREFETCH_READ(m_Data + index[lane + prefetchDistance]);
+			}
+
+			const __m256i lanes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(index + i));
+
+			if constexpr (sizeof(T) == 4) {
+				const __m128i elements = _mm256_i64gather_epi32(reinterpret_cast<const int*>(m_Data), lanes, 4);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), elements);
+			} else {
+				const __m256i elements = _mm256_i64gather_epi64(reinterpret_cast<const long long*>(m_Data), lanes, 8);
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), elements);
+			}
+		}
+	}
+#endif
+
+	for (; i < prefetchEnd; ++i) {
+		ASSERT(index[i] < m_Count, "Gather index out of bounds!");
+
+		DYNAMIC_ARRAY_PREFETCH_READ(m_Data + index[i + prefetchDistance]);
+		out[i] = m_Data[index[i]];
+	}
+
+	for (; i < count; ++i) {
+		ASSERT(index[i] < m_Count, "Gather index out of bounds!");
+
+		out[i] = m_Data[index[i]];
+	}
+}
+
+template<typename T, size_t Alignment>
+void DynamicArray<T, Alignment>::scatter(std::span<const size_t> indices, const T* values, size_t prefetchDistance)
+{
+	const size_t count = indices.size();
+	const size_t* index = indices.data();
+
+	const size_t prefetchEnd = prefetchDistance != 0 && count > prefetchDistance ? count - prefetchDistance : 0;
+	size_t i = 0;
+
+	// AVX2 has no scatter instruction, so this is scalar stores with prefetching only
+	for (; i < prefetchEnd; ++i) {
+		ASSERT(index[i] < m_Count, "Scatter index out of bounds!");
+
+		DYNAMIC_ARRAY_PREFETCH_WRITE(m_Data + index[i + prefetchDistance]);
+		m_Data[index[i]] = values[i];
+	}
+
+	for (; i < count; ++i) {
+		ASSERT(index[i] < m_Count, "Scatter index out of bounds!");
+
+		m_Data[index[i]] = values[i];
+	}
+}
+
+template<typename T, size_t Alignment>
+T* DynamicArray<T, Alignment>::data() const
 {
 	if (m_Count == 0) {
 		return nullptr;
@@ -396,18 +800,77 @@ T* DynamicArray<T>::data() const
 	return &m_Data[0];
 }
 
-template <typename T>
-T* DynamicArray<T>::allocNewArray(size_t count)
+template<typename T, size_t Alignment>
+size_t DynamicArray<T, Alignment>::paddedLen() const
+{
+	return (m_Count + CAPACITY_STEP - 1) / CAPACITY_STEP * CAPACITY_STEP;
+}
+
+#ifdef DYNAMIC_ARRAY_STATS
+template <typename T, size_t Alignment>
+DynamicArrayStats& DynamicArray<T, Alignment>::stats()
+{
+	if (m_Stats == nullptr) m_Stats = &DynamicArrayStatsRegistry::statsFor<T>(m_Site);
+	return *m_Stats;
+}
+#endif
+
+template <typename T, size_t Alignment>
+T* DynamicArray<T, Alignment>::allocNewArray(size_t count)
 {
 #ifdef DYNAMIC_ARRAY_DEBUG
 	std::cout << "ALLOCATING " << count << " ELEMENTS (" << count * sizeof(T) << " BYTES)" << std::endl;
 #endif
 
-	return static_cast<T*>(malloc(count * sizeof(T)));
+#ifdef DYNAMIC_ARRAY_STATS
+	stats().recordAllocation(count);
+#endif
+
+	if (m_Placement.usesPages(count * sizeof(T))) {
+		return static_cast<T*>(allocatePages(count * sizeof(T), m_Placement));
+	}
+
+	// the capacity is padded to a multiple of the alignment, as aligned_alloc requires
+#ifdef _MSC_VER
+	T* data = static_cast<T*>(_aligned_malloc(count * sizeof(T), Alignment));
+#else
+	T* data = static_cast<T*>(std::aligned_alloc(Alignment, count * sizeof(T)));
+#endif
+
+	// a zero-sized request may legitimately come back as nullptr
+	if (data == nullptr && count != 0) throw std::bad_alloc();
+	return data;
+}
+
+template <typename T, size_t Alignment>
+void DynamicArray<T, Alignment>::freeArray()
+{
+	if (m_Data == nullptr) return;
+
+#ifdef DYNAMIC_ARRAY_DEBUG
+	std::cout << "FREEING " << m_CountAlloced << " ELEMENTS (" << m_CountAlloced * sizeof(T) << " BYTES)" << std::endl;
+#endif
+
+#ifdef DYNAMIC_ARRAY_STATS
+	stats().recordFree(m_CountAlloced, m_Count);
+#endif
+
+	if (m_PageBacked) {
+		freePages(m_Data, m_CountAlloced * sizeof(T));
+	} else {
+#ifdef _MSC_VER
+		_aligned_free(m_Data);
+#else
+		std::free(m_Data);
+#endif
+	}
+
+	m_Data = nullptr;
+	m_PageBacked = false;
 }
 
-template<typename T>
-std::ostream& operator<<(std::ostream& os, const DynamicArray<T>& arr) {
+template<typename T, size_t Alignment>
+std::ostream& operator<<(std::ostream& os, const DynamicArray<T, Alignment>& arr) {
 	os << "[";
 
 	if (arr.m_Count != 0) {
@@ -0,0 +1,348 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <source_location>
+#include <string>
+#include <string_view>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__GNUG__)
+	#include <cxxabi.h>
+#endif
+
+/**
+ * @brief Allocation and growth counters shared by every dynamic array of one element type constructed at one call site.
+ * Only updated when DYNAMIC_ARRAY_STATS is defined, otherwise dynamic arrays never touch them.
+ */
+struct DynamicArrayStats
+{
+	/**
+	 * @brief A plain copy of the counters taken at one point in time.
+	 */
+	struct Snapshot
+	{
+		std::string typeName;
+		std::string site;
+		size_t elementSize = 0;
+		size_t allocations = 0;
+		size_t bytesAllocated = 0;
+		size_t bytesFreed = 0;
+		size_t reallocations = 0;
+		size_t bytesCopied = 0;
+		size_t peakCapacity = 0;
+		size_t wastedSlackBytes = 0;
+	};
+
+	// demangled element type, and the file, line and column the arrays were constructed at
+	std::string typeName;
+	std::string site;
+	size_t elementSize = 0;
+
+	std::atomic<size_t> allocations = 0;
+	std::atomic<size_t> bytesAllocated = 0;
+	std::atomic<size_t> bytesFreed = 0;
+	std::atomic<size_t> reallocations = 0;
+	std::atomic<size_t> bytesCopied = 0;
+
+	// the largest capacity any one array from this call site has grown to
+	std::atomic<size_t> peakCapacity = 0;
+
+	// bytes of capacity which never held an element by the time the buffer was freed or regrown
+	std::atomic<size_t> wastedSlackBytes = 0;
+
+	/**
+	 * @brief Record a new buffer being allocated.
+	 * @param capacity Number of elements the buffer can hold.
+	 */
+	void recordAllocation(size_t capacity);
+
+	/**
+	 * @brief Record a buffer being freed.
+	 * @param capacity Number of elements the buffer could hold.
+	 * @param count Number of elements the buffer held when it was freed.
+	 */
+	void recordFree(size_t capacity, size_t count);
+
+	/**
+	 * @brief Record elements being copied into a larger or smaller buffer.
+	 * @param count Number of elements copied.
+	 */
+	void recordReallocation(size_t count);
+
+	/**
+	 * @brief Set every counter back to zero.
+	 */
+	void reset();
+
+	/**
+	 * @brief Copy the current value of every counter.
+	 * @returns A snapshot of the counters.
+	 */
+	[[nodiscard]] Snapshot snapshot() const;
+};
+
+/**
+ * @brief Global table of the stats for every call site which has constructed a dynamic array which then allocated.
+ * Each thread also caches the stats of the call sites it has seen, so only its first array from a call site
+ * takes the registry's lock.
+ */
+class DynamicArrayStatsRegistry
+{
+private:
+	// mangled element type name, and the file, line and column the arrays were constructed at
+	struct SiteKey
+	{
+		const char* type;
+		const char* file;
+		uint_least32_t line, column;
+	};
+
+	// the same string can be at different addresses in different translation units, so the registry compares contents
+	struct SiteNameHash
+	{
+		size_t operator()(const SiteKey& key) const;
+	};
+
+	struct SiteNameEqual
+	{
+		bool operator()(const SiteKey& lhs, const SiteKey& rhs) const;
+	};
+
+	// whereas a thread's cache only needs to recognise the exact call site it saw before
+	struct SiteAddressHash
+	{
+		size_t operator()(const SiteKey& key) const;
+	};
+
+	struct SiteAddressEqual
+	{
+		bool operator()(const SiteKey& lhs, const SiteKey& rhs) const;
+	};
+
+	mutable std::mutex m_Mutex;
+	std::unordered_map<SiteKey, std::unique_ptr<DynamicArrayStats>, SiteNameHash, SiteNameEqual> m_Entries;
+
+	DynamicArrayStatsRegistry() = default;
+
+	static size_t combineHash(size_t seed, size_t value);
+
+	static std::string demangle(const char* name);
+
+public:
+	/**
+	 * @brief Returns the process wide registry.
+	 * @returns The registry.
+	 */
+	static DynamicArrayStatsRegistry& instance();
+
+	/**
+	 * @brief Returns the stats for a given element type and call site, registering them on first use.
+	 * @tparam T Element type of the dynamic arrays.
+	 * @param site Where the dynamic arrays were constructed.
+	 * @returns Stats shared by every dynamic array of that element type constructed at that call site.
+	 */
+	template <typename T>
+	static DynamicArrayStats& statsFor(const std::source_location& site);
+
+	/**
+	 * @brief Copy the counters of every registered call site.
+	 * @returns One snapshot per element type and call site.
+	 */
+	[[nodiscard]] std::vector<DynamicArrayStats::Snapshot> snapshot() const;
+
+	/**
+	 * @brief Set the counters of every registered call site back to zero.
+	 */
+	void reset();
+
+	/**
+	 * @brief Write one line of key=value pairs per element type and call site, suitable for scraping.
+	 * @param os Stream to write to.
+	 */
+	void dump(std::ostream& os) const;
+};
+
+inline void DynamicArrayStats::recordAllocation(size_t capacity)
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	bytesAllocated.fetch_add(capacity * elementSize, std::memory_order_relaxed);
+
+	size_t peak = peakCapacity.load(std::memory_order_relaxed);
+	while (capacity > peak && !peakCapacity.compare_exchange_weak(peak, capacity, std::memory_order_relaxed)) {}
+}
+
+inline void DynamicArrayStats::recordFree(size_t capacity, size_t count)
+{
+	bytesFreed.fetch_add(capacity * elementSize, std::memory_order_relaxed);
+	wastedSlackBytes.fetch_add((capacity - count) * elementSize, std::memory_order_relaxed);
+}
+
+inline void DynamicArrayStats::recordReallocation(size_t count)
+{
+	reallocations.fetch_add(1, std::memory_order_relaxed);
+	bytesCopied.fetch_add(count * elementSize, std::memory_order_relaxed);
+}
+
+inline void DynamicArrayStats::reset()
+{
+	allocations = 0;
+	bytesAllocated = 0;
+	bytesFreed = 0;
+	reallocations = 0;
+	bytesCopied = 0;
+	peakCapacity = 0;
+	wastedSlackBytes = 0;
+}
+
+inline DynamicArrayStats::Snapshot DynamicArrayStats::snapshot() const
+{
+	return {
+		typeName,
+		site,
+		elementSize,
+		allocations.load(std::memory_order_relaxed),
+		bytesAllocated.load(std::memory_order_relaxed),
+		bytesFreed.load(std::memory_order_relaxed),
+		reallocations.load(std::memory_order_relaxed),
+		bytesCopied.load(std::memory_order_relaxed),
+		peakCapacity.load(std::memory_order_relaxed),
+		wastedSlackBytes.load(std::memory_order_relaxed)
+	};
+}
+
+inline size_t DynamicArrayStatsRegistry::combineHash(size_t seed, size_t value)
+{
+	return seed ^ (value + 0x9E3779B9 + (seed << 6) + (seed >> 2));
+}
+
+inline size_t DynamicArrayStatsRegistry::SiteNameHash::operator()(const SiteKey& key) const
+{
+	size_t hash = std::hash<std::string_view>()(key.file);
+	hash = combineHash(hash, std::hash<std::string_view>()(key.type));
+	return combineHash(hash, (static_cast<size_t>(key.line) << 16) ^ key.column);
+}
+
+inline bool DynamicArrayStatsRegistry::SiteNameEqual::operator()(const SiteKey& lhs, const SiteKey& rhs) const
+{
+	return lhs.line == rhs.line && lhs.column == rhs.column
+		&& (lhs.file == rhs.file || std::strcmp(lhs.file, rhs.file) == 0)
+		&& (lhs.type == rhs.type || std::strcmp(lhs.type, rhs.type) == 0);
+}
+
+inline size_t DynamicArrayStatsRegistry::SiteAddressHash::operator()(const SiteKey& key) const
+{
+	size_t hash = std::hash<const char*>()(key.file);
+	hash = combineHash(hash, std::hash<const char*>()(key.type));
+	return combineHash(hash, (static_cast<size_t>(key.line) << 16) ^ key.column);
+}
+
+inline bool DynamicArrayStatsRegistry::SiteAddressEqual::operator()(const SiteKey& lhs, const SiteKey& rhs) const
+{
+	return lhs.file == rhs.file && lhs.type == rhs.type && lhs.line == rhs.line && lhs.column == rhs.column;
+}
+
+inline DynamicArrayStatsRegistry& DynamicArrayStatsRegistry::instance()
+{
+	static DynamicArrayStatsRegistry registry;
+	return registry;
+}
+
+inline std::string DynamicArrayStatsRegistry::demangle(const char* name)
+{
+#if defined(__GNUG__)
+	int status = 0;
+	char* demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+
+	if (status == 0) {
+		std::string result(demangled);
+		std::free(demangled);
+		return result;
+	}
+#endif
+
+	// msvc names are already readable
+	return name;
+}
+
+template <typename T>
+DynamicArrayStats& DynamicArrayStatsRegistry::statsFor(const std::source_location& site)
+{
+	const SiteKey key{ typeid(T).name(), site.file_name(), site.line(), site.column() };
+
+	// a default argument cannot hold a static, so the nearest thing to caching per call site is caching per thread
+	thread_local std::unordered_map<SiteKey, DynamicArrayStats*, SiteAddressHash, SiteAddressEqual> cache;
+
+	if (auto cached = cache.find(key); cached != cache.end()) return *cached->second;
+
+	auto& registry = instance();
+	std::unique_lock lock(registry.m_Mutex);
+
+	auto& stats = registry.m_Entries[key];
+
+	if (stats == nullptr) {
+		stats = std::make_unique<DynamicArrayStats>();
+		stats->typeName = demangle(key.type);
+		stats->site = std::string(key.file) + ":" + std::to_string(key.line) + ":" + std::to_string(key.column);
+		stats->elementSize = sizeof(T);
+	}
+
+	DynamicArrayStats* result = stats.get();
+	lock.unlock();
+
+	cache.emplace(key, result);
+	return *result;
+}
+
+inline std::vector<DynamicArrayStats::Snapshot> DynamicArrayStatsRegistry::snapshot() const
+{
+	std::lock_guard lock(m_Mutex);
+
+	std::vector<DynamicArrayStats::Snapshot> snapshots;
+	snapshots.reserve(m_Entries.size());
+
+	for (const auto& [key, stats] : m_Entries) {
+		snapshots.push_back(stats->snapshot());
+	}
+
+	// the table has no order of its own, so sort to keep dumps comparable between runs
+	std::sort(snapshots.begin(), snapshots.end(), [](const auto& lhs, const auto& rhs) {
+		return lhs.site != rhs.site ? lhs.site < rhs.site : lhs.typeName < rhs.typeName;
+	});
+
+	return snapshots;
+}
+
+inline void DynamicArrayStatsRegistry::reset()
+{
+	std::lock_guard lock(m_Mutex);
+
+	for (auto& [key, stats] : m_Entries) {
+		stats->reset();
+	}
+}
+
+inline void DynamicArrayStatsRegistry::dump(std::ostream& os) const
+{
+	// type names can hold spaces, so they are quoted
+	for (const auto& stats : snapshot()) {
+		os << "dynamic_array type=\"" << stats.typeName << "\""
+			<< " site=" << stats.site
+			<< " element_size=" << stats.elementSize
+			<< " allocations=" << stats.allocations
+			<< " bytes_allocated=" << stats.bytesAllocated
+			<< " bytes_freed=" << stats.bytesFreed
+			<< " reallocations=" << stats.reallocations
+			<< " bytes_copied=" << stats.bytesCopied
+			<< " peak_capacity=" << stats.peakCapacity
+			<< " wasted_slack_bytes=" << stats.wastedSlackBytes << std::endl;
+	}
+}
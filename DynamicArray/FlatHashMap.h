@@ -0,0 +1,523 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define FLAT_HASH_MAP_SSE2
+	#include <emmintrin.h>
+#endif
+
+#include "DynamicArray.h"
+
+/**
+ * @brief An open addressing hash map in the style of a swiss table.
+ * Every bucket has a control byte holding 7 bits of its key's hash, or a marker if it is empty or deleted.
+ * Control bytes are probed 16 at a time, so most lookups compare a whole group of keys' hashes in a few instructions
+ * and only touch the buckets whose hash bits match.
+ * @tparam K Datatype of keys.
+ * @tparam V Datatype of values.
+ * @tparam Hash Function object used to hash keys.
+ * @tparam KeyEqual Function object used to compare keys.
+ */
+template <typename K, typename V, typename Hash = std::hash<K>, typename KeyEqual = std::equal_to<K>>
+class FlatHashMap
+{
+private:
+	using Entry = std::pair<K, V>;
+
+	// raw storage so buckets can sit in a dynamic array without their keys and values being constructed
+	struct Bucket
+	{
+		alignas(Entry) unsigned char storage[sizeof(Entry)];
+	};
+
+	static constexpr int8_t EMPTY = -128;
+	static constexpr int8_t DELETED = -2;
+
+	static constexpr size_t GROUP_SIZE = 16;
+	static constexpr size_t NOT_FOUND = SIZE_MAX;
+
+	DynamicArray<int8_t> m_Control;
+	DynamicArray<Bucket> m_Buckets;
+	size_t m_Size = 0, m_Deleted = 0;
+	float m_MaxLoadFactor;
+
+	Hash m_Hash;
+	KeyEqual m_KeyEqual;
+
+	static uint32_t matchByte(const int8_t* group, int8_t value);
+	static uint32_t matchEmptyOrDeleted(const int8_t* group);
+
+	[[nodiscard]] static Entry& entryOf(Bucket& bucket);
+	[[nodiscard]] static const Entry& entryOf(const Bucket& bucket);
+
+	[[nodiscard]] size_t hashOf(const K& key) const;
+	[[nodiscard]] size_t findIndex(const K& key) const;
+	[[nodiscard]] size_t findInsertIndex(size_t hash) const;
+	[[nodiscard]] size_t capacityFor(size_t count) const;
+
+	template <typename... Args>
+	std::pair<size_t, bool> findOrInsertSlot(const K& key, Args&&... args);
+
+	void rehash(size_t capacity);
+	void destroyEntries();
+
+public:
+	/**
+	 * @brief Construct an empty hash map.
+	 * @param maxLoadFactor Fraction of buckets which can be in use before the map grows.
+	 */
+	explicit FlatHashMap(float maxLoadFactor = 0.875f);
+
+	FlatHashMap(const FlatHashMap& other) = delete;
+	FlatHashMap& operator=(const FlatHashMap& other) = delete;
+
+	/**
+	 * @brief Move a hash map into another hash map.
+	 * @param other The map to move from.
+	 */
+	FlatHashMap(FlatHashMap&& other) noexcept;
+
+	/**
+	 * @brief Move a hash map into another hash map.
+	 */
+	FlatHashMap& operator=(FlatHashMap&& other) noexcept;
+
+	~FlatHashMap();
+
+	/**
+	 * @brief Insert a key and value if the key is not already in the map.
+	 * @param key Key to insert.
+	 * @param value Value to insert.
+	 * @returns True if the key was inserted, false if it was already in the map.
+	 */
+	bool insert(const K& key, const V& value);
+
+	/**
+	 * @brief Remove a key and its value from the map.
+	 * @param key Key to remove.
+	 * @returns True if the key was removed, false if it was not in the map.
+	 */
+	bool erase(const K& key);
+
+	/**
+	 * @brief Returns a pointer to the value of a given key.
+	 * @param key Key to find.
+	 * @returns Pointer to the value, or nullptr if the key is not in the map.
+	 */
+	[[nodiscard]] V* find(const K& key);
+
+	/**
+	 * @brief Returns a constant pointer to the value of a given key.
+	 * @param key Key to find.
+	 * @returns Constant pointer to the value, or nullptr if the key is not in the map.
+	 */
+	[[nodiscard]] const V* find(const K& key) const;
+
+	/**
+	 * @brief Returns whether a key is in the map.
+	 * @param key Key to find.
+	 * @returns If the key is in the map.
+	 */
+	[[nodiscard]] bool contains(const K& key) const;
+
+	/**
+	 * @brief Returns a reference to the value of a given key.
+	 * @param key Key to find.
+	 * @returns Reference to the value.
+	 */
+	[[nodiscard]] V& at(const K& key);
+
+	/**
+	 * @brief Returns a constant reference to the value of a given key.
+	 * @param key Key to find.
+	 * @returns Constant reference to the value.
+	 */
+	[[nodiscard]] const V& at(const K& key) const;
+
+	/**
+	 * @brief Returns a reference to the value of a given key, inserting a default value if the key is not in the map.
+	 * @param key Key to find.
+	 * @returns Reference to the value.
+	 */
+	V& operator[](const K& key);
+
+	/**
+	 * @brief Make room for a given number of keys, so inserting them will not rehash.
+	 * @param count Number of keys to make room for.
+	 */
+	void reserve(size_t count);
+
+	/**
+	 * @brief Remove every key from the map, keeping its buckets.
+	 */
+	void clear();
+
+	/**
+	 * @brief Call a function with every key and value in the map.
+	 * @param function Function taking a constant key and a value.
+	 */
+	template <typename Function>
+	void forEach(Function&& function);
+
+	/**
+	 * @brief Returns the number of keys in the map.
+	 * @returns Number of keys in the map.
+	 */
+	[[nodiscard]] size_t len() const;
+
+	/**
+	 * @brief Returns whether the map is empty or not.
+	 * @returns If the map is empty or not.
+	 */
+	[[nodiscard]] bool isEmpty() const;
+
+	/**
+	 * @brief Returns the number of buckets in the map.
+	 * @returns Number of buckets.
+	 */
+	[[nodiscard]] size_t capacity() const;
+};
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+FlatHashMap<K, V, Hash, KeyEqual>::FlatHashMap(float maxLoadFactor) :
+	m_MaxLoadFactor(maxLoadFactor)
+{
+	if (maxLoadFactor <= 0.0f || maxLoadFactor >= 1.0f)
+		throw std::range_error("Hash map load factor must be between 0 and 1.");
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+FlatHashMap<K, V, Hash, KeyEqual>::FlatHashMap(FlatHashMap&& other) noexcept :
+	m_Control(std::move(other.m_Control)), m_Buckets(std::move(other.m_Buckets)),
+	m_Size(other.m_Size), m_Deleted(other.m_Deleted), m_MaxLoadFactor(other.m_MaxLoadFactor),
+	m_Hash(std::move(other.m_Hash)), m_KeyEqual(std::move(other.m_KeyEqual))
+{
+	other.m_Size = other.m_Deleted = 0;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+FlatHashMap<K, V, Hash, KeyEqual>& FlatHashMap<K, V, Hash, KeyEqual>::operator=(FlatHashMap&& other) noexcept
+{
+	if (this == &other) return *this;
+
+	destroyEntries();
+
+	m_Control = std::move(other.m_Control);
+	m_Buckets = std::move(other.m_Buckets);
+	m_Size = other.m_Size;
+	m_Deleted = other.m_Deleted;
+	m_MaxLoadFactor = other.m_MaxLoadFactor;
+	m_Hash = std::move(other.m_Hash);
+	m_KeyEqual = std::move(other.m_KeyEqual);
+
+	other.m_Size = other.m_Deleted = 0;
+
+	return *this;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+FlatHashMap<K, V, Hash, KeyEqual>::~FlatHashMap()
+{
+	destroyEntries();
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+uint32_t FlatHashMap<K, V, Hash, KeyEqual>::matchByte(const int8_t* group, int8_t value)
+{
+#ifdef FLAT_HASH_MAP_SSE2
+	const __m128i control = _mm_load_si128(reinterpret_cast<const __m128i*>(group));
+	return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(control, _mm_set1_epi8(value))));
+#else
+	uint32_t mask = 0;
+	for (size_t i = 0; i < GROUP_SIZE; ++i) {
+		mask |= static_cast<uint32_t>(group[i] == value) << i;
+	}
+	return mask;
+#endif
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+uint32_t FlatHashMap<K, V, Hash, KeyEqual>::matchEmptyOrDeleted(const int8_t* group)
+{
+	// empty and deleted are the only negative control bytes, so the sign bits are the mask
+#ifdef FLAT_HASH_MAP_SSE2
+	const __m128i control = _mm_load_si128(reinterpret_cast<const __m128i*>(group));
+	return static_cast<uint32_t>(_mm_movemask_epi8(control));
+#else
+	uint32_t mask = 0;
+	for (size_t i = 0; i < GROUP_SIZE; ++i) {
+		mask |= static_cast<uint32_t>(group[i] < 0) << i;
+	}
+	return mask;
+#endif
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+typename FlatHashMap<K, V, Hash, KeyEqual>::Entry& FlatHashMap<K, V, Hash, KeyEqual>::entryOf(Bucket& bucket)
+{
+	return *std::launder(reinterpret_cast<Entry*>(bucket.storage));
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+const typename FlatHashMap<K, V, Hash, KeyEqual>::Entry& FlatHashMap<K, V, Hash, KeyEqual>::entryOf(const Bucket& bucket)
+{
+	return *std::launder(reinterpret_cast<const Entry*>(bucket.storage));
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+size_t FlatHashMap<K, V, Hash, KeyEqual>::hashOf(const K& key) const
+{
+	// std::hash is the identity for integers, so mix the bits before splitting the hash in two
+	uint64_t hash = static_cast<uint64_t>(m_Hash(key)) * 0x9E3779B97F4A7C15ull;
+	return static_cast<size_t>(hash ^ (hash >> 32));
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+size_t FlatHashMap<K, V, Hash, KeyEqual>::findIndex(const K& key) const
+{
+	if (m_Control.isEmpty()) return NOT_FOUND;
+
+	const size_t hash = hashOf(key);
+	const auto hashBits = static_cast<int8_t>(hash & 0x7F);
+	const size_t groupMask = m_Control.len() / GROUP_SIZE - 1;
+
+	// triangular probing over groups visits every group once when the group count is a power of two
+	for (size_t group = (hash >> 7) & groupMask, step = 1; ; group = (group + step++) & groupMask) {
+		const int8_t* control = m_Control.data() + group * GROUP_SIZE;
+
+		for (uint32_t match = matchByte(control, hashBits); match != 0; match &= match - 1) {
+			const size_t index = group * GROUP_SIZE + std::countr_zero(match);
+
+			if (m_KeyEqual(entryOf(m_Buckets.data()[index]).first, key)) return index;
+		}
+
+		if (matchByte(control, EMPTY) != 0 || step > groupMask) return NOT_FOUND;
+	}
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+size_t FlatHashMap<K, V, Hash, KeyEqual>::findInsertIndex(size_t hash) const
+{
+	const size_t groupMask = m_Control.len() / GROUP_SIZE - 1;
+
+	for (size_t group = (hash >> 7) & groupMask, step = 1; ; group = (group + step++) & groupMask) {
+		const uint32_t match = matchEmptyOrDeleted(m_Control.data() + group * GROUP_SIZE);
+
+		if (match != 0) return group * GROUP_SIZE + std::countr_zero(match);
+	}
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+size_t FlatHashMap<K, V, Hash, KeyEqual>::capacityFor(size_t count) const
+{
+	const auto needed = static_cast<size_t>(static_cast<double>(count) / m_MaxLoadFactor) + 1;
+	return std::max(GROUP_SIZE, std::bit_ceil(needed));
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+void FlatHashMap<K, V, Hash, KeyEqual>::rehash(size_t capacity)
+{
+	DynamicArray<int8_t> oldControl = std::move(m_Control);
+	DynamicArray<Bucket> oldBuckets = std::move(m_Buckets);
+
+	m_Control.resize(capacity, EMPTY);
+	m_Buckets.resize(capacity);
+	m_Deleted = 0;
+
+	for (size_t i = 0; i < oldControl.len(); ++i) {
+		if (oldControl[i] < 0) continue;
+
+		Entry& entry = entryOf(oldBuckets[i]);
+		const size_t hash = hashOf(entry.first);
+		const size_t index = findInsertIndex(hash);
+
+		m_Control[index] = static_cast<int8_t>(hash & 0x7F);
+		new (m_Buckets[index].storage) Entry(std::move(entry));
+		entry.~Entry();
+	}
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+void FlatHashMap<K, V, Hash, KeyEqual>::destroyEntries()
+{
+	for (size_t i = 0; i < m_Control.len(); ++i) {
+		if (m_Control[i] >= 0) {
+			entryOf(m_Buckets[i]).~Entry();
+		}
+	}
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+template <typename... Args>
+std::pair<size_t, bool> FlatHashMap<K, V, Hash, KeyEqual>::findOrInsertSlot(const K& key, Args&&... args)
+{
+	const size_t hash = hashOf(key);
+	const auto hashBits = static_cast<int8_t>(hash & 0x7F);
+	size_t index = NOT_FOUND;
+
+	if (!m_Control.isEmpty()) {
+		const size_t groupMask = m_Control.len() / GROUP_SIZE - 1;
+
+		for (size_t group = (hash >> 7) & groupMask, step = 1; ; group = (group + step++) & groupMask) {
+			const int8_t* control = m_Control.data() + group * GROUP_SIZE;
+
+			for (uint32_t match = matchByte(control, hashBits); match != 0; match &= match - 1) {
+				const size_t found = group * GROUP_SIZE + std::countr_zero(match);
+
+				if (m_KeyEqual(entryOf(m_Buckets.data()[found]).first, key)) return { found, false };
+			}
+
+			// the first free bucket on the probe is where findInsertIndex would put the key
+			if (index == NOT_FOUND) {
+				if (const uint32_t free = matchEmptyOrDeleted(control); free != 0) {
+					index = group * GROUP_SIZE + std::countr_zero(free);
+				}
+			}
+
+			if (matchByte(control, EMPTY) != 0 || step > groupMask) break;
+		}
+	}
+
+	// deleted buckets still lengthen probes, so they count towards the load
+	if (static_cast<double>(m_Size + m_Deleted + 1) > static_cast<double>(m_Control.len()) * m_MaxLoadFactor) {
+		rehash(std::max(capacityFor(m_Size + 1), m_Control.len()));
+		index = findInsertIndex(hash);
+	}
+
+	// construct before marking the bucket, so a throwing constructor leaves the map unchanged
+	new (m_Buckets[index].storage) Entry(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+
+	if (m_Control[index] == DELETED) --m_Deleted;
+
+	m_Control[index] = hashBits;
+	++m_Size;
+
+	return { index, true };
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+bool FlatHashMap<K, V, Hash, KeyEqual>::insert(const K& key, const V& value)
+{
+	return findOrInsertSlot(key, value).second;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+bool FlatHashMap<K, V, Hash, KeyEqual>::erase(const K& key)
+{
+	const size_t index = findIndex(key);
+	if (index == NOT_FOUND) return false;
+
+	entryOf(m_Buckets[index]).~Entry();
+
+	// a probe for another key may have passed through this bucket, so it has to stay marked rather than empty
+	m_Control[index] = DELETED;
+	--m_Size;
+	++m_Deleted;
+
+	return true;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+V* FlatHashMap<K, V, Hash, KeyEqual>::find(const K& key)
+{
+	const size_t index = findIndex(key);
+	return index == NOT_FOUND ? nullptr : &entryOf(m_Buckets[index]).second;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+const V* FlatHashMap<K, V, Hash, KeyEqual>::find(const K& key) const
+{
+	const size_t index = findIndex(key);
+	return index == NOT_FOUND ? nullptr : &entryOf(m_Buckets[index]).second;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+bool FlatHashMap<K, V, Hash, KeyEqual>::contains(const K& key) const
+{
+	return findIndex(key) != NOT_FOUND;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+V& FlatHashMap<K, V, Hash, KeyEqual>::at(const K& key)
+{
+	V* value = find(key);
+	if (value == nullptr)
+		throw std::range_error("Key is not in hash map.");
+
+	return *value;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+const V& FlatHashMap<K, V, Hash, KeyEqual>::at(const K& key) const
+{
+	const V* value = find(key);
+	if (value == nullptr)
+		throw std::range_error("Key is not in hash map.");
+
+	return *value;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+V& FlatHashMap<K, V, Hash, KeyEqual>::operator[](const K& key)
+{
+	return entryOf(m_Buckets[findOrInsertSlot(key).first]).second;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+void FlatHashMap<K, V, Hash, KeyEqual>::reserve(size_t count)
+{
+	const size_t capacity = capacityFor(count);
+
+	if (capacity > m_Control.len()) {
+		rehash(capacity);
+	}
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+void FlatHashMap<K, V, Hash, KeyEqual>::clear()
+{
+	destroyEntries();
+
+	for (size_t i = 0; i < m_Control.len(); ++i) {
+		m_Control[i] = EMPTY;
+	}
+
+	m_Size = m_Deleted = 0;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+template <typename Function>
+void FlatHashMap<K, V, Hash, KeyEqual>::forEach(Function&& function)
+{
+	for (size_t i = 0; i < m_Control.len(); ++i) {
+		if (m_Control[i] >= 0) {
+			Entry& entry = entryOf(m_Buckets[i]);
+			function(static_cast<const K&>(entry.first), entry.second);
+		}
+	}
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+size_t FlatHashMap<K, V, Hash, KeyEqual>::len() const
+{
+	return m_Size;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+bool FlatHashMap<K, V, Hash, KeyEqual>::isEmpty() const
+{
+	return m_Size == 0;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+size_t FlatHashMap<K, V, Hash, KeyEqual>::capacity() const
+{
+	return m_Control.len();
+}
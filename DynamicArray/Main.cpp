@@ -1,6 +1,15 @@
 #include <iostream>
+#include <thread>
+#include <vector>
 
+#include "CompressedIdSet.h"
+#include "CompressedIntArray.h"
+#include "ConcurrentAppendArray.h"
+#include "Deque.h"
 #include "DynamicArray.h"
+#include "FlatHashMap.h"
+#include "SlotMap.h"
+#include "SortedMerge.h"
 
 int main()
 {
@@ -39,5 +48,109 @@ int main()
 
 	std::cout << (arr.isEmpty() ? "True" : "False") << std::endl;
 
+	for (int i = 0; i < 1000; ++i) {
+		arr.append(i);
+	}
+	std::cout << "Capacity after 1000 appends = " << arr.capacity() << std::endl;
+
+	while (arr.len() > 10) {
+		arr.pop();
+	}
+	std::cout << "Capacity after popping down to 10 = " << arr.capacity() << std::endl;
+
+	arr.shrinkToFit();
+	std::cout << "Capacity after shrinkToFit = " << arr.capacity() << std::endl;
+
+	ConcurrentAppendArray<int> concurrentArr;
+
+	std::vector<std::thread> producers;
+	for (int producer = 0; producer < 4; ++producer) {
+		producers.emplace_back([&concurrentArr, producer]() {
+			for (int i = 0; i < 1000; ++i) {
+				concurrentArr.append(producer * 1000 + i);
+			}
+		});
+	}
+
+	for (auto& producer : producers) {
+		producer.join();
+	}
+
+	const DynamicArray<int> frozen = concurrentArr.freeze();
+	std::cout << "Appended " << concurrentArr.len() << " elements concurrently, frozen into " << frozen.len() << std::endl;
+
+	SlotMap<int> slotMap;
+	const SlotHandle first = slotMap.insert(10);
+	const SlotHandle second = slotMap.insert(20);
+	const SlotHandle third = slotMap.insert(30);
+
+	slotMap.erase(first);
+	std::cout << "Second = " << slotMap[second] << ", third = " << slotMap[third] << ", first still valid? " << (slotMap.contains(first) ? "True" : "False") << std::endl;
+
+	for (const int value : slotMap) {
+		std::cout << value << " ";
+	}
+	std::cout << std::endl;
+
+	FlatHashMap<int, int> squares;
+	squares.reserve(100);
+
+	for (int i = 0; i < 100; ++i) {
+		squares.insert(i, i * i);
+	}
+
+	squares.erase(3);
+	std::cout << "9 squared = " << squares.at(9) << ", contains 3? " << (squares.contains(3) ? "True" : "False") << ", buckets = " << squares.capacity() << std::endl;
+
+	DynamicArray<uint32_t> evenIds, rangeIds;
+	for (uint32_t i = 0; i < 1000000; i += 2) {
+		evenIds.append(i);
+	}
+	for (uint32_t i = 250000; i < 750000; ++i) {
+		rangeIds.append(i);
+	}
+
+	const CompressedIdSet evens(evenIds), range(rangeIds);
+	const CompressedIdSet both = evens & range, either = evens | range;
+
+	std::cout << "Evens in range = " << both.len() << ", evens or in range = " << either.len() << std::endl;
+	std::cout << "Compressed evens take " << evens.sizeInBytes() << " bytes instead of " << evenIds.len() * sizeof(uint32_t)
+		<< ", compressed range takes " << range.sizeInBytes() << " bytes" << std::endl;
+
+	CompressedIntArray<uint64_t> timestamps;
+	for (uint64_t i = 0; i < 100000; ++i) {
+		timestamps.append(1653523200000 + i * 1000 + i % 7);
+	}
+
+	const DynamicArray<uint64_t> decoded = timestamps.toArray();
+	std::cout << "Compressed " << timestamps.len() << " timestamps into " << timestamps.sizeInBytes() << " bytes instead of "
+		<< decoded.len() * sizeof(uint64_t) << ", first at or after 1653523250000 is at " << timestamps.lowerBound(1653523250000) << std::endl;
+
+	// a sliding window over the last 4 values, pushing at the back and popping the oldest from the front
+	Deque<int> window;
+	int windowSum = 0;
+
+	for (int i = 1; i <= 10; ++i) {
+		window.pushBack(i);
+		windowSum += i;
+
+		if (window.len() > 4) {
+			windowSum -= window.popFront();
+		}
+	}
+	window.pushFront(0);
+
+	const auto [firstSpan, secondSpan] = window.spans();
+	std::cout << "Window sum = " << windowSum << ", front = " << window.front() << ", back = " << window.back()
+		<< ", spans of " << firstSpan.size() << " and " << secondSpan.size() << std::endl;
+
+	const DynamicArray<int> sortedRuns[] = { {1, 4, 7}, {2, 5, 8}, {0, 3, 6, 9} };
+	std::cout << "Merged runs = " << kWayMerge(std::span<const DynamicArray<int>>(sortedRuns)) << std::endl;
+	std::cout << "Merged pair = " << mergeSorted(sortedRuns[0], sortedRuns[1]) << std::endl;
+
+#ifdef DYNAMIC_ARRAY_STATS
+	DynamicArrayStatsRegistry::instance().dump(std::cout);
+#endif
+
 	return 0;
 }
\ No newline at end of file
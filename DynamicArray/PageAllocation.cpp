@@ -0,0 +1,103 @@
+#include "PageAllocation.h"
+
+#include <cstdlib>
+#include <new>
+
+#if defined(_WIN32)
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <windows.h>
+#elif defined(__linux__)
+	#include <sys/mman.h>
+	#include <sys/syscall.h>
+	#include <unistd.h>
+#endif
+
+void* allocatePages(size_t bytes, const MemoryPlacement& placement)
+{
+	bytes = roundToHugePages(bytes);
+
+#if defined(_WIN32)
+	void* data = nullptr;
+
+	// large pages need the lock pages in memory privilege, so quietly fall back to normal pages without it
+	const DWORD largePages = placement.hugePages && GetLargePageMinimum() != 0 ? MEM_LARGE_PAGES : 0;
+
+	if (placement.numaPolicy == NumaPolicy::Bind) {
+		DWORD node = 0;
+		while (node < 64 && !(placement.numaNodeMask & (uint64_t(1) << node))) ++node;
+
+		data = VirtualAllocExNuma(GetCurrentProcess(), nullptr, bytes, MEM_RESERVE | MEM_COMMIT | largePages, PAGE_READWRITE, node);
+		if (data == nullptr && largePages != 0) {
+			data = VirtualAllocExNuma(GetCurrentProcess(), nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE, node);
+		}
+	} else {
+		// windows has no interleaved allocation, so interleave is treated as first touch
+		data = VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT | largePages, PAGE_READWRITE);
+		if (data == nullptr && largePages != 0) {
+			data = VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+		}
+	}
+
+	if (data == nullptr) throw std::bad_alloc();
+
+#elif defined(__linux__)
+	// over allocate by a huge page so the start can be trimmed to a huge page boundary
+	void* mapping = mmap(nullptr, bytes + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (mapping == MAP_FAILED) throw std::bad_alloc();
+
+	const auto mappingStart = reinterpret_cast<uintptr_t>(mapping);
+	const uintptr_t alignedStart = (mappingStart + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+
+	if (alignedStart != mappingStart) {
+		munmap(mapping, alignedStart - mappingStart);
+	}
+	munmap(reinterpret_cast<void*>(alignedStart + bytes), HUGE_PAGE_SIZE - (alignedStart - mappingStart));
+
+	void* data = reinterpret_cast<void*>(alignedStart);
+
+	// explicitly opt out as well as in, so comparisons between page sizes are not skewed by THP being set to always
+	madvise(data, bytes, placement.hugePages ? MADV_HUGEPAGE : MADV_NOHUGEPAGE);
+
+	#ifdef SYS_mbind
+	// policy values from linux/mempolicy.h, called directly so there is no dependency on libnuma
+	constexpr int MPOL_BIND_MODE = 2, MPOL_INTERLEAVE_MODE = 3;
+
+	if (placement.numaPolicy != NumaPolicy::FirstTouch) {
+		const int mode = placement.numaPolicy == NumaPolicy::Bind ? MPOL_BIND_MODE : MPOL_INTERLEAVE_MODE;
+		const uint64_t nodeMask = placement.numaNodeMask;
+
+		// the kernel reads one bit fewer than maxnode, so pass one more than the mask width to reach node 63
+		// a failure leaves the default first touch policy in place, which is still correct just slower
+		syscall(SYS_mbind, data, bytes, mode, &nodeMask, sizeof(nodeMask) * 8 + 1, 0);
+	}
+	#endif
+
+#else
+	void* data = std::aligned_alloc(HUGE_PAGE_SIZE, bytes);
+	if (data == nullptr) throw std::bad_alloc();
+
+#endif
+
+	if (placement.prefault) {
+		for (size_t offset = 0; offset < bytes; offset += 4096) {
+			static_cast<volatile char*>(data)[offset] = 0;
+		}
+	}
+
+	return data;
+}
+
+void freePages(void* data, size_t bytes)
+{
+	if (data == nullptr) return;
+
+#if defined(_WIN32)
+	VirtualFree(data, 0, MEM_RELEASE);
+#elif defined(__linux__)
+	munmap(data, roundToHugePages(bytes));
+#else
+	free(data);
+#endif
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief How the pages of a large allocation are spread across NUMA nodes.
+ */
+enum class NumaPolicy
+{
+	// pages are placed on the node of the thread which first writes to them
+	FirstTouch,
+	// every page is placed on the nodes in the node mask
+	Bind,
+	// pages are spread round robin across the nodes in the node mask
+	Interleave
+};
+
+/**
+ * @brief Where and with which page size large allocations are placed.
+ * Allocations smaller than the threshold are left to malloc.
+ */
+struct MemoryPlacement
+{
+	/**
+	 * @brief The default number of bytes above which allocations are page backed.
+	 */
+	static constexpr size_t DEFAULT_THRESHOLD = 4 * 1024 * 1024;
+
+	// allocate straight from the OS instead of malloc, nothing else below applies when false
+	bool pageBacked = false;
+	// back the allocation with 2 MB transparent huge pages where the OS supports it
+	bool hugePages = false;
+	// write to every page as soon as it is allocated instead of on first use
+	bool prefault = false;
+
+	NumaPolicy numaPolicy = NumaPolicy::FirstTouch;
+	// bit n selects NUMA node n, used by the bind and interleave policies, so only nodes 0 to 63 can be selected
+	uint64_t numaNodeMask = 1;
+
+	size_t threshold = DEFAULT_THRESHOLD;
+
+	/**
+	 * @brief Returns whether an allocation of a given size should be page backed.
+	 * @param bytes Size of the allocation.
+	 * @returns If the allocation should be page backed.
+	 */
+	[[nodiscard]] bool usesPages(size_t bytes) const;
+};
+
+/**
+ * @brief Size of a huge page, page backed allocations are always a multiple of this.
+ */
+inline constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+/**
+ * @brief Round a size up to a whole number of huge pages.
+ * @param bytes Size to round.
+ * @returns Rounded size.
+ */
+[[nodiscard]] inline constexpr size_t roundToHugePages(size_t bytes)
+{
+	return (bytes + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+}
+
+// the OS calls live in PageAllocation.cpp, so including this header does not pull in the platform headers
+
+/**
+ * @brief Allocate memory straight from the OS, aligned to a huge page.
+ * Falls back to aligned_alloc on platforms without page allocation.
+ * @param bytes Size of the allocation, rounded up to a whole number of huge pages.
+ * @param placement Page size and NUMA placement of the allocation.
+ * @returns Pointer to the allocation.
+ */
+[[nodiscard]] void* allocatePages(size_t bytes, const MemoryPlacement& placement);
+
+/**
+ * @brief Free memory from allocatePages.
+ * @param data Pointer to the allocation.
+ * @param bytes Size the allocation was requested with.
+ */
+void freePages(void* data, size_t bytes);
+
+inline bool MemoryPlacement::usesPages(size_t bytes) const
+{
+	return pageBacked && bytes >= threshold;
+}
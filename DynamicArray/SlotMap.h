@@ -0,0 +1,294 @@
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+
+#include "DynamicArray.h"
+
+/**
+ * @brief A handle to an element in a slot map, which stays valid until that element is erased.
+ * Generations start at 1, so a default constructed handle never refers to an element.
+ */
+struct SlotHandle
+{
+	uint32_t index = 0;
+	uint32_t generation = 0;
+
+	bool operator==(const SlotHandle& other) const = default;
+};
+
+/**
+ * @brief An array of values addressed by stable handles.
+ * Values are stored densely so iteration is a linear scan. Erasing moves the last value into the gap,
+ * and a sparse array of slots maps each handle to wherever its value currently lives.
+ * Each slot has a generation which is bumped on erase, so handles to erased values are detected rather than aliasing new ones.
+ * @tparam T Datatype of slot map.
+ */
+template <typename T>
+class SlotMap
+{
+private:
+	struct Slot
+	{
+		// position of the value in m_Values while in use, otherwise the next free slot
+		uint32_t denseIndexOrNextFree = 0;
+		uint32_t generation = 1;
+	};
+
+	static constexpr uint32_t NO_FREE_SLOT = UINT32_MAX;
+
+	DynamicArray<T> m_Values;
+	DynamicArray<uint32_t> m_ValueSlots;
+	DynamicArray<Slot> m_Slots;
+	uint32_t m_FreeHead = NO_FREE_SLOT;
+
+	[[nodiscard]] bool isLive(const SlotHandle& handle) const;
+	void retire(uint32_t slotIndex);
+
+public:
+	/**
+	 * @brief Construct an empty slot map.
+	 */
+	SlotMap() = default;
+
+	/**
+	 * @brief Insert a value into the slot map.
+	 * @param value Value to insert.
+	 * @returns Handle to the inserted value.
+	 */
+	SlotHandle insert(const T& value);
+
+	/**
+	 * @brief Erase the value a handle refers to. Every other handle stays valid.
+	 * @param handle Handle of value to erase.
+	 */
+	void erase(const SlotHandle& handle);
+
+	/**
+	 * @brief Returns whether a handle refers to a value which has not been erased.
+	 * @param handle Handle to check.
+	 * @returns If the handle is valid.
+	 */
+	[[nodiscard]] bool contains(const SlotHandle& handle) const;
+
+	/**
+	 * @brief Returns a reference to the value a handle refers to.
+	 * @param handle Handle of value to return.
+	 * @returns Reference to the value.
+	 */
+	[[nodiscard]] T& at(const SlotHandle& handle);
+
+	/**
+	 * @brief Returns a constant reference to the value a handle refers to.
+	 * @param handle Handle of value to return.
+	 * @returns Constant reference to the value.
+	 */
+	[[nodiscard]] const T& at(const SlotHandle& handle) const;
+
+	/**
+	 * @brief Returns a reference to the value a handle refers to.
+	 * @param handle Handle of value to return.
+	 * @returns Reference to the value.
+	 */
+	[[nodiscard]] T& operator[](const SlotHandle& handle);
+
+	/**
+	 * @brief Returns a constant reference to the value a handle refers to.
+	 * @param handle Handle of value to return.
+	 * @returns Constant reference to the value.
+	 */
+	[[nodiscard]] const T& operator[](const SlotHandle& handle) const;
+
+	/**
+	 * @brief Returns the number of values in the slot map.
+	 * @returns Number of values in the slot map.
+	 */
+	[[nodiscard]] size_t len() const;
+
+	/**
+	 * @brief Returns whether the slot map is empty or not.
+	 * @returns If the slot map is empty or not.
+	 */
+	[[nodiscard]] bool isEmpty() const;
+
+	/**
+	 * @brief Erase every value, invalidating every handle.
+	 */
+	void clear();
+
+	/**
+	 * @brief Return a pointer to the densely packed values, in no particular order.
+	 * @returns A pointer to the values.
+	 */
+	[[nodiscard]] T* data();
+
+	/**
+	 * @brief Return a constant pointer to the densely packed values, in no particular order.
+	 * @returns A constant pointer to the values.
+	 */
+	[[nodiscard]] const T* data() const;
+
+	[[nodiscard]] T* begin();
+	[[nodiscard]] T* end();
+	[[nodiscard]] const T* begin() const;
+	[[nodiscard]] const T* end() const;
+};
+
+template <typename T>
+bool SlotMap<T>::isLive(const SlotHandle& handle) const
+{
+	return handle.index < m_Slots.len() && m_Slots[handle.index].generation == handle.generation;
+}
+
+template <typename T>
+void SlotMap<T>::retire(uint32_t slotIndex)
+{
+	Slot& slot = m_Slots[slotIndex];
+
+	// skip generation 0 when it wraps, a default constructed handle must never come back to life
+	if (++slot.generation == 0) slot.generation = 1;
+
+	slot.denseIndexOrNextFree = m_FreeHead;
+	m_FreeHead = slotIndex;
+}
+
+template <typename T>
+SlotHandle SlotMap<T>::insert(const T& value)
+{
+	uint32_t slotIndex;
+
+	if (m_FreeHead != NO_FREE_SLOT) {
+		slotIndex = m_FreeHead;
+		m_FreeHead = m_Slots[slotIndex].denseIndexOrNextFree;
+	} else {
+		slotIndex = static_cast<uint32_t>(m_Slots.len());
+		m_Slots.append(Slot());
+	}
+
+	Slot& slot = m_Slots[slotIndex];
+	slot.denseIndexOrNextFree = static_cast<uint32_t>(m_Values.len());
+
+	m_Values.append(value);
+	m_ValueSlots.append(slotIndex);
+
+	return { slotIndex, slot.generation };
+}
+
+template <typename T>
+void SlotMap<T>::erase(const SlotHandle& handle)
+{
+	if (!isLive(handle))
+		throw std::range_error("Cannot erase a value which is not in the slot map.");
+
+	const uint32_t denseIndex = m_Slots[handle.index].denseIndexOrNextFree;
+	const uint32_t lastIndex = static_cast<uint32_t>(m_Values.len() - 1);
+
+	// fill the gap with the last value so the values stay packed, then point its slot at the new position
+	if (denseIndex != lastIndex) {
+		m_Values[denseIndex] = std::move(m_Values[lastIndex]);
+		m_ValueSlots[denseIndex] = m_ValueSlots[lastIndex];
+		m_Slots[m_ValueSlots[denseIndex]].denseIndexOrNextFree = denseIndex;
+	}
+
+	m_Values.pop();
+	m_ValueSlots.pop();
+
+	retire(handle.index);
+}
+
+template <typename T>
+bool SlotMap<T>::contains(const SlotHandle& handle) const
+{
+	return isLive(handle);
+}
+
+template <typename T>
+T& SlotMap<T>::at(const SlotHandle& handle)
+{
+	if (!isLive(handle))
+		throw std::range_error("Slot map handle refers to an erased value.");
+
+	return m_Values[m_Slots[handle.index].denseIndexOrNextFree];
+}
+
+template <typename T>
+const T& SlotMap<T>::at(const SlotHandle& handle) const
+{
+	if (!isLive(handle))
+		throw std::range_error("Slot map handle refers to an erased value.");
+
+	return m_Values[m_Slots[handle.index].denseIndexOrNextFree];
+}
+
+template <typename T>
+T& SlotMap<T>::operator[](const SlotHandle& handle)
+{
+	return at(handle);
+}
+
+template <typename T>
+const T& SlotMap<T>::operator[](const SlotHandle& handle) const
+{
+	return at(handle);
+}
+
+template <typename T>
+size_t SlotMap<T>::len() const
+{
+	return m_Values.len();
+}
+
+template <typename T>
+bool SlotMap<T>::isEmpty() const
+{
+	return m_Values.isEmpty();
+}
+
+template <typename T>
+void SlotMap<T>::clear()
+{
+	// bump every live slot's generation and thread them all onto the free list
+	for (size_t i = 0; i < m_ValueSlots.len(); ++i) {
+		retire(m_ValueSlots[i]);
+	}
+
+	m_Values.clear();
+	m_ValueSlots.clear();
+}
+
+template <typename T>
+T* SlotMap<T>::data()
+{
+	return m_Values.data();
+}
+
+template <typename T>
+const T* SlotMap<T>::data() const
+{
+	return m_Values.data();
+}
+
+template <typename T>
+T* SlotMap<T>::begin()
+{
+	return m_Values.data();
+}
+
+template <typename T>
+T* SlotMap<T>::end()
+{
+	return m_Values.data() + m_Values.len();
+}
+
+template <typename T>
+const T* SlotMap<T>::begin() const
+{
+	return m_Values.data();
+}
+
+template <typename T>
+const T* SlotMap<T>::end() const
+{
+	return m_Values.data() + m_Values.len();
+}
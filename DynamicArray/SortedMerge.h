@@ -0,0 +1,411 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "DynamicArray.h"
+
+/**
+ * @brief Merges below this many output elements per thread are not worth splitting across threads.
+ */
+inline constexpr size_t MIN_MERGE_ELEMENTS_PER_THREAD = 1 << 16;
+
+/**
+ * @brief Merge two sorted ranges into an output buffer, taking from the first range on ties.
+ * The source of each element is picked with a select rather than a branch, as on random data the branch mispredicts half the time.
+ * @returns Pointer one past the last element written.
+ */
+template <typename T, typename Compare>
+T* mergeRanges(const T* a, const T* aEnd, const T* b, const T* bEnd, T* out, Compare& compare)
+{
+	while (a != aEnd && b != bEnd) {
+		const bool takeB = compare(*b, *a);
+
+		*out++ = takeB ? *b : *a;
+		b += takeB;
+		a += !takeB;
+	}
+
+	out = std::copy(a, aEnd, out);
+	return std::copy(b, bEnd, out);
+}
+
+/**
+ * @brief Find where a diagonal of the merge path crosses, so the first elements of a merge can be produced independently.
+ * @returns How many of the first diagonal output elements come from a, the rest come from b.
+ */
+template <typename T, typename Compare>
+size_t mergePathSplit(const T* a, size_t aCount, const T* b, size_t bCount, size_t diagonal, Compare& compare)
+{
+	size_t low = diagonal > bCount ? diagonal - bCount : 0;
+	size_t high = std::min(diagonal, aCount);
+
+	while (low < high) {
+		const size_t mid = low + (high - low) / 2;
+
+		// a[mid] is among the first diagonal elements unless the b element it would be paired with sorts strictly before it
+		if (compare(b[diagonal - mid - 1], a[mid])) {
+			high = mid;
+		} else {
+			low = mid + 1;
+		}
+	}
+
+	return low;
+}
+
+/**
+ * @brief Merge any number of sorted ranges into an output buffer with a loser tree.
+ * Every internal node of the tree holds the run which lost the match played there, so replacing the winner only replays
+ * the matches on its path to the root, log2(k) comparisons per element. Ties go to the earlier run, so the merge is stable.
+ * Only the run just taken from can run out, so that is the one check per element. An exhausted run's leaf is replaced by a
+ * sentinel which loses every match, and only its own path is replayed.
+ * @param positions Start of each range, advanced as elements are taken.
+ * @param ends End of each range.
+ * @param count Total number of elements in every range.
+ * @param out Buffer to write the merged elements to.
+ */
+template <typename T, typename Compare>
+void loserTreeMerge(DynamicArray<const T*>& positions, DynamicArray<const T*>& ends, size_t count, T* out, Compare& compare)
+{
+	const size_t runCount = positions.len();
+	const size_t leaves = std::bit_ceil(std::max<size_t>(runCount, 1));
+
+	// padding leaves and exhausted runs are all this index, which is past the last run
+	const size_t sentinel = leaves;
+
+	const T** pos = positions.data();
+	const T** end = ends.data();
+
+	// the sentinel loses to everything, and ties go to the earlier run with a single comparison
+	const auto beats = [&](size_t r, size_t s) {
+		if (s >= runCount) return true;
+		if (r >= runCount) return false;
+
+		return r < s ? !compare(*pos[s], *pos[r]) : compare(*pos[r], *pos[s]);
+	};
+
+	DynamicArray<size_t> losers, winners;
+	losers.resize(leaves);
+	winners.resize(2 * leaves);
+
+	size_t* tree = losers.data();
+	size_t* winner = winners.data();
+
+	for (size_t run = 0; run < leaves; ++run) {
+		winner[leaves + run] = run < runCount && pos[run] != end[run] ? run : sentinel;
+	}
+
+	for (size_t node = leaves - 1; node >= 1; --node) {
+		const size_t left = winner[2 * node], right = winner[2 * node + 1];
+		const bool leftWins = beats(left, right);
+
+		winner[node] = leftWins ? left : right;
+		tree[node] = leftWins ? right : left;
+	}
+
+	size_t champion = winner[1];
+
+	for (size_t i = 0; i < count; ++i) {
+		*out++ = *pos[champion]++;
+
+		const size_t leaf = champion + leaves;
+		if (pos[champion] == end[champion]) champion = sentinel;
+
+		for (size_t node = leaf / 2; node != 0; node /= 2) {
+			const size_t loser = tree[node];
+			const bool swap = beats(loser, champion);
+
+			tree[node] = swap ? champion : loser;
+			champion = swap ? loser : champion;
+		}
+	}
+}
+
+/**
+ * @brief A process wide pool of threads for the parallel merges, so a merge does not pay to start threads every call.
+ * Workers are started the first time a merge needs them and kept until exit. Every run queues its own job, and merges
+ * started from several threads at once share the workers between them. The calling thread works through whatever
+ * indices of its own job no worker has taken yet, so a run started from inside another run, or from a worker,
+ * never waits on a worker which is itself waiting.
+ */
+class MergeThreadPool
+{
+private:
+	// one call to run, with its own count of indices still to finish and its own signal for when they have
+	struct Job
+	{
+		const std::function<void(size_t)>* function = nullptr;
+		size_t count = 0, next = 1, pending = 0;
+		std::exception_ptr error;
+		std::condition_variable done;
+	};
+
+	std::mutex m_Mutex;
+	std::condition_variable m_WorkReady;
+	std::vector<std::thread> m_Workers;
+
+	// jobs which still have indices no thread has taken
+	std::deque<Job*> m_Jobs;
+	bool m_Stopping = false;
+
+	MergeThreadPool() = default;
+
+	void work();
+	void execute(std::unique_lock<std::mutex>& lock, Job& job, size_t index);
+
+public:
+	MergeThreadPool(const MergeThreadPool& other) = delete;
+	MergeThreadPool& operator=(const MergeThreadPool& other) = delete;
+
+	~MergeThreadPool();
+
+	/**
+	 * @brief Returns the process wide pool.
+	 * @returns The pool.
+	 */
+	static MergeThreadPool& instance();
+
+	/**
+	 * @brief Run a function once for each thread index, index 0 on the calling thread and the rest on pool workers.
+	 * Returns once every index has finished, rethrowing the first exception any of them threw.
+	 * @param threadCount Number of thread indices to run.
+	 * @param function Function taking the thread index.
+	 */
+	void run(size_t threadCount, const std::function<void(size_t)>& function);
+};
+
+inline MergeThreadPool::~MergeThreadPool()
+{
+	{
+		std::lock_guard lock(m_Mutex);
+		m_Stopping = true;
+	}
+	m_WorkReady.notify_all();
+
+	for (auto& worker : m_Workers) {
+		worker.join();
+	}
+}
+
+inline MergeThreadPool& MergeThreadPool::instance()
+{
+	static MergeThreadPool pool;
+	return pool;
+}
+
+inline void MergeThreadPool::execute(std::unique_lock<std::mutex>& lock, Job& job, size_t index)
+{
+	lock.unlock();
+
+	std::exception_ptr error;
+	try {
+		(*job.function)(index);
+	} catch (...) {
+		error = std::current_exception();
+	}
+
+	lock.lock();
+
+	if (error != nullptr && job.error == nullptr) job.error = error;
+
+	// the job lives on its caller's stack, so it must not be touched once the caller can see it is done
+	if (--job.pending == 0) job.done.notify_one();
+}
+
+inline void MergeThreadPool::work()
+{
+	std::unique_lock lock(m_Mutex);
+
+	while (true) {
+		m_WorkReady.wait(lock, [&]() { return m_Stopping || !m_Jobs.empty(); });
+		if (m_Stopping) return;
+
+		Job& job = *m_Jobs.front();
+		const size_t index = job.next++;
+		if (job.next == job.count) m_Jobs.pop_front();
+
+		execute(lock, job, index);
+	}
+}
+
+inline void MergeThreadPool::run(size_t threadCount, const std::function<void(size_t)>& function)
+{
+	if (threadCount <= 1) {
+		function(0);
+		return;
+	}
+
+	Job job;
+	job.function = &function;
+	job.count = job.pending = threadCount;
+
+	{
+		std::lock_guard lock(m_Mutex);
+
+		while (m_Workers.size() < threadCount - 1) {
+			m_Workers.emplace_back(&MergeThreadPool::work, this);
+		}
+
+		m_Jobs.push_back(&job);
+	}
+	m_WorkReady.notify_all();
+
+	std::unique_lock lock(m_Mutex);
+	execute(lock, job, 0);
+
+	// take back any indices the workers have not got to, rather than waiting on workers busy with other jobs
+	while (job.next < job.count) {
+		const size_t index = job.next++;
+		if (job.next == job.count) m_Jobs.erase(std::find(m_Jobs.begin(), m_Jobs.end(), &job));
+
+		execute(lock, job, index);
+	}
+
+	job.done.wait(lock, [&]() { return job.pending == 0; });
+
+	if (job.error != nullptr) std::rethrow_exception(job.error);
+}
+
+/**
+ * @brief Run a function once for each thread index on the merge thread pool, with index 0 on the calling thread.
+ */
+template <typename Function>
+void runOnThreads(size_t threadCount, Function&& function)
+{
+	MergeThreadPool::instance().run(threadCount, std::ref(function));
+}
+
+/**
+ * @brief Merge two sorted arrays into a new sorted array.
+ * The output is allocated once. With more than one thread, the output is cut into equal slices
+ * and merge path partitioning finds where each slice starts in both inputs, so each thread merges its slice independently.
+ * @param a First sorted array, its elements come first on ties.
+ * @param b Second sorted array.
+ * @param threadCount Number of threads to merge with.
+ * @param compare Function object the arrays are sorted by.
+ * @returns Sorted array of every element of both arrays.
+ */
+template <typename T, typename Compare = std::less<T>>
+DynamicArray<T> mergeSorted(const DynamicArray<T>& a, const DynamicArray<T>& b, size_t threadCount = 1, Compare compare = Compare())
+{
+	DynamicArray<T> merged;
+
+	const size_t total = a.len() + b.len();
+	if (total == 0) return merged;
+
+	merged.resize(total);
+	threadCount = std::max<size_t>(1, std::min(threadCount, total / MIN_MERGE_ELEMENTS_PER_THREAD));
+
+	const T* aData = a.data();
+	const T* bData = b.data();
+	T* out = merged.data();
+
+	runOnThreads(threadCount, [&](size_t thread) {
+		Compare threadCompare = compare;
+
+		const size_t begin = total * thread / threadCount, end = total * (thread + 1) / threadCount;
+		const size_t aBegin = mergePathSplit(aData, a.len(), bData, b.len(), begin, threadCompare);
+		const size_t aEnd = mergePathSplit(aData, a.len(), bData, b.len(), end, threadCompare);
+
+		mergeRanges(aData + aBegin, aData + aEnd, bData + (begin - aBegin), bData + (end - aEnd), out + begin, threadCompare);
+	});
+
+	return merged;
+}
+
+/**
+ * @brief Merge any number of sorted arrays into a new sorted array with a loser tree.
+ * The output is allocated once. With more than one thread, splitter values are sampled from every run and each run is cut
+ * at the splitters, the k way analogue of merge path partitioning, so each thread merges its own slice of every run.
+ * Slices are only as even as the samples, and equal elements always share a slice.
+ * @param runs Sorted arrays to merge, earlier runs' elements come first on ties.
+ * @param threadCount Number of threads to merge with.
+ * @param compare Function object the arrays are sorted by.
+ * @returns Sorted array of every element of every run.
+ */
+template <typename T, typename Compare = std::less<T>>
+DynamicArray<T> kWayMerge(std::span<const DynamicArray<T>> runs, size_t threadCount = 1, Compare compare = Compare())
+{
+	constexpr size_t SAMPLES_PER_THREAD = 32;
+
+	if (runs.size() == 1) return runs[0];
+	if (runs.size() == 2) return mergeSorted(runs[0], runs[1], threadCount, compare);
+
+	DynamicArray<T> merged;
+
+	size_t total = 0;
+	for (const auto& run : runs) {
+		total += run.len();
+	}
+
+	if (total == 0) return merged;
+
+	merged.resize(total);
+	threadCount = std::max<size_t>(1, std::min(threadCount, total / MIN_MERGE_ELEMENTS_PER_THREAD));
+
+	const size_t runCount = runs.size();
+
+	// cuts[t * runCount + r] is where thread t's slice of run r starts, the last row holds the end of every run
+	DynamicArray<size_t> cuts;
+	cuts.resize((threadCount + 1) * runCount);
+
+	for (size_t run = 0; run < runCount; ++run) {
+		cuts[threadCount * runCount + run] = runs[run].len();
+	}
+
+	if (threadCount > 1) {
+		DynamicArray<T> samples;
+
+		for (const auto& run : runs) {
+			const size_t sampleCount = std::min(run.len(), SAMPLES_PER_THREAD * threadCount);
+
+			for (size_t i = 0; i < sampleCount; ++i) {
+				samples.append(run[run.len() * i / sampleCount]);
+			}
+		}
+
+		std::sort(samples.data(), samples.data() + samples.len(), compare);
+
+		for (size_t thread = 1; thread < threadCount; ++thread) {
+			const T& splitter = samples[samples.len() * thread / threadCount];
+
+			// everything before the splitter goes left in every run, so equal elements never straddle two slices
+			for (size_t run = 0; run < runCount; ++run) {
+				const T* data = runs[run].data();
+				cuts[thread * runCount + run] = runs[run].isEmpty() ? 0 : std::lower_bound(data, data + runs[run].len(), splitter, compare) - data;
+			}
+		}
+	}
+
+	T* out = merged.data();
+
+	runOnThreads(threadCount, [&](size_t thread) {
+		Compare threadCompare = compare;
+
+		DynamicArray<const T*> positions, ends;
+		size_t offset = 0, count = 0;
+
+		for (size_t run = 0; run < runCount; ++run) {
+			const size_t begin = cuts[thread * runCount + run], end = cuts[(thread + 1) * runCount + run];
+
+			offset += begin;
+			count += end - begin;
+
+			positions.append(runs[run].data() + begin);
+			ends.append(runs[run].data() + end);
+		}
+
+		loserTreeMerge(positions, ends, count, out + offset, threadCompare);
+	});
+
+	return merged;
+}
@@ -0,0 +1,364 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86)
+	#include <intrin.h>
+	#define BENCHMARK_TSC
+#elif defined(__x86_64__) || defined(__i386__)
+	#include <x86intrin.h>
+	#define BENCHMARK_TSC
+#endif
+
+#ifdef __linux__
+	#include <linux/perf_event.h>
+	#include <sys/ioctl.h>
+	#include <sys/syscall.h>
+	#include <unistd.h>
+#endif
+
+/**
+ * @brief Hardware counters which are read around each measured operation.
+ */
+enum class HardwareCounter
+{
+	Cycles,
+	Instructions,
+	CacheMisses,
+	BranchMisses,
+	DtlbMisses,
+	Count
+};
+
+inline constexpr std::array<const char*, static_cast<size_t>(HardwareCounter::Count)> HARDWARE_COUNTER_NAMES = {
+	"cycles", "instructions", "cache_misses", "branch_misses", "dtlb_misses"
+};
+
+/**
+ * @brief The measurements of one operation on one container, element type and size.
+ * Every per op value is averaged over every run of the operation.
+ */
+struct BenchmarkResult
+{
+	std::string suite;
+	std::string container;
+	std::string type;
+	std::string operation;
+	size_t size = 0;
+	size_t ops = 0;
+	double nsPerOp = 0.0;
+	double allocationsPerOp = 0.0;
+	std::array<std::optional<double>, static_cast<size_t>(HardwareCounter::Count)> countersPerOp;
+};
+
+/**
+ * @brief Hardware performance counters read through perf_event_open.
+ * Counters the kernel refuses to open, or every counter on other platforms, are reported as unavailable.
+ * When the cycle counter is unavailable on x86, cycles are counted with the time stamp counter instead,
+ * which ticks at a fixed reference rate rather than the core's actual clock.
+ */
+class PerfCounters
+{
+private:
+	std::array<int, static_cast<size_t>(HardwareCounter::Count)> m_Fds;
+	std::array<uint64_t, static_cast<size_t>(HardwareCounter::Count)> m_Totals = {};
+	bool m_UseTsc = false;
+	uint64_t m_TscStart = 0;
+
+	int openCounter(uint32_t type, uint64_t config, int groupFd);
+
+public:
+	PerfCounters();
+	~PerfCounters();
+
+	PerfCounters(const PerfCounters& other) = delete;
+	PerfCounters& operator=(const PerfCounters& other) = delete;
+
+	/**
+	 * @brief Zero the running totals of every counter.
+	 */
+	void reset();
+
+	/**
+	 * @brief Start counting.
+	 */
+	void start();
+
+	/**
+	 * @brief Stop counting and add the counts since start to the running totals.
+	 */
+	void stop();
+
+	/**
+	 * @brief Returns the running total of a counter.
+	 * @param counter Counter to return.
+	 * @returns The total, or nothing if the counter could not be opened.
+	 */
+	[[nodiscard]] std::optional<uint64_t> total(HardwareCounter counter) const;
+
+	/**
+	 * @brief Returns whether cycles are counted with the time stamp counter because the hardware counters are unavailable.
+	 * @returns If cycles are reference cycles from the time stamp counter.
+	 */
+	[[nodiscard]] bool usesTimeStampCounter() const;
+};
+
+/**
+ * @brief Collects benchmark results and writes them out as CSV or JSON.
+ */
+class BenchmarkReport
+{
+private:
+	std::vector<BenchmarkResult> m_Results;
+
+public:
+	/**
+	 * @brief Add a result to the report and print a one line summary of it to stderr.
+	 * @param result Result to add.
+	 */
+	void add(const BenchmarkResult& result);
+
+	/**
+	 * @brief Write every result as CSV, one row per result.
+	 * @param os Stream to write to.
+	 */
+	void writeCsv(std::ostream& os) const;
+
+	/**
+	 * @brief Write every result as a JSON array of objects.
+	 * @param os Stream to write to.
+	 */
+	void writeJson(std::ostream& os) const;
+};
+
+/**
+ * @brief Repeatedly set up and time an operation until enough time has been measured.
+ * Only the operation itself is timed and counted, setup and tear down are not.
+ * Very quick operations with slow setups stop early once the whole benchmark has taken too long.
+ * @param counters Hardware counters to read around the operation.
+ * @param opsPerRun Number of operations each call to operation performs.
+ * @param allocations Function returning the running total of allocations.
+ * @param setup Function returning fresh state for one run.
+ * @param operation Function performing the operations on the state.
+ * @returns Result with the timing, allocation and counter fields filled in.
+ */
+template <typename Allocations, typename Setup, typename Operation>
+BenchmarkResult measure(PerfCounters& counters, size_t opsPerRun, Allocations&& allocations, Setup&& setup, Operation&& operation)
+{
+	using Clock = std::chrono::steady_clock;
+
+	constexpr double MIN_MEASURED_NS = 20'000'000.0;
+	constexpr auto MAX_TOTAL_TIME = std::chrono::seconds(1);
+	constexpr size_t MAX_RUNS = 100'000;
+
+	const auto began = Clock::now();
+	double totalNs = 0.0;
+	size_t runs = 0, totalAllocations = 0;
+
+	counters.reset();
+
+	while (runs == 0 || (totalNs < MIN_MEASURED_NS && runs < MAX_RUNS && Clock::now() - began < MAX_TOTAL_TIME)) {
+		auto state = setup();
+		const size_t allocationsBefore = allocations();
+
+		counters.start();
+		const auto start = Clock::now();
+
+		operation(state);
+
+		const auto end = Clock::now();
+		counters.stop();
+
+		totalAllocations += allocations() - allocationsBefore;
+		totalNs += std::chrono::duration<double, std::nano>(end - start).count();
+		++runs;
+	}
+
+	const auto totalOps = static_cast<double>(runs * opsPerRun);
+
+	BenchmarkResult result;
+	result.ops = opsPerRun;
+	result.nsPerOp = totalNs / totalOps;
+	result.allocationsPerOp = static_cast<double>(totalAllocations) / totalOps;
+
+	for (size_t i = 0; i < result.countersPerOp.size(); ++i) {
+		if (const auto total = counters.total(static_cast<HardwareCounter>(i))) {
+			result.countersPerOp[i] = static_cast<double>(*total) / totalOps;
+		}
+	}
+
+	return result;
+}
+
+inline PerfCounters::PerfCounters()
+{
+	m_Fds.fill(-1);
+
+#ifdef __linux__
+	// cycles leads the group so every counter is scheduled onto the PMU together
+	m_Fds[0] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, -1);
+
+	if (m_Fds[0] >= 0) {
+		m_Fds[1] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, m_Fds[0]);
+		m_Fds[2] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, m_Fds[0]);
+		m_Fds[3] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, m_Fds[0]);
+		m_Fds[4] = openCounter(PERF_TYPE_HW_CACHE,
+			PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16), m_Fds[0]);
+	}
+#endif
+
+#ifdef BENCHMARK_TSC
+	m_UseTsc = m_Fds[0] < 0;
+#endif
+}
+
+inline PerfCounters::~PerfCounters()
+{
+#ifdef __linux__
+	for (const int fd : m_Fds) {
+		if (fd >= 0) close(fd);
+	}
+#endif
+}
+
+inline int PerfCounters::openCounter(uint32_t type, uint64_t config, int groupFd)
+{
+#ifdef __linux__
+	perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+
+	attr.size = sizeof(attr);
+	attr.type = type;
+	attr.config = config;
+	attr.disabled = groupFd < 0;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+
+	return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, 0));
+#else
+	return -1;
+#endif
+}
+
+inline void PerfCounters::reset()
+{
+	m_Totals.fill(0);
+}
+
+inline void PerfCounters::start()
+{
+#ifdef BENCHMARK_TSC
+	if (m_UseTsc) {
+		m_TscStart = __rdtsc();
+		return;
+	}
+#endif
+
+#ifdef __linux__
+	if (m_Fds[0] < 0) return;
+
+	ioctl(m_Fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+	ioctl(m_Fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+}
+
+inline void PerfCounters::stop()
+{
+#ifdef BENCHMARK_TSC
+	if (m_UseTsc) {
+		m_Totals[0] += __rdtsc() - m_TscStart;
+		return;
+	}
+#endif
+
+#ifdef __linux__
+	if (m_Fds[0] < 0) return;
+
+	ioctl(m_Fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+	for (size_t i = 0; i < m_Fds.size(); ++i) {
+		uint64_t value = 0;
+
+		if (m_Fds[i] >= 0 && read(m_Fds[i], &value, sizeof(value)) == sizeof(value)) {
+			m_Totals[i] += value;
+		}
+	}
+#endif
+}
+
+inline std::optional<uint64_t> PerfCounters::total(HardwareCounter counter) const
+{
+	const auto i = static_cast<size_t>(counter);
+	if (m_Fds[i] < 0 && !(m_UseTsc && counter == HardwareCounter::Cycles)) return std::nullopt;
+
+	return m_Totals[i];
+}
+
+inline bool PerfCounters::usesTimeStampCounter() const
+{
+	return m_UseTsc;
+}
+
+inline void BenchmarkReport::add(const BenchmarkResult& result)
+{
+	m_Results.push_back(result);
+
+	std::cerr << result.container << "<" << result.type << "> " << result.operation << " n=" << result.size
+		<< ": " << result.nsPerOp << " ns/op" << std::endl;
+}
+
+inline void BenchmarkReport::writeCsv(std::ostream& os) const
+{
+	os << "suite,container,type,operation,size,ops,ns_per_op,allocations_per_op";
+	for (const char* name : HARDWARE_COUNTER_NAMES) {
+		os << "," << name << "_per_op";
+	}
+	os << "\n";
+
+	for (const auto& result : m_Results) {
+		os << result.suite << "," << result.container << "," << result.type << "," << result.operation << ","
+			<< result.size << "," << result.ops << "," << result.nsPerOp << "," << result.allocationsPerOp;
+
+		// unavailable counters are left empty
+		for (const auto& counter : result.countersPerOp) {
+			os << ",";
+			if (counter) os << *counter;
+		}
+		os << "\n";
+	}
+}
+
+inline void BenchmarkReport::writeJson(std::ostream& os) const
+{
+	os << "[\n";
+
+	for (size_t i = 0; i < m_Results.size(); ++i) {
+		const auto& result = m_Results[i];
+
+		os << "  {\"suite\": \"" << result.suite << "\", \"container\": \"" << result.container
+			<< "\", \"type\": \"" << result.type << "\", \"operation\": \"" << result.operation
+			<< "\", \"size\": " << result.size << ", \"ops\": " << result.ops
+			<< ", \"ns_per_op\": " << result.nsPerOp << ", \"allocations_per_op\": " << result.allocationsPerOp;
+
+		for (size_t counter = 0; counter < result.countersPerOp.size(); ++counter) {
+			os << ", \"" << HARDWARE_COUNTER_NAMES[counter] << "_per_op\": ";
+
+			if (result.countersPerOp[counter]) {
+				os << *result.countersPerOp[counter];
+			} else {
+				os << "null";
+			}
+		}
+
+		os << "}" << (i + 1 < m_Results.size() ? ",\n" : "\n");
+	}
+
+	os << "]\n";
+}
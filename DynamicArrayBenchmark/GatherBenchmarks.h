@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <string>
+
+#include "../DynamicArray/DynamicArray.h"
+#include "Benchmark.h"
+
+/**
+ * @brief Compare indexing an array at random positions one element at a time against gather and scatter,
+ * with and without prefetching, for an array which fits in cache and one which does not.
+ * @param report Report to add the results to.
+ * @param counters Hardware counters to read, cache misses per op show whether prefetching hid the misses.
+ * @param megabytes Size of the out of cache array.
+ */
+inline void benchmarkGather(BenchmarkReport& report, PerfCounters& counters, size_t megabytes)
+{
+	constexpr size_t IN_CACHE_COUNT = 32 * 1024;
+	constexpr size_t INDEX_COUNT = 1 << 22;
+
+	const size_t outOfCacheCount = megabytes * 1024 * 1024 / sizeof(uint64_t);
+
+	DynamicArray<uint64_t> out, values;
+	out.resize(INDEX_COUNT);
+	values.resize(INDEX_COUNT, 1);
+
+	volatile uint64_t sink = 0;
+
+	const auto noAllocations = []() { return size_t(0); };
+	const auto noState = []() { return 0; };
+
+	for (const size_t count : { IN_CACHE_COUNT, outOfCacheCount }) {
+		DynamicArray<uint64_t> arr;
+		arr.reserve(count);
+
+		for (size_t i = 0; i < count; ++i) {
+			arr.append(i);
+		}
+
+		std::mt19937_64 random(count);
+		DynamicArray<size_t> indices;
+		indices.reserve(INDEX_COUNT);
+
+		for (size_t i = 0; i < INDEX_COUNT; ++i) {
+			indices.append(random() % count);
+		}
+
+		const std::span<const size_t> indexSpan(indices.data(), indices.len());
+
+		const auto record = [&](const std::string& operation, BenchmarkResult result) {
+			result.suite = "gather";
+			result.container = "DynamicArray";
+			result.type = "uint64_t";
+			result.operation = operation;
+			result.size = count;
+			report.add(result);
+		};
+
+		record("index_naive", measure(counters, INDEX_COUNT, noAllocations, noState, [&](int&) {
+			for (size_t i = 0; i < INDEX_COUNT; ++i) {
+				out[i] = arr[indices[i]];
+			}
+			sink = out[INDEX_COUNT - 1];
+		}));
+
+		for (const size_t distance : { size_t(0), size_t(4), DynamicArray<uint64_t>::DEFAULT_PREFETCH_DISTANCE, size_t(64) }) {
+			record("gather_prefetch_" + std::to_string(distance), measure(counters, INDEX_COUNT, noAllocations, noState, [&](int&) {
+				arr.gather(indexSpan, out.data(), distance);
+				sink = out[INDEX_COUNT - 1];
+			}));
+		}
+
+		record("scatter_naive", measure(counters, INDEX_COUNT, noAllocations, noState, [&](int&) {
+			for (size_t i = 0; i < INDEX_COUNT; ++i) {
+				arr[indices[i]] = values[i];
+			}
+		}));
+
+		for (const size_t distance : { size_t(0), DynamicArray<uint64_t>::DEFAULT_PREFETCH_DISTANCE }) {
+			record("scatter_prefetch_" + std::to_string(distance), measure(counters, INDEX_COUNT, noAllocations, noState, [&](int&) {
+				arr.scatter(indexSpan, values.data(), distance);
+			}));
+		}
+	}
+}
@@ -0,0 +1,90 @@
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "Benchmark.h"
+#include "GatherBenchmarks.h"
+#include "MergeBenchmarks.h"
+#include "OperationBenchmarks.h"
+#include "PageBenchmarks.h"
+
+/**
+ * @brief Benchmark DynamicArray against std::vector, 4K against huge pages, gather against naive indexing,
+ * and k way merging against sorting.
+ * Usage: DynamicArrayBenchmark [--suite operations|pages|gather|merge|all] [--max-size N] [--page-mb N] [--gather-mb N]
+ *                              [--merge-size N] [--numa bind|interleave] [--json FILE] [--csv FILE]
+ * Results are written as CSV to stdout unless a JSON or CSV file is given.
+ * Operation sizes go up in powers of ten from 10 to the max size, which defaults to 10^6. 10^8 needs ~15 GB for the 64 byte POD.
+ */
+int main(int argc, char** argv)
+{
+	std::string suite = "operations", jsonPath, csvPath;
+	size_t maxSize = 1'000'000, pageMegabytes = 1024, gatherMegabytes = 512, mergeSize = 1 << 24;
+	MemoryPlacement placement;
+
+	for (int i = 1; i + 1 < argc; i += 2) {
+		const std::string option = argv[i], value = argv[i + 1];
+
+		if (option == "--suite") suite = value;
+		else if (option == "--max-size") maxSize = std::stoull(value);
+		else if (option == "--page-mb") pageMegabytes = std::stoull(value);
+		else if (option == "--gather-mb") gatherMegabytes = std::stoull(value);
+		else if (option == "--merge-size") mergeSize = std::stoull(value);
+		else if (option == "--json") jsonPath = value;
+		else if (option == "--csv") csvPath = value;
+		else if (option == "--numa") {
+			if (value == "bind") placement.numaPolicy = NumaPolicy::Bind;
+			else if (value == "interleave") {
+				placement.numaPolicy = NumaPolicy::Interleave;
+				placement.numaNodeMask = ~uint64_t(0);
+			} else {
+				std::cerr << "Unknown numa policy " << value << std::endl;
+				return 1;
+			}
+		} else {
+			std::cerr << "Unknown option " << option << std::endl;
+			return 1;
+		}
+	}
+
+	BenchmarkReport report;
+	PerfCounters counters;
+
+	if (counters.usesTimeStampCounter()) {
+		std::cerr << "Hardware counters are unavailable, cycles are time stamp counter reference cycles and the other counter columns will be empty." << std::endl;
+	} else if (!counters.total(HardwareCounter::Cycles)) {
+		std::cerr << "Hardware counters are unavailable, counter columns will be empty." << std::endl;
+	}
+
+	if (suite == "operations" || suite == "all") {
+		benchmarkAllOperations(report, counters, maxSize);
+	}
+
+	if (suite == "pages" || suite == "all") {
+		benchmarkPages(report, counters, pageMegabytes, placement);
+	}
+
+	if (suite == "gather" || suite == "all") {
+		benchmarkGather(report, counters, gatherMegabytes);
+	}
+
+	if (suite == "merge" || suite == "all") {
+		benchmarkMerge(report, counters, mergeSize);
+	}
+
+	if (!jsonPath.empty()) {
+		std::ofstream json(jsonPath);
+		report.writeJson(json);
+	}
+
+	if (!csvPath.empty()) {
+		std::ofstream csv(csvPath);
+		report.writeCsv(csv);
+	}
+
+	if (jsonPath.empty() && csvPath.empty()) {
+		report.writeCsv(std::cout);
+	}
+
+	return 0;
+}
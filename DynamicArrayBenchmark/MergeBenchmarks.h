@@ -0,0 +1,82 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <span>
+#include <string>
+#include <thread>
+
+#include "../DynamicArray/DynamicArray.h"
+#include "../DynamicArray/SortedMerge.h"
+#include "Benchmark.h"
+
+/**
+ * @brief Compare merging 64 sorted runs with kWayMerge, on one thread and on every hardware thread,
+ * against sorting their concatenation.
+ * @param report Report to add the results to.
+ * @param counters Hardware counters to read.
+ * @param total Total number of elements across every run.
+ */
+inline void benchmarkMerge(BenchmarkReport& report, PerfCounters& counters, size_t total)
+{
+	constexpr size_t RUN_COUNT = 64;
+
+	std::mt19937_64 random(total);
+	DynamicArray<DynamicArray<uint64_t>> runs;
+
+	for (size_t run = 0; run < RUN_COUNT; ++run) {
+		DynamicArray<uint64_t> values;
+		values.reserve(total / RUN_COUNT);
+
+		for (size_t i = 0; i < total / RUN_COUNT; ++i) {
+			values.append(random());
+		}
+
+		std::sort(values.data(), values.data() + values.len());
+		runs.append(std::move(values));
+	}
+
+	const std::span<const DynamicArray<uint64_t>> runSpan(runs.data(), runs.len());
+	const size_t count = total / RUN_COUNT * RUN_COUNT;
+	const size_t hardwareThreads = std::max<size_t>(1, std::thread::hardware_concurrency());
+
+	volatile uint64_t sink = 0;
+
+	// DynamicArray is benchmarked without DYNAMIC_ARRAY_STATS, so allocations inside kWayMerge are not counted
+	const auto noAllocations = []() { return size_t(0); };
+	const auto noState = []() { return 0; };
+
+	const auto record = [&](const std::string& operation, BenchmarkResult result) {
+		result.suite = "merge";
+		result.container = "DynamicArray";
+		result.type = "uint64_t";
+		result.operation = operation;
+		result.size = count;
+		report.add(result);
+	};
+
+	record("sort_concatenation", measure(counters, count, noAllocations, noState, [&](int&) {
+		DynamicArray<uint64_t> merged;
+		merged.reserve(count);
+
+		for (size_t run = 0; run < runs.len(); ++run) {
+			for (size_t i = 0; i < runs[run].len(); ++i) {
+				merged.append(runs[run][i]);
+			}
+		}
+
+		std::sort(merged.data(), merged.data() + merged.len());
+		sink = merged[count / 2];
+	}));
+
+	const auto merge = [&](size_t threads) {
+		record("kway_merge_" + std::to_string(threads) + "_threads", measure(counters, count, noAllocations, noState, [&](int&) {
+			const DynamicArray<uint64_t> merged = kWayMerge(runSpan, threads);
+			sink = merged[count / 2];
+		}));
+	};
+
+	merge(1);
+	if (hardwareThreads > 1) merge(hardwareThreads);
+}
@@ -0,0 +1,334 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../DynamicArray/DynamicArray.h"
+#include "Benchmark.h"
+
+/**
+ * @brief A plain 64 byte element, one cache line per element.
+ */
+struct Pod64
+{
+	uint64_t values[8] = {};
+
+	bool operator==(const Pod64& other) const = default;
+};
+
+/**
+ * @brief Returns the i'th distinct value of a given element type.
+ */
+template <typename T>
+T makeValue(size_t i);
+
+template <>
+inline int makeValue<int>(size_t i)
+{
+	return static_cast<int>(i);
+}
+
+template <>
+inline Pod64 makeValue<Pod64>(size_t i)
+{
+	Pod64 value;
+	value.values[0] = i;
+	return value;
+}
+
+template <>
+inline std::string makeValue<std::string>(size_t i)
+{
+	// long enough to not fit in the small string buffer, so every string owns a heap allocation
+	return "dynamic-array-benchmark-" + std::to_string(i);
+}
+
+template <typename T>
+inline const char* TYPE_NAME = "";
+
+template <>
+inline const char* TYPE_NAME<int> = "int";
+
+template <>
+inline const char* TYPE_NAME<Pod64> = "pod64";
+
+template <>
+inline const char* TYPE_NAME<std::string> = "string";
+
+/**
+ * @brief Global count of allocations made by CountingAllocator.
+ */
+inline std::atomic<size_t> g_VectorAllocations = 0;
+
+/**
+ * @brief std::allocator which counts its allocations, so std::vector can report allocations like DynamicArray does.
+ */
+template <typename T>
+struct CountingAllocator : std::allocator<T>
+{
+	using value_type = T;
+
+	template <typename U>
+	struct rebind
+	{
+		using other = CountingAllocator<U>;
+	};
+
+	CountingAllocator() = default;
+
+	template <typename U>
+	CountingAllocator(const CountingAllocator<U>&) {}
+
+	T* allocate(size_t count)
+	{
+		g_VectorAllocations.fetch_add(1, std::memory_order_relaxed);
+		return std::allocator<T>::allocate(count);
+	}
+};
+
+/**
+ * @brief Global count of allocations made by DynamicArrays in the benchmarked operations.
+ */
+inline std::atomic<size_t> g_DynamicArrayAllocations = 0;
+
+/**
+ * @brief Runs the benchmarked operations on a DynamicArray.
+ * DynamicArray is benchmarked without DYNAMIC_ARRAY_STATS, so its allocations are counted here instead, as a change
+ * to a non-zero capacity, which is only ever a new buffer.
+ */
+template <typename T>
+struct DynamicArrayOperations
+{
+	using Container = DynamicArray<T>;
+
+	static constexpr const char* NAME = "DynamicArray";
+
+	static void countAllocation(const Container& container, size_t capacityBefore)
+	{
+		if (container.capacity() != capacityBefore && container.capacity() != 0) {
+			g_DynamicArrayAllocations.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	static void append(Container& container, const T& value)
+	{
+		const size_t capacity = container.capacity();
+		container.append(value);
+		countAllocation(container, capacity);
+	}
+
+	static void insert(Container& container, size_t pos, const T& value)
+	{
+		const size_t capacity = container.capacity();
+		container.insert(pos, value);
+		countAllocation(container, capacity);
+	}
+
+	static void remove(Container& container, const T& value)
+	{
+		const size_t capacity = container.capacity();
+		container.remove(value);
+		countAllocation(container, capacity);
+	}
+
+	static T pop(Container& container)
+	{
+		const size_t capacity = container.capacity();
+		T value = container.pop();
+		countAllocation(container, capacity);
+		return value;
+	}
+
+	static size_t index(const Container& container, const T& value) { return container.index(value); }
+	static size_t count(const Container& container, const T& value) { return container.count(value); }
+
+	static void reserve(Container& container, size_t count)
+	{
+		const size_t capacity = container.capacity();
+		container.reserve(count);
+		countAllocation(container, capacity);
+	}
+
+	static void copy(Container& target, const Container& source)
+	{
+		target = source;
+		if (target.capacity() != 0) g_DynamicArrayAllocations.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	static size_t len(const Container& container) { return container.len(); }
+
+	static size_t allocations()
+	{
+		return g_DynamicArrayAllocations.load(std::memory_order_relaxed);
+	}
+};
+
+/**
+ * @brief Runs the benchmarked operations on a std::vector, as a baseline.
+ */
+template <typename T>
+struct VectorOperations
+{
+	using Container = std::vector<T, CountingAllocator<T>>;
+
+	static constexpr const char* NAME = "std::vector";
+
+	static void append(Container& container, const T& value) { container.push_back(value); }
+	static void insert(Container& container, size_t pos, const T& value) { container.insert(container.begin() + pos, value); }
+	static void remove(Container& container, const T& value) { container.erase(std::find(container.begin(), container.end(), value)); }
+	static T pop(Container& container)
+	{
+		// return the popped value like DynamicArray does, so the pops can not be optimised away
+		T value = std::move(container.back());
+		container.pop_back();
+		return value;
+	}
+	static size_t index(const Container& container, const T& value) { return std::find(container.begin(), container.end(), value) - container.begin(); }
+	static size_t count(const Container& container, const T& value) { return std::count(container.begin(), container.end(), value); }
+	static void reserve(Container& container, size_t count) { container.reserve(count); }
+	static void copy(Container& target, const Container& source) { target = source; }
+	static size_t len(const Container& container) { return container.size(); }
+
+	static size_t allocations()
+	{
+		return g_VectorAllocations.load(std::memory_order_relaxed);
+	}
+};
+
+/**
+ * @brief Run every operation for one container and element type at one size.
+ * Operations which are linear in the size are repeated fewer times on larger arrays so each size takes a similar time.
+ * @tparam Operations DynamicArrayOperations or VectorOperations.
+ * @tparam T Element type.
+ */
+template <template <typename> typename Operations, typename T>
+void benchmarkOperations(BenchmarkReport& report, PerfCounters& counters, size_t size)
+{
+	using Ops = Operations<T>;
+	using Container = typename Ops::Container;
+
+	const size_t repeats = std::clamp<size_t>(10'000'000 / size, 1, 1000);
+	const size_t removals = std::max<size_t>(1, std::min(repeats, size / 2));
+
+	const auto filled = [size]() {
+		Container container;
+		Ops::reserve(container, size);
+
+		for (size_t i = 0; i < size; ++i) {
+			Ops::append(container, makeValue<T>(i));
+		}
+
+		return container;
+	};
+
+	const auto empty = []() { return Container(); };
+
+	const auto record = [&](const char* operation, BenchmarkResult result) {
+		result.suite = "operations";
+		result.container = Ops::NAME;
+		result.type = TYPE_NAME<T>;
+		result.operation = operation;
+		result.size = size;
+		report.add(result);
+	};
+
+	const T value = makeValue<T>(size);
+	volatile size_t sink = 0;
+
+	record("append", measure(counters, size, Ops::allocations, empty, [&](Container& container) {
+		for (size_t i = 0; i < size; ++i) {
+			Ops::append(container, value);
+		}
+	}));
+
+	record("insert_front", measure(counters, repeats, Ops::allocations, filled, [&](Container& container) {
+		for (size_t i = 0; i < repeats; ++i) {
+			Ops::insert(container, 0, value);
+		}
+	}));
+
+	record("insert_middle", measure(counters, repeats, Ops::allocations, filled, [&](Container& container) {
+		for (size_t i = 0; i < repeats; ++i) {
+			Ops::insert(container, Ops::len(container) / 2, value);
+		}
+	}));
+
+	record("insert_back", measure(counters, repeats, Ops::allocations, filled, [&](Container& container) {
+		for (size_t i = 0; i < repeats; ++i) {
+			Ops::insert(container, Ops::len(container), value);
+		}
+	}));
+
+	// remove values from the middle onwards, each one needs a search and a shift of the back half
+	std::vector<T> middleValues;
+	for (size_t i = 0; i < removals; ++i) {
+		middleValues.push_back(makeValue<T>(size / 2 + i));
+	}
+
+	record("remove", measure(counters, removals, Ops::allocations, filled, [&](Container& container) {
+		for (const T& middle : middleValues) {
+			Ops::remove(container, middle);
+		}
+	}));
+
+	record("pop", measure(counters, size, Ops::allocations, filled, [&](Container& container) {
+		for (size_t i = 0; i < size; ++i) {
+			const T popped = Ops::pop(container);
+			sink = sink + (popped == value);
+		}
+	}));
+
+	// search for the last value so every index is a full scan
+	const T last = makeValue<T>(size - 1);
+
+	record("index", measure(counters, repeats, Ops::allocations, filled, [&](Container& container) {
+		for (size_t i = 0; i < repeats; ++i) {
+			sink = sink + Ops::index(container, last);
+		}
+	}));
+
+	record("count", measure(counters, repeats, Ops::allocations, filled, [&](Container& container) {
+		for (size_t i = 0; i < repeats; ++i) {
+			sink = sink + Ops::count(container, last);
+		}
+	}));
+
+	const auto sourceAndTarget = [&]() { return std::make_pair(filled(), Container()); };
+
+	record("copy", measure(counters, 1, Ops::allocations, sourceAndTarget, [&](std::pair<Container, Container>& arrays) {
+		Ops::copy(arrays.second, arrays.first);
+	}));
+
+	record("move", measure(counters, 1, Ops::allocations, sourceAndTarget, [&](std::pair<Container, Container>& arrays) {
+		arrays.second = std::move(arrays.first);
+	}));
+
+	record("reserve", measure(counters, 1, Ops::allocations, empty, [&](Container& container) {
+		Ops::reserve(container, size);
+	}));
+}
+
+/**
+ * @brief Run every operation on DynamicArray and std::vector, for every element type and every power of ten up to a maximum size.
+ * @param report Report to add the results to.
+ * @param counters Hardware counters to read.
+ * @param maxSize Largest array size to benchmark.
+ */
+inline void benchmarkAllOperations(BenchmarkReport& report, PerfCounters& counters, size_t maxSize)
+{
+	for (size_t size = 10; size <= maxSize; size *= 10) {
+		benchmarkOperations<DynamicArrayOperations, int>(report, counters, size);
+		benchmarkOperations<VectorOperations, int>(report, counters, size);
+
+		benchmarkOperations<DynamicArrayOperations, Pod64>(report, counters, size);
+		benchmarkOperations<VectorOperations, Pod64>(report, counters, size);
+
+		benchmarkOperations<DynamicArrayOperations, std::string>(report, counters, size);
+		benchmarkOperations<VectorOperations, std::string>(report, counters, size);
+	}
+}
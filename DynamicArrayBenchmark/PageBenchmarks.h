@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+
+#include "../DynamicArray/DynamicArray.h"
+#include "Benchmark.h"
+
+/**
+ * @brief Compare sequential and random reads over an array backed by 4K pages against one backed by huge pages.
+ * @param report Report to add the results to.
+ * @param counters Hardware counters to read, dTLB misses show the difference between page sizes most directly.
+ * @param megabytes Size of the array, rounded down to a power of two number of elements.
+ * @param placement NUMA placement of the array, the page size fields are overwritten.
+ */
+inline void benchmarkPages(BenchmarkReport& report, PerfCounters& counters, size_t megabytes, MemoryPlacement placement)
+{
+	// round down to a power of two so random indices can be taken from the top bits of a hash
+	size_t count = 1, countBits = 0;
+	while (count * 2 * sizeof(uint64_t) <= megabytes * 1024 * 1024) {
+		count *= 2;
+		++countBits;
+	}
+
+	const size_t randomReads = 1 << 24;
+
+	placement.pageBacked = true;
+	placement.prefault = true;
+
+	for (const bool hugePages : { false, true }) {
+		placement.hugePages = hugePages;
+
+		DynamicArray<uint64_t> arr;
+		arr.setPlacement(placement);
+		arr.reserve(count);
+
+		for (size_t i = 0; i < count; ++i) {
+			arr.append(i);
+		}
+
+		const uint64_t* data = arr.data();
+		volatile uint64_t sink = 0;
+
+		const auto noAllocations = []() { return size_t(0); };
+		const auto noState = []() { return 0; };
+
+		BenchmarkResult sequential = measure(counters, count, noAllocations, noState, [&](int&) {
+			uint64_t sum = 0;
+			for (size_t i = 0; i < count; ++i) {
+				sum += data[i];
+			}
+			sink = sum;
+		});
+
+		BenchmarkResult random = measure(counters, randomReads, noAllocations, noState, [&](int&) {
+			uint64_t sum = 0, index = 1;
+			for (size_t i = 0; i < randomReads; ++i) {
+				// each read depends on the last so the reads cannot overlap, exposing the full TLB and cache miss cost
+				// shifted in two steps so a single element array shifts by 64 in total without a 64 bit shift
+				index = index * 6364136223846793005ull + 1442695040888963407ull + data[(index >> 1) >> (63 - countBits)];
+				sum += index;
+			}
+			sink = sum;
+		});
+
+		for (auto* result : { &sequential, &random }) {
+			result->suite = "pages";
+			result->container = "DynamicArray";
+			result->type = "uint64_t";
+			result->size = count;
+		}
+
+		sequential.operation = hugePages ? "sequential_read_2M" : "sequential_read_4K";
+		random.operation = hugePages ? "random_read_2M" : "random_read_4K";
+
+		report.add(sequential);
+		report.add(random);
+	}
+}
@@ -0,0 +1,395 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+#include "Queue.h"
+#include "UnboundedQueue.h"
+
+/**
+ * @brief An executor which queues resumed coroutines and runs them when asked, on whichever thread calls run.
+ * Any thread may schedule onto it, so channels shared between threads can resume their coroutines here.
+ */
+class ManualExecutor
+{
+private:
+	std::mutex m_Mutex;
+	UnboundedQueue<std::coroutine_handle<>> m_Ready;
+
+public:
+	/**
+	 * @brief Queues a coroutine to be resumed by the next call to run.
+	 * @param handle Coroutine to resume.
+	 */
+	void schedule(std::coroutine_handle<> handle);
+
+	/**
+	 * @brief Resumes queued coroutines until there are none left, including any they schedule while running.
+	 * @return The number of coroutines resumed.
+	 */
+	size_t run();
+};
+
+inline void ManualExecutor::schedule(std::coroutine_handle<> handle)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Ready.enQueue(handle);
+}
+
+inline size_t ManualExecutor::run()
+{
+	size_t resumed = 0;
+
+	for (;;) {
+		std::coroutine_handle<> handle;
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			if (m_Ready.isEmpty()) return resumed;
+
+			handle = m_Ready.deQueue();
+		}
+
+		// resume outside the lock, the coroutine may schedule others
+		handle.resume();
+		++resumed;
+	}
+}
+
+/**
+ * @brief A coroutine which starts straight away and frees itself when it finishes, for running a pipeline stage.
+ * Nothing can wait for it, so a stage reports its result through a channel or a variable it was given.
+ */
+struct DetachedTask
+{
+	struct promise_type
+	{
+		DetachedTask get_return_object() noexcept { return {}; }
+		std::suspend_never initial_suspend() noexcept { return {}; }
+		std::suspend_never final_suspend() noexcept { return {}; }
+		void return_void() noexcept {}
+		void unhandled_exception() noexcept { std::terminate(); }
+	};
+};
+
+/**
+ * @brief A bounded channel between coroutines, with co_await channel.send(item) and co_await channel.receive().
+ * Items are held in a Queue ring. A send to a full channel or a receive from an empty one suspends the coroutine,
+ * and the operation which makes room or brings an item resumes it on the channel's executor. A suspended operation
+ * is linked into the channel's wait list through its awaiter, which lives in the waiting coroutine's frame,
+ * so no operation allocates.
+ * Once closed, receives drain what is left and then return no item, and sends throw.
+ * @tparam T Datatype of the items.
+ * @tparam size Maximum number of items held in the channel.
+ */
+template <typename T, size_t size>
+class AsyncChannel
+{
+	static_assert(size != 0, "Channel size must not be zero.");
+
+public:
+	class SendAwaiter;
+	class ReceiveAwaiter;
+
+private:
+	// a suspended send or receive, in the order the channel should resume them
+	struct Waiter
+	{
+		Waiter* m_Next = nullptr;
+		std::coroutine_handle<> m_Handle;
+	};
+
+	struct WaitList
+	{
+		Waiter* m_Head = nullptr;
+		Waiter* m_Tail = nullptr;
+
+		void pushBack(Waiter* waiter);
+		Waiter* popFront();
+		Waiter* takeAll();
+	};
+
+	mutable std::mutex m_Mutex;
+	Queue<T, size> m_Queue;
+	WaitList m_Senders, m_Receivers;
+	bool m_Closed = false;
+
+	// the executor with its type erased, so the channel type does not depend on it and nothing is allocated to hold it
+	void* m_Executor;
+	void (*m_Schedule)(void* executor, std::coroutine_handle<> handle);
+
+	void resume(std::coroutine_handle<> handle);
+	bool suspendSend(SendAwaiter& sender, std::coroutine_handle<> handle);
+	bool suspendReceive(ReceiveAwaiter& receiver, std::coroutine_handle<> handle);
+
+public:
+	/**
+	 * @brief Awaits room in the channel for an item.
+	 */
+	class SendAwaiter : public Waiter
+	{
+	private:
+		AsyncChannel<T, size>& m_Channel;
+		T m_Item;
+		bool m_Closed = false;
+
+		friend class AsyncChannel<T, size>;
+
+	public:
+		SendAwaiter(AsyncChannel<T, size>& channel, T item) : m_Channel(channel), m_Item(std::move(item)) {}
+
+		bool await_ready() const noexcept { return false; }
+		bool await_suspend(std::coroutine_handle<> handle) { return m_Channel.suspendSend(*this, handle); }
+		void await_resume() const;
+	};
+
+	/**
+	 * @brief Awaits an item from the channel.
+	 */
+	class ReceiveAwaiter : public Waiter
+	{
+	private:
+		AsyncChannel<T, size>& m_Channel;
+		std::optional<T> m_Item;
+
+		friend class AsyncChannel<T, size>;
+
+	public:
+		explicit ReceiveAwaiter(AsyncChannel<T, size>& channel) : m_Channel(channel) {}
+
+		bool await_ready() const noexcept { return false; }
+		bool await_suspend(std::coroutine_handle<> handle) { return m_Channel.suspendReceive(*this, handle); }
+		std::optional<T> await_resume();
+	};
+
+	/**
+	 * @brief The maximum number of items held in the channel.
+	 */
+	static constexpr size_t MAX_SIZE = size;
+
+	/**
+	 * @brief Constructs an empty, open channel which resumes suspended coroutines on an executor.
+	 * @param executor Executor with a schedule(std::coroutine_handle<>) member, which must outlive the channel.
+	 */
+	template <typename Executor>
+	explicit AsyncChannel(Executor& executor);
+
+	AsyncChannel(const AsyncChannel<T, size>& other) = delete;
+	AsyncChannel<T, size>& operator=(const AsyncChannel<T, size>& other) = delete;
+
+	/**
+	 * @brief Sends an item, to be awaited. A full channel suspends the sender until a receiver makes room.
+	 * Awaiting throws if the channel is closed, and the item is dropped.
+	 * @param item Item to send.
+	 * @return An awaiter which completes once the item is in the channel or handed to a receiver.
+	 */
+	[[nodiscard]] SendAwaiter send(T item);
+
+	/**
+	 * @brief Receives an item, to be awaited. An empty channel suspends the receiver until a sender brings an item.
+	 * @return An awaiter giving the oldest item, or no item once the channel is closed and empty.
+	 */
+	[[nodiscard]] ReceiveAwaiter receive();
+
+	/**
+	 * @brief Closes the channel and resumes every suspended sender and receiver.
+	 * Items already in the channel can still be received.
+	 */
+	void close();
+
+	/**
+	 * @brief Checks if the channel has been closed.
+	 * @return True if the channel is closed else false.
+	 */
+	[[nodiscard]] bool isClosed() const;
+
+	/**
+	 * @brief Returns the number of items waiting in the channel, not counting suspended senders.
+	 * @return The number of items in the channel.
+	 */
+	[[nodiscard]] size_t currentSize() const;
+};
+
+template <typename T, size_t size>
+void AsyncChannel<T, size>::WaitList::pushBack(Waiter* waiter)
+{
+	waiter->m_Next = nullptr;
+
+	if (m_Tail == nullptr) {
+		m_Head = m_Tail = waiter;
+	} else {
+		m_Tail->m_Next = waiter;
+		m_Tail = waiter;
+	}
+}
+
+template <typename T, size_t size>
+typename AsyncChannel<T, size>::Waiter* AsyncChannel<T, size>::WaitList::popFront()
+{
+	Waiter* waiter = m_Head;
+
+	if (waiter != nullptr) {
+		m_Head = waiter->m_Next;
+		if (m_Head == nullptr) m_Tail = nullptr;
+	}
+
+	return waiter;
+}
+
+template <typename T, size_t size>
+typename AsyncChannel<T, size>::Waiter* AsyncChannel<T, size>::WaitList::takeAll()
+{
+	Waiter* waiters = m_Head;
+	m_Head = m_Tail = nullptr;
+
+	return waiters;
+}
+
+template <typename T, size_t size>
+template <typename Executor>
+AsyncChannel<T, size>::AsyncChannel(Executor& executor) :
+	m_Executor(&executor),
+	m_Schedule([](void* executor, std::coroutine_handle<> handle) { static_cast<Executor*>(executor)->schedule(handle); })
+{
+}
+
+template <typename T, size_t size>
+void AsyncChannel<T, size>::resume(std::coroutine_handle<> handle)
+{
+	m_Schedule(m_Executor, handle);
+}
+
+template <typename T, size_t size>
+bool AsyncChannel<T, size>::suspendSend(SendAwaiter& sender, std::coroutine_handle<> handle)
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	if (m_Closed) {
+		sender.m_Closed = true;
+		return false;
+	}
+
+	if (Waiter* waiter = m_Receivers.popFront()) {
+		// a receiver only waits on an empty ring, so the item goes straight to it
+		auto* receiver = static_cast<ReceiveAwaiter*>(waiter);
+		receiver->m_Item.emplace(std::move(sender.m_Item));
+
+		lock.unlock();
+		resume(receiver->m_Handle);
+
+		return false;
+	}
+
+	if (!m_Queue.isFull()) {
+		m_Queue.enQueue(std::move(sender.m_Item));
+		return false;
+	}
+
+	// once linked in and unlocked a receiver may resume the sender at any moment, so nothing touches it after
+	sender.m_Handle = handle;
+	m_Senders.pushBack(&sender);
+
+	return true;
+}
+
+template <typename T, size_t size>
+void AsyncChannel<T, size>::SendAwaiter::await_resume() const
+{
+	if (m_Closed)
+		throw std::range_error("Cannot send to a closed channel.");
+}
+
+template <typename T, size_t size>
+bool AsyncChannel<T, size>::suspendReceive(ReceiveAwaiter& receiver, std::coroutine_handle<> handle)
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	if (!m_Queue.isEmpty()) {
+		receiver.m_Item.emplace(m_Queue.deQueue());
+
+		// that made room, so the longest waiting sender can put its item in
+		if (Waiter* waiter = m_Senders.popFront()) {
+			auto* sender = static_cast<SendAwaiter*>(waiter);
+			m_Queue.enQueue(std::move(sender->m_Item));
+
+			lock.unlock();
+			resume(sender->m_Handle);
+		}
+
+		return false;
+	}
+
+	if (m_Closed) return false;
+
+	receiver.m_Handle = handle;
+	m_Receivers.pushBack(&receiver);
+
+	return true;
+}
+
+template <typename T, size_t size>
+std::optional<T> AsyncChannel<T, size>::ReceiveAwaiter::await_resume()
+{
+	return std::move(m_Item);
+}
+
+template <typename T, size_t size>
+typename AsyncChannel<T, size>::SendAwaiter AsyncChannel<T, size>::send(T item)
+{
+	return SendAwaiter(*this, std::move(item));
+}
+
+template <typename T, size_t size>
+typename AsyncChannel<T, size>::ReceiveAwaiter AsyncChannel<T, size>::receive()
+{
+	return ReceiveAwaiter(*this);
+}
+
+template <typename T, size_t size>
+void AsyncChannel<T, size>::close()
+{
+	Waiter* senders;
+	Waiter* receivers;
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		m_Closed = true;
+		senders = m_Senders.takeAll();
+		receivers = m_Receivers.takeAll();
+	}
+
+	// read the next waiter before resuming, the executor may run the coroutine and free its awaiter straight away
+	while (senders != nullptr) {
+		auto* sender = static_cast<SendAwaiter*>(senders);
+		senders = senders->m_Next;
+
+		sender->m_Closed = true;
+		resume(sender->m_Handle);
+	}
+
+	while (receivers != nullptr) {
+		Waiter* receiver = receivers;
+		receivers = receivers->m_Next;
+
+		resume(receiver->m_Handle);
+	}
+}
+
+template <typename T, size_t size>
+bool AsyncChannel<T, size>::isClosed() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_Closed;
+}
+
+template <typename T, size_t size>
+size_t AsyncChannel<T, size>::currentSize() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_Queue.currentSize();
+}
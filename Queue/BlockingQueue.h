@@ -0,0 +1,285 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#include "Futex.h"
+#include "UnboundedQueue.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define BLOCKING_QUEUE_PAUSE() _mm_pause()
+#else
+	#define BLOCKING_QUEUE_PAUSE() ((void)0)
+#endif
+
+/**
+ * @brief A queue with no maximum size whose consumers sleep until there is an item, instead of spinning on isEmpty.
+ * A consumer which finds the queue empty spins for a while and then parks on a futex, and a producer only pays for a
+ * wake up when a consumer is parked. The spin adapts: waits which spinning ended raise the limit towards twice what
+ * they needed, waits which had to park lower it, so consumers which are usually idle stop burning a core while busy
+ * ones still pick up items without a trip through the kernel.
+ * Once closed no more items can be pushed, and consumers drain what is left before pop reports the queue as finished.
+ * @tparam T Datatype of queue.
+ */
+template <typename T>
+class BlockingQueue
+{
+public:
+	/**
+	 * @brief Fewest times a consumer spins before parking, once the spin limit has adapted down.
+	 */
+	static constexpr uint32_t MIN_SPINS = 16;
+
+	/**
+	 * @brief Most times a consumer spins before parking, about the cost of parking and being woken.
+	 */
+	static constexpr uint32_t MAX_SPINS = 4096;
+
+private:
+	std::mutex m_Mutex;
+	UnboundedQueue<T> m_Queue;
+
+	// the number of queued items, kept outside the lock so waiting consumers can spin without taking it
+	alignas(64) std::atomic<size_t> m_Size = 0;
+	std::atomic<bool> m_Closed = false;
+
+	// the word consumers park on, changed whenever a parked consumer should look at the queue again
+	alignas(64) std::atomic<uint32_t> m_Signal = 0;
+	std::atomic<uint32_t> m_Sleepers = 0;
+	std::atomic<uint32_t> m_SpinLimit = MIN_SPINS;
+
+	template <typename U>
+	void pushItem(U&& item);
+
+	bool spinForItem();
+	bool popUntil(T& item, std::chrono::steady_clock::time_point deadline);
+
+public:
+	/**
+	 * @brief Constructs an empty, open queue.
+	 */
+	BlockingQueue() = default;
+
+	BlockingQueue(const BlockingQueue<T>& other) = delete;
+	BlockingQueue<T>& operator=(const BlockingQueue<T>& other) = delete;
+
+	/**
+	 * @brief Pushes an item at the end of the queue, waking a parked consumer if there is one.
+	 * @param item Item to queue.
+	 */
+	void push(const T& item);
+
+	/**
+	 * @brief Pushes an item at the end of the queue by moving it, waking a parked consumer if there is one.
+	 * @param item Item to queue.
+	 */
+	void push(T&& item);
+
+	/**
+	 * @brief Pops the item at the front of the queue, waiting for one if the queue is empty.
+	 * @param item Set to the popped item.
+	 * @return True if an item was popped, false if the queue is closed and empty.
+	 */
+	bool pop(T& item);
+
+	/**
+	 * @brief Pops the item at the front of the queue if there is one, without waiting.
+	 * @param item Set to the popped item.
+	 * @return True if an item was popped, false if the queue was empty.
+	 */
+	bool tryPop(T& item);
+
+	/**
+	 * @brief Pops the item at the front of the queue, waiting at most a given time for one if the queue is empty.
+	 * @param item Set to the popped item.
+	 * @param timeout Longest time to wait.
+	 * @return True if an item was popped, false if the time ran out or the queue is closed and empty.
+	 */
+	template <typename Rep, typename Period>
+	bool tryPopFor(T& item, const std::chrono::duration<Rep, Period>& timeout);
+
+	/**
+	 * @brief Closes the queue, so no more items can be pushed, and wakes every parked consumer.
+	 * Items already queued can still be popped.
+	 */
+	void close();
+
+	/**
+	 * @brief Checks if the queue has been closed.
+	 * @return True if the queue is closed else false.
+	 */
+	[[nodiscard]] bool isClosed() const;
+
+	/**
+	 * @brief Returns the current number of elements in the queue.
+	 * Called while other threads are working, this is only a snapshot.
+	 * @return The number of elements in the queue.
+	 */
+	[[nodiscard]] size_t currentSize() const;
+
+	/**
+	 * @brief Checks if the queue is empty.
+	 * @return True if the queue is empty else false.
+	 */
+	[[nodiscard]] bool isEmpty() const;
+};
+
+template <typename T>
+template <typename U>
+void BlockingQueue<T>::pushItem(U&& item)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		if (m_Closed.load(std::memory_order_relaxed))
+			throw std::range_error("Cannot add item to a closed queue.");
+
+		m_Queue.enQueue(std::forward<U>(item));
+
+		// sequentially consistent with a consumer announcing it will park, so either this sees the sleeper or it sees the item
+		m_Size.fetch_add(1, std::memory_order_seq_cst);
+	}
+
+	if (m_Sleepers.load(std::memory_order_seq_cst) != 0) {
+		m_Signal.fetch_add(1, std::memory_order_release);
+		futexWakeOne(m_Signal);
+	}
+}
+
+template <typename T>
+void BlockingQueue<T>::push(const T& item)
+{
+	pushItem(item);
+}
+
+template <typename T>
+void BlockingQueue<T>::push(T&& item)
+{
+	pushItem(std::move(item));
+}
+
+template <typename T>
+bool BlockingQueue<T>::tryPop(T& item)
+{
+	// skip the lock when there is plainly nothing to take
+	if (m_Size.load(std::memory_order_relaxed) == 0) return false;
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	if (m_Queue.isEmpty()) return false;
+
+	item = m_Queue.deQueue();
+	m_Size.fetch_sub(1, std::memory_order_relaxed);
+
+	return true;
+}
+
+template <typename T>
+bool BlockingQueue<T>::spinForItem()
+{
+	// with a single hardware thread nothing can arrive while spinning
+	static const bool singleCore = std::thread::hardware_concurrency() <= 1;
+	if (singleCore) return false;
+
+	const uint32_t limit = m_SpinLimit.load(std::memory_order_relaxed);
+
+	for (uint32_t spin = 0; spin < limit; ++spin) {
+		if (m_Size.load(std::memory_order_relaxed) != 0 || m_Closed.load(std::memory_order_relaxed)) {
+			// move an eighth of the way towards twice what this wait needed, so one odd wait barely shifts the limit
+			const int64_t target = std::clamp<int64_t>(2 * int64_t(spin), MIN_SPINS, MAX_SPINS);
+			m_SpinLimit.store(uint32_t(int64_t(limit) + (target - int64_t(limit)) / 8), std::memory_order_relaxed);
+
+			return true;
+		}
+
+		BLOCKING_QUEUE_PAUSE();
+	}
+
+	m_SpinLimit.store(std::max(MIN_SPINS, limit - limit / 8), std::memory_order_relaxed);
+	return false;
+}
+
+template <typename T>
+bool BlockingQueue<T>::popUntil(T& item, std::chrono::steady_clock::time_point deadline)
+{
+	const bool timed = deadline != std::chrono::steady_clock::time_point::max();
+
+	for (;;) {
+		if (tryPop(item)) return true;
+
+		// pushes and close both hold the lock, so once closed every item pushed is already visible to tryPop
+		if (m_Closed.load(std::memory_order_acquire)) return tryPop(item);
+
+		if (timed && std::chrono::steady_clock::now() >= deadline) return false;
+
+		if (spinForItem()) continue;
+
+		// announce the sleep before the last look, so a push either sees the sleeper or happened before the look
+		m_Sleepers.fetch_add(1, std::memory_order_seq_cst);
+		const uint32_t signal = m_Signal.load(std::memory_order_seq_cst);
+
+		if (m_Size.load(std::memory_order_seq_cst) == 0 && !m_Closed.load(std::memory_order_seq_cst)) {
+			if (!timed) {
+				futexWait(m_Signal, signal);
+			} else {
+				const auto now = std::chrono::steady_clock::now();
+				if (now < deadline) futexWait(m_Signal, signal, deadline - now);
+			}
+		}
+
+		m_Sleepers.fetch_sub(1, std::memory_order_relaxed);
+	}
+}
+
+template <typename T>
+bool BlockingQueue<T>::pop(T& item)
+{
+	return popUntil(item, std::chrono::steady_clock::time_point::max());
+}
+
+template <typename T>
+template <typename Rep, typename Period>
+bool BlockingQueue<T>::tryPopFor(T& item, const std::chrono::duration<Rep, Period>& timeout)
+{
+	// compare as floating point seconds, so a huge timeout cannot overflow the clock, it just waits about a year
+	const std::chrono::duration<double> bounded = std::min<std::chrono::duration<double>>(timeout, std::chrono::hours(24 * 365));
+	if (bounded <= std::chrono::duration<double>::zero()) return tryPop(item);
+
+	return popUntil(item, std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(bounded));
+}
+
+template <typename T>
+void BlockingQueue<T>::close()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Closed.store(true, std::memory_order_seq_cst);
+	}
+
+	m_Signal.fetch_add(1, std::memory_order_seq_cst);
+	futexWakeAll(m_Signal);
+}
+
+template <typename T>
+bool BlockingQueue<T>::isClosed() const
+{
+	return m_Closed.load(std::memory_order_acquire);
+}
+
+template <typename T>
+size_t BlockingQueue<T>::currentSize() const
+{
+	return m_Size.load(std::memory_order_acquire);
+}
+
+template <typename T>
+bool BlockingQueue<T>::isEmpty() const
+{
+	return currentSize() == 0;
+}
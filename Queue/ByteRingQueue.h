@@ -0,0 +1,240 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+
+/**
+ * @brief A lock-free bip-buffer of variable length records, for exactly one producer thread and one consumer thread.
+ * The producer reserves room for a record, writes it in place and commits it. The consumer peeks at the oldest record,
+ * reads it in place and releases it. A record is never copied in or out, unlike with a Queue of fixed size items.
+ * Every reservation is contiguous. When a record does not fit before the end of the buffer, the producer wraps to the
+ * start and leaves a watermark where the data stopped, and the consumer skips from the watermark back to the start.
+ * The unused space after the watermark is wasted until the consumer passes it.
+ * Each record is an 8 byte length followed by its bytes padded to 8, so records are 8 byte aligned for writing structs
+ * in place. As in SpscQueue, each side's index sits on its own cache line and each side caches the other's index, so
+ * it only reads the shared one when the buffer looks full or empty.
+ * @tparam size Number of bytes in the buffer, a multiple of 16.
+ */
+template <size_t size>
+class ByteRingQueue
+{
+	static_assert(size >= 64 && size % 16 == 0, "Byte ring size must be a multiple of 16 of at least 64 bytes.");
+
+private:
+	static constexpr size_t HEADER_SIZE = sizeof(uint64_t);
+
+	// the consumer's line, written only by the consumer
+	alignas(64) std::atomic<size_t> m_Read = 0;
+	size_t m_CachedWrite = 0;
+	size_t m_PeekedOffset = 0;
+	size_t m_PeekedLength = 0;
+	bool m_Peeked = false;
+
+	// the producer's line, written only by the producer
+	alignas(64) std::atomic<size_t> m_Write = 0;
+	// where the data stops before the producer's last wrap back to the start
+	std::atomic<size_t> m_Watermark = 0;
+	size_t m_CachedRead = 0;
+	size_t m_ReservedOffset = 0;
+	size_t m_ReservedLength = 0;
+	bool m_Reserved = false;
+	bool m_Wrapping = false;
+
+	alignas(64) std::array<std::byte, size> m_Data;
+
+	[[nodiscard]] static size_t recordSize(size_t length);
+	[[nodiscard]] bool place(size_t write, size_t read, size_t needed);
+
+public:
+	/**
+	 * @brief Number of bytes in the buffer.
+	 */
+	static constexpr size_t MAX_SIZE = size;
+
+	/**
+	 * @brief Longest record, short enough that it always fits once the consumer has caught up.
+	 */
+	static constexpr size_t MAX_RECORD_SIZE = size / 2 - HEADER_SIZE;
+
+	/**
+	 * @brief Constructs an empty buffer.
+	 */
+	ByteRingQueue() = default;
+
+	ByteRingQueue(const ByteRingQueue<size>& other) = delete;
+	ByteRingQueue<size>& operator=(const ByteRingQueue<size>& other) = delete;
+
+	/**
+	 * @brief Reserves contiguous room for a record, which the consumer cannot see until it is committed.
+	 * An earlier reservation which was never committed is dropped. Only the producer thread may call this.
+	 * @param length Number of bytes in the record, at most MAX_RECORD_SIZE.
+	 * @return The reserved bytes, 8 byte aligned, or an empty span if the buffer is too full.
+	 */
+	[[nodiscard]] std::span<std::byte> reserve(size_t length);
+
+	/**
+	 * @brief Commits the reserved record so the consumer can see it. Only the producer thread may call this.
+	 * @param length Number of bytes written, which may be fewer than were reserved, none drops the reservation.
+	 */
+	void commit(size_t length);
+
+	/**
+	 * @brief Commits the whole of the reserved record. Only the producer thread may call this.
+	 */
+	void commit();
+
+	/**
+	 * @brief Returns the oldest record, which stays in the buffer until it is released.
+	 * Peeking again before releasing returns the same record. Only the consumer thread may call this.
+	 * @return The bytes of the record, or an empty span if the buffer is empty.
+	 */
+	[[nodiscard]] std::span<const std::byte> peek();
+
+	/**
+	 * @brief Releases the record returned by peek, giving its room back to the producer.
+	 * Only the consumer thread may call this.
+	 */
+	void release();
+
+	/**
+	 * @brief Checks if the buffer holds no committed records.
+	 * Called while the other thread is working, this is only a snapshot.
+	 * @return True if the buffer is empty else false.
+	 */
+	[[nodiscard]] bool isEmpty() const;
+};
+
+template <size_t size>
+size_t ByteRingQueue<size>::recordSize(size_t length)
+{
+	return HEADER_SIZE + (length + HEADER_SIZE - 1) / HEADER_SIZE * HEADER_SIZE;
+}
+
+template <size_t size>
+bool ByteRingQueue<size>::place(size_t write, size_t read, size_t needed)
+{
+	if (write >= read) {
+		if (size - write >= needed) {
+			m_ReservedOffset = write;
+			m_Wrapping = false;
+			return true;
+		}
+
+		// wrap, but never so far that write catches up with read, which would look empty
+		if (read > needed) {
+			m_ReservedOffset = 0;
+			m_Wrapping = true;
+			return true;
+		}
+
+		return false;
+	}
+
+	// already wrapped, so the free room runs up to just short of read
+	if (read - write > needed) {
+		m_ReservedOffset = write;
+		m_Wrapping = false;
+		return true;
+	}
+
+	return false;
+}
+
+template <size_t size>
+std::span<std::byte> ByteRingQueue<size>::reserve(size_t length)
+{
+	if (length == 0 || length > MAX_RECORD_SIZE)
+		throw std::range_error("Record length must be between 1 and the maximum record size.");
+
+	const size_t write = m_Write.load(std::memory_order_relaxed);
+	const size_t needed = recordSize(length);
+
+	// read only moves on, so the cached one can only make the buffer look fuller than it is
+	if (!place(write, m_CachedRead, needed)) {
+		m_CachedRead = m_Read.load(std::memory_order_acquire);
+
+		if (!place(write, m_CachedRead, needed)) {
+			m_Reserved = false;
+			return {};
+		}
+	}
+
+	m_Reserved = true;
+	m_ReservedLength = length;
+
+	return std::span<std::byte>(m_Data.data() + m_ReservedOffset + HEADER_SIZE, length);
+}
+
+template <size_t size>
+void ByteRingQueue<size>::commit(size_t length)
+{
+	if (!m_Reserved)
+		throw std::range_error("Nothing to commit, reserve a record first.");
+
+	if (length > m_ReservedLength)
+		throw std::range_error("Cannot commit more bytes than were reserved.");
+
+	m_Reserved = false;
+	if (length == 0) return;
+
+	const uint64_t header = length;
+	std::memcpy(m_Data.data() + m_ReservedOffset, &header, HEADER_SIZE);
+
+	// the watermark goes out with the release of write below, before the consumer can see the wrapped write
+	if (m_Wrapping) m_Watermark.store(m_Write.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+	// release, the record must be visible before the write which lets the consumer read it
+	m_Write.store(m_ReservedOffset + recordSize(length), std::memory_order_release);
+}
+
+template <size_t size>
+void ByteRingQueue<size>::commit()
+{
+	commit(m_ReservedLength);
+}
+
+template <size_t size>
+std::span<const std::byte> ByteRingQueue<size>::peek()
+{
+	size_t read = m_Read.load(std::memory_order_relaxed);
+
+	if (read == m_CachedWrite) {
+		m_CachedWrite = m_Write.load(std::memory_order_acquire);
+		if (read == m_CachedWrite) return {};
+	}
+
+	// the producer wrapped and everything before the watermark has been read, so carry on from the start
+	if (m_CachedWrite < read && read == m_Watermark.load(std::memory_order_relaxed)) read = 0;
+
+	uint64_t length;
+	std::memcpy(&length, m_Data.data() + read, HEADER_SIZE);
+
+	m_Peeked = true;
+	m_PeekedOffset = read;
+	m_PeekedLength = size_t(length);
+
+	return std::span<const std::byte>(m_Data.data() + read + HEADER_SIZE, m_PeekedLength);
+}
+
+template <size_t size>
+void ByteRingQueue<size>::release()
+{
+	if (!m_Peeked)
+		throw std::range_error("Nothing to release, peek at a record first.");
+
+	m_Peeked = false;
+
+	// release, the consumer must be done reading before the producer may write over the record
+	m_Read.store(m_PeekedOffset + recordSize(m_PeekedLength), std::memory_order_release);
+}
+
+template <size_t size>
+bool ByteRingQueue<size>::isEmpty() const
+{
+	return m_Read.load(std::memory_order_acquire) == m_Write.load(std::memory_order_acquire);
+}
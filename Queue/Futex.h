@@ -0,0 +1,122 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#if defined(_WIN32)
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <windows.h>
+	#pragma comment(lib, "Synchronization.lib")
+#elif defined(__linux__)
+	#include <ctime>
+	#include <linux/futex.h>
+	#include <sys/syscall.h>
+	#include <unistd.h>
+#endif
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) && std::atomic<uint32_t>::is_always_lock_free,
+	"A futex word must be a plain 32 bit integer.");
+
+/**
+ * @brief Who may wait on and wake a futex word.
+ */
+enum class FutexScope
+{
+	// threads of this process, the kernel keys the word by its virtual address, which is cheaper
+	Process,
+	// any process mapping the word from shared memory, the kernel keys it by the backing page
+	Shared
+};
+
+/**
+ * @brief Sleep while a word holds an expected value, until woken, the value changes or the timeout passes.
+ * The check and the sleep are one step in the kernel, so a wake between the caller's last look at the word and the
+ * sleep is never lost. Unlike std::atomic::wait this takes a timeout. The call can also return early for no reason,
+ * so callers recheck what they are waiting for.
+ * @param word Word to sleep on.
+ * @param expected Value the word must still hold for the thread to sleep.
+ * @param timeout Longest time to sleep, the maximum sleeps until woken.
+ * @param scope Who may wake the word, Shared for a word in memory mapped by several processes.
+ */
+inline void futexWait(std::atomic<uint32_t>& word, uint32_t expected, std::chrono::nanoseconds timeout = std::chrono::nanoseconds::max(), FutexScope scope = FutexScope::Process)
+{
+	if (timeout <= std::chrono::nanoseconds::zero()) return;
+
+#if defined(_WIN32)
+	DWORD milliseconds = INFINITE;
+
+	if (timeout != std::chrono::nanoseconds::max()) {
+		// round up, so a short timeout still sleeps rather than spinning
+		const auto rounded = std::chrono::ceil<std::chrono::milliseconds>(timeout).count();
+		milliseconds = static_cast<DWORD>(std::min<long long>(rounded, INFINITE - 1));
+	}
+
+	// WaitOnAddress only works within a process, a shared word falls back to sleeping in short slices
+	if (scope == FutexScope::Shared) {
+		if (word.load(std::memory_order_acquire) == expected) Sleep(std::min<DWORD>(milliseconds, 1));
+		return;
+	}
+
+	WaitOnAddress(&word, &expected, sizeof(expected), milliseconds);
+#elif defined(__linux__)
+	timespec relative;
+	timespec* limit = nullptr;
+
+	if (timeout != std::chrono::nanoseconds::max()) {
+		relative.tv_sec = static_cast<time_t>(timeout.count() / 1'000'000'000);
+		relative.tv_nsec = static_cast<long>(timeout.count() % 1'000'000'000);
+		limit = &relative;
+	}
+
+	const int operation = scope == FutexScope::Shared ? FUTEX_WAIT : FUTEX_WAIT_PRIVATE;
+	syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), operation, expected, limit, nullptr, 0);
+#else
+	(void)scope;
+
+	// no timed wait to build on, so sleep in short slices and let the caller recheck
+	if (word.load(std::memory_order_acquire) == expected) {
+		std::this_thread::sleep_for(std::min<std::chrono::nanoseconds>(timeout, std::chrono::microseconds(50)));
+	}
+#endif
+}
+
+/**
+ * @brief Wake one thread sleeping on a word in futexWait.
+ * @param word Word the thread sleeps on.
+ * @param scope Scope the thread sleeps with.
+ */
+inline void futexWakeOne(std::atomic<uint32_t>& word, FutexScope scope = FutexScope::Process)
+{
+#if defined(_WIN32)
+	if (scope == FutexScope::Process) WakeByAddressSingle(&word);
+#elif defined(__linux__)
+	const int operation = scope == FutexScope::Shared ? FUTEX_WAKE : FUTEX_WAKE_PRIVATE;
+	syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), operation, 1, nullptr, nullptr, 0);
+#else
+	(void)word;
+	(void)scope;
+#endif
+}
+
+/**
+ * @brief Wake every thread sleeping on a word in futexWait.
+ * @param word Word the threads sleep on.
+ * @param scope Scope the threads sleep with.
+ */
+inline void futexWakeAll(std::atomic<uint32_t>& word, FutexScope scope = FutexScope::Process)
+{
+#if defined(_WIN32)
+	if (scope == FutexScope::Process) WakeByAddressAll(&word);
+#elif defined(__linux__)
+	const int operation = scope == FutexScope::Shared ? FUTEX_WAKE : FUTEX_WAKE_PRIVATE;
+	syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), operation, INT32_MAX, nullptr, nullptr, 0);
+#else
+	(void)word;
+	(void)scope;
+#endif
+}
@@ -0,0 +1,701 @@
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#include "Futex.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+	#include <fcntl.h>
+	#include <signal.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+
+	#define IPC_QUEUE_SUPPORTED 1
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define IPC_QUEUE_PAUSE() _mm_pause()
+#else
+	#define IPC_QUEUE_PAUSE() ((void)0)
+#endif
+
+#ifdef IPC_QUEUE_SUPPORTED
+
+/**
+ * @brief Which side of an IpcQueue a process attaches as.
+ */
+enum class IpcRole
+{
+	Producer,
+	Consumer
+};
+
+/**
+ * @brief How many processes may produce into an IpcQueue at once.
+ */
+enum class IpcProducers
+{
+	// one producer and one consumer, neither takes a lock
+	Single,
+	// many producers, which take turns through a lock in the shared memory, and one consumer
+	Multiple
+};
+
+/**
+ * @brief A queue of variable length messages between processes on one host, in a shared memory mapping.
+ * Like Queue it is a circular buffer with a free-running head and tail, here counting bytes. Each message is a record of
+ * an 8 byte header and its bytes padded to 8, written straight into the mapping by the producer and handed to the
+ * consumer's handler in place, so nothing passes through the kernel. A record which would run off the end of the
+ * buffer is preceded by a padding record to the end, so every message is contiguous.
+ * The tail is published with a release store after the record is written, and each side caches the other's index so it
+ * only touches the other's cache line when the queue looks full or empty. Waits spin briefly and then sleep on a futex
+ * in the mapping, which the other side only wakes when someone is asleep.
+ * Attaching is crash-safe: the mapping is laid out under a lock held by process id, taken over if its holder died, and
+ * processes register their id so that a mapping left behind by processes which all died is laid out afresh rather than
+ * resumed. A consumer which died can be replaced and picks up where it stopped, and a producer which died mid-write
+ * never published the record, so the next producer writes over it. With many producers the lock they share is
+ * likewise taken over from a producer which died holding it.
+ * POSIX only. The mapping comes from shm_open by name, or from a file descriptor such as a memfd.
+ * @tparam size Number of bytes in the buffer, a power of two.
+ * @tparam producers Whether one process or several produce.
+ */
+template <size_t size, IpcProducers producers = IpcProducers::Single>
+class IpcQueue
+{
+	static_assert(size >= 64 && (size & (size - 1)) == 0, "IPC queue size must be a power of two of at least 64 bytes.");
+
+private:
+	struct RecordHeader
+	{
+		uint32_t length;
+		uint32_t kind;
+	};
+
+	static constexpr size_t RECORD_ALIGNMENT = sizeof(RecordHeader);
+
+public:
+	/**
+	 * @brief Number of bytes in the buffer.
+	 */
+	static constexpr size_t MAX_SIZE = size;
+
+	/**
+	 * @brief Longest message, small enough that a message and the padding before it always fit an empty buffer.
+	 */
+	static constexpr size_t MAX_MESSAGE_SIZE = size / 2 - sizeof(RecordHeader);
+
+	/**
+	 * @brief Most producers attached at once.
+	 */
+	static constexpr size_t MAX_PRODUCERS = producers == IpcProducers::Single ? 1 : 64;
+
+	/**
+	 * @brief Times a wait checks again before sleeping, about the cost of sleeping and being woken.
+	 */
+	static constexpr size_t SPINS_BEFORE_SLEEP = 2048;
+
+private:
+	// "IPCQ" and a layout version
+	static constexpr uint64_t MAGIC = 0x49504351'00000001;
+	static constexpr uint32_t MESSAGE = 1;
+	static constexpr uint32_t PADDING = 2;
+
+	// spins between checks that a lock's holder is still alive
+	static constexpr size_t SPINS_BEFORE_LIVENESS_CHECK = 1024;
+
+	// lives at the start of the mapping, shared by every attached process
+	struct Control
+	{
+		std::atomic<uint64_t> m_Magic;
+		uint64_t m_Size;
+		uint32_t m_Producers;
+		std::atomic<uint32_t> m_LayoutLock;
+
+		alignas(64) std::atomic<uint32_t> m_ConsumerId;
+		std::atomic<uint32_t> m_ProducerIds[MAX_PRODUCERS];
+
+		// the consumer's line, written only by the consumer
+		alignas(64) std::atomic<uint64_t> m_Head;
+		std::atomic<uint32_t> m_SpaceSignal;
+		std::atomic<uint32_t> m_ProducersWaiting;
+
+		// the producers' line
+		alignas(64) std::atomic<uint64_t> m_Tail;
+		std::atomic<uint32_t> m_DataSignal;
+		std::atomic<uint32_t> m_ConsumerWaiting;
+		std::atomic<uint32_t> m_ProducerLock;
+	};
+
+	static constexpr size_t CONTROL_SIZE = (sizeof(Control) + 63) / 64 * 64;
+	static constexpr size_t MAPPING_SIZE = CONTROL_SIZE + size;
+
+	Control* m_Control = nullptr;
+	std::byte* m_Data = nullptr;
+	IpcRole m_Role;
+	uint32_t m_ProcessId;
+
+	// the consumer's last look at the tail, and a producer's at the head, both only ever behind the real one
+	uint64_t m_CachedTail = 0;
+	uint64_t m_CachedHead = 0;
+
+	[[nodiscard]] static size_t recordSize(size_t length);
+	[[nodiscard]] static bool isAlive(uint32_t processId);
+	[[noreturn]] static void throwSystemError(const char* what);
+
+	void attach(int fd);
+	void layOut();
+	[[nodiscard]] bool hasLiveProcesses() const;
+	void registerProcess();
+	void unregisterProcess();
+
+	void lock(std::atomic<uint32_t>& word);
+	void unlock(std::atomic<uint32_t>& word);
+
+	[[nodiscard]] bool hasRoomFor(size_t length);
+	bool write(std::span<const std::byte> message);
+	void wakeConsumer();
+	void wakeProducers();
+
+	template <typename Ready>
+	bool waitUntil(std::atomic<uint32_t>& signal, std::atomic<uint32_t>& waiting, Ready&& ready, std::chrono::steady_clock::time_point deadline);
+
+public:
+	/**
+	 * @brief Attaches to the queue in a named shared memory object, creating it if it does not exist.
+	 * @param name Name of the object for shm_open, starting with a slash.
+	 * @param role Whether this process produces or consumes.
+	 */
+	IpcQueue(const std::string& name, IpcRole role);
+
+	/**
+	 * @brief Attaches to the queue in a file shared with the other processes, such as a memfd passed over a socket or
+	 * inherited through fork. The file is grown to fit if it is too small, and the caller still owns the descriptor.
+	 * @param fd Descriptor of the file.
+	 * @param role Whether this process produces or consumes.
+	 */
+	IpcQueue(int fd, IpcRole role);
+
+	IpcQueue(const IpcQueue<size, producers>& other) = delete;
+	IpcQueue<size, producers>& operator=(const IpcQueue<size, producers>& other) = delete;
+
+	/**
+	 * @brief Detaches from the queue. The shared memory stays for the other processes.
+	 */
+	~IpcQueue();
+
+#ifdef __linux__
+	/**
+	 * @brief Creates an anonymous memory file to hold a queue, to be shared by fork or sent over a unix socket.
+	 * @param name Name shown for the file in /proc, for debugging.
+	 * @return Descriptor of the file, which the caller closes.
+	 */
+	static int createMemoryFile(const std::string& name);
+#endif
+
+	/**
+	 * @brief Removes a named shared memory object. Processes still attached keep their mapping.
+	 * @param name Name of the object.
+	 */
+	static void remove(const std::string& name);
+
+	/**
+	 * @brief Sends a message if there is room for it. Only a producer may call this.
+	 * @param message Bytes of the message, at most MAX_MESSAGE_SIZE.
+	 * @return True if the message was queued, false if the queue was too full.
+	 */
+	bool trySend(std::span<const std::byte> message);
+
+	/**
+	 * @brief Sends a message, waiting for room. Only a producer may call this.
+	 * @param message Bytes of the message, at most MAX_MESSAGE_SIZE.
+	 */
+	void send(std::span<const std::byte> message);
+
+	/**
+	 * @brief Sends a message, waiting at most a given time for room. Only a producer may call this.
+	 * @param message Bytes of the message, at most MAX_MESSAGE_SIZE.
+	 * @param timeout Longest time to wait.
+	 * @return True if the message was queued, false if the time ran out.
+	 */
+	template <typename Rep, typename Period>
+	bool sendFor(std::span<const std::byte> message, const std::chrono::duration<Rep, Period>& timeout);
+
+	/**
+	 * @brief Hands the oldest message to a handler in place, if there is one. Only the consumer may call this.
+	 * The bytes are only valid during the call. If the handler throws, the message stays queued.
+	 * @param handler Function called with a std::span<const std::byte> of the message.
+	 * @return True if a message was handled, false if the queue was empty.
+	 */
+	template <typename Handler>
+	bool tryReceive(Handler&& handler);
+
+	/**
+	 * @brief Hands the oldest message to a handler in place, waiting for one. Only the consumer may call this.
+	 * @param handler Function called with a std::span<const std::byte> of the message.
+	 */
+	template <typename Handler>
+	void receive(Handler&& handler);
+
+	/**
+	 * @brief Hands the oldest message to a handler in place, waiting at most a given time for one.
+	 * Only the consumer may call this.
+	 * @param handler Function called with a std::span<const std::byte> of the message.
+	 * @param timeout Longest time to wait.
+	 * @return True if a message was handled, false if the time ran out.
+	 */
+	template <typename Handler, typename Rep, typename Period>
+	bool receiveFor(Handler&& handler, const std::chrono::duration<Rep, Period>& timeout);
+
+	/**
+	 * @brief Checks if the queue is empty.
+	 * Called while other processes are working, this is only a snapshot.
+	 * @return True if the queue is empty else false.
+	 */
+	[[nodiscard]] bool isEmpty() const;
+};
+
+template <size_t size, IpcProducers producers>
+IpcQueue<size, producers>::IpcQueue(const std::string& name, IpcRole role) :
+	m_Role(role),
+	m_ProcessId(static_cast<uint32_t>(getpid()))
+{
+	const int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0600);
+	if (fd < 0) throwSystemError("shm_open");
+
+	try {
+		attach(fd);
+	} catch (...) {
+		close(fd);
+		throw;
+	}
+
+	// the mapping keeps the object alive, the descriptor is no longer needed
+	close(fd);
+}
+
+template <size_t size, IpcProducers producers>
+IpcQueue<size, producers>::IpcQueue(int fd, IpcRole role) :
+	m_Role(role),
+	m_ProcessId(static_cast<uint32_t>(getpid()))
+{
+	attach(fd);
+}
+
+template <size_t size, IpcProducers producers>
+IpcQueue<size, producers>::~IpcQueue()
+{
+	unregisterProcess();
+	munmap(m_Control, MAPPING_SIZE);
+}
+
+#ifdef __linux__
+template <size_t size, IpcProducers producers>
+int IpcQueue<size, producers>::createMemoryFile(const std::string& name)
+{
+	const int fd = memfd_create(name.c_str(), MFD_CLOEXEC);
+	if (fd < 0) throwSystemError("memfd_create");
+
+	return fd;
+}
+#endif
+
+template <size_t size, IpcProducers producers>
+void IpcQueue<size, producers>::remove(const std::string& name)
+{
+	shm_unlink(name.c_str());
+}
+
+template <size_t size, IpcProducers producers>
+size_t IpcQueue<size, producers>::recordSize(size_t length)
+{
+	return sizeof(RecordHeader) + (length + RECORD_ALIGNMENT - 1) / RECORD_ALIGNMENT * RECORD_ALIGNMENT;
+}
+
+template <size_t size, IpcProducers producers>
+bool IpcQueue<size, producers>::isAlive(uint32_t processId)
+{
+	// a process owned by another user cannot be signalled but is still alive
+	return processId != 0 && (kill(static_cast<pid_t>(processId), 0) == 0 || errno == EPERM);
+}
+
+template <size_t size, IpcProducers producers>
+void IpcQueue<size, producers>::throwSystemError(const char* what)
+{
+	throw std::system_error(errno, std::generic_category(), what);
+}
+
+template <size_t size, IpcProducers producers>
+void IpcQueue<size, producers>::attach(int fd)
+{
+	struct stat info;
+	if (fstat(fd, &info) != 0) throwSystemError("fstat");
+
+	if (static_cast<size_t>(info.st_size) < MAPPING_SIZE && ftruncate(fd, MAPPING_SIZE) != 0) throwSystemError("ftruncate");
+
+	void* mapping = mmap(nullptr, MAPPING_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (mapping == MAP_FAILED) throwSystemError("mmap");
+
+	m_Control = static_cast<Control*>(mapping);
+	m_Data = static_cast<std::byte*>(mapping) + CONTROL_SIZE;
+
+	lock(m_Control->m_LayoutLock);
+
+	try {
+		const bool laidOut = m_Control->m_Magic.load(std::memory_order_acquire) == MAGIC;
+		const bool matches = laidOut && m_Control->m_Size == size && m_Control->m_Producers == uint32_t(producers);
+
+		// ids are only meaningful in a laid out mapping, anything else is garbage or zeroes
+		const bool inUse = laidOut && hasLiveProcesses();
+
+		if (inUse && !matches)
+			throw std::range_error("IPC queue is in use with a different size or number of producers.");
+
+		if (!inUse) layOut();
+
+		registerProcess();
+	} catch (...) {
+		unlock(m_Control->m_LayoutLock);
+		munmap(mapping, MAPPING_SIZE);
+		throw;
+	}
+
+	unlock(m_Control->m_LayoutLock);
+
+	m_CachedHead = m_Control->m_Head.load(std::memory_order_acquire);
+	m_CachedTail = m_Control->m_Tail.load(std::memory_order_acquire);
+}
+
+template <size_t size, IpcProducers producers>
+void IpcQueue<size, producers>::layOut()
+{
+	Control& control = *m_Control;
+
+	// the layout lock is held, by this process, so it is the one field left alone
+	control.m_Magic.store(0, std::memory_order_relaxed);
+	control.m_Size = size;
+	control.m_Producers = uint32_t(producers);
+
+	control.m_ConsumerId.store(0, std::memory_order_relaxed);
+	for (auto& id : control.m_ProducerIds) {
+		id.store(0, std::memory_order_relaxed);
+	}
+
+	control.m_Head.store(0, std::memory_order_relaxed);
+	control.m_SpaceSignal.store(0, std::memory_order_relaxed);
+	control.m_ProducersWaiting.store(0, std::memory_order_relaxed);
+	control.m_Tail.store(0, std::memory_order_relaxed);
+	control.m_DataSignal.store(0, std::memory_order_relaxed);
+	control.m_ConsumerWaiting.store(0, std::memory_order_relaxed);
+	control.m_ProducerLock.store(0, std::memory_order_relaxed);
+
+	control.m_Magic.store(MAGIC, std::memory_order_release);
+}
+
+template <size_t size, IpcProducers producers>
+bool IpcQueue<size, producers>::hasLiveProcesses() const
+{
+	if (isAlive(m_Control->m_ConsumerId.load(std::memory_order_acquire))) return true;
+
+	for (const auto& id : m_Control->m_ProducerIds) {
+		if (isAlive(id.load(std::memory_order_acquire))) return true;
+	}
+
+	return false;
+}
+
+template <size_t size, IpcProducers producers>
+void IpcQueue<size, producers>::registerProcess()
+{
+	if (m_Role == IpcRole::Consumer) {
+		const uint32_t consumer = m_Control->m_ConsumerId.load(std::memory_order_acquire);
+
+		if (isAlive(consumer))
+			throw std::range_error("IPC queue already has a consumer.");
+
+		m_Control->m_ConsumerId.store(m_ProcessId, std::memory_order_release);
+		return;
+	}
+
+	// a slot is free when empty or when the producer holding it has died
+	for (auto& id : m_Control->m_ProducerIds) {
+		uint32_t holder = id.load(std::memory_order_acquire);
+
+		if ((holder == 0 || !isAlive(holder)) && id.compare_exchange_strong(holder, m_ProcessId, std::memory_order_acq_rel)) return;
+	}
+
+	throw std::range_error("IPC queue already has the most producers it allows.");
+}
+
+template <size_t size, IpcProducers producers>
+void IpcQueue<size, producers>::unregisterProcess()
+{
+	uint32_t self = m_ProcessId;
+
+	if (m_Role == IpcRole::Consumer) {
+		m_Control->m_ConsumerId.compare_exchange_strong(self, 0, std::memory_order_acq_rel);
+		return;
+	}
+
+	// with several producers in one process, free only one of their slots
+	for (auto& id : m_Control->m_ProducerIds) {
+		self = m_ProcessId;
+		if (id.compare_exchange_strong(self, 0, std::memory_order_acq_rel)) return;
+	}
+}
+
+template <size_t size, IpcProducers producers>
+void IpcQueue<size, producers>::lock(std::atomic<uint32_t>& word)
+{
+	static const bool singleCore = std::thread::hardware_concurrency() <= 1;
+
+	for (size_t spins = 1;; ++spins) {
+		uint32_t holder = 0;
+		if (word.compare_exchange_weak(holder, m_ProcessId, std::memory_order_acquire, std::memory_order_relaxed)) return;
+
+		// a holder which died never unlocks, so take the lock over from it
+		if (spins % SPINS_BEFORE_LIVENESS_CHECK == 0 && holder != 0 && !isAlive(holder)) {
+			if (word.compare_exchange_strong(holder, m_ProcessId, std::memory_order_acquire, std::memory_order_relaxed)) return;
+		}
+
+		if (singleCore) std::this_thread::yield();
+		else IPC_QUEUE_PAUSE();
+	}
+}
+
+template <size_t size, IpcProducers producers>
+void IpcQueue<size, producers>::unlock(std::atomic<uint32_t>& word)
+{
+	word.store(0, std::memory_order_release);
+}
+
+template <size_t size, IpcProducers producers>
+bool IpcQueue<size, producers>::hasRoomFor(size_t length)
+{
+	const uint64_t tail = m_Control->m_Tail.load(std::memory_order_relaxed);
+	const size_t offset = size_t(tail) & (size - 1);
+	const size_t total = recordSize(length);
+	const size_t needed = total + (size - offset < total ? size - offset : 0);
+
+	if (tail + needed - m_CachedHead <= size) return true;
+
+	m_CachedHead = m_Control->m_Head.load(std::memory_order_acquire);
+	return tail + needed - m_CachedHead <= size;
+}
+
+template <size_t size, IpcProducers producers>
+bool IpcQueue<size, producers>::write(std::span<const std::byte> message)
+{
+	if (!hasRoomFor(message.size())) return false;
+
+	uint64_t tail = m_Control->m_Tail.load(std::memory_order_relaxed);
+	size_t offset = size_t(tail) & (size - 1);
+	const size_t total = recordSize(message.size());
+
+	// pad out to the end rather than split the message, it goes out in the same publish as the padding
+	if (size - offset < total) {
+		const RecordHeader padding = { uint32_t(size - offset - sizeof(RecordHeader)), PADDING };
+		std::memcpy(m_Data + offset, &padding, sizeof(padding));
+
+		tail += size - offset;
+		offset = 0;
+	}
+
+	const RecordHeader header = { uint32_t(message.size()), MESSAGE };
+	std::memcpy(m_Data + offset, &header, sizeof(header));
+	std::memcpy(m_Data + offset + sizeof(header), message.data(), message.size());
+
+	// release, the record must be visible before the tail which lets the consumer read it
+	m_Control->m_Tail.store(tail + total, std::memory_order_release);
+
+	return true;
+}
+
+template <size_t size, IpcProducers producers>
+void IpcQueue<size, producers>::wakeConsumer()
+{
+	// sequentially consistent with the consumer announcing it will sleep, so either this sees it or it sees the message
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	if (m_Control->m_ConsumerWaiting.load(std::memory_order_relaxed) != 0) {
+		m_Control->m_DataSignal.fetch_add(1, std::memory_order_release);
+		futexWakeOne(m_Control->m_DataSignal, FutexScope::Shared);
+	}
+}
+
+template <size_t size, IpcProducers producers>
+void IpcQueue<size, producers>::wakeProducers()
+{
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	if (m_Control->m_ProducersWaiting.load(std::memory_order_relaxed) != 0) {
+		m_Control->m_SpaceSignal.fetch_add(1, std::memory_order_release);
+		futexWakeAll(m_Control->m_SpaceSignal, FutexScope::Shared);
+	}
+}
+
+template <size_t size, IpcProducers producers>
+template <typename Ready>
+bool IpcQueue<size, producers>::waitUntil(std::atomic<uint32_t>& signal, std::atomic<uint32_t>& waiting, Ready&& ready, std::chrono::steady_clock::time_point deadline)
+{
+	// with a single hardware thread the other side cannot run while this spins
+	static const bool singleCore = std::thread::hardware_concurrency() <= 1;
+
+	if (!singleCore) {
+		for (size_t spin = 0; spin < SPINS_BEFORE_SLEEP; ++spin) {
+			if (ready()) return true;
+			IPC_QUEUE_PAUSE();
+		}
+	}
+
+	// announce the sleep before the last look, so the other side either sees the sleeper or made the change before it
+	waiting.fetch_add(1, std::memory_order_seq_cst);
+	const uint32_t expected = signal.load(std::memory_order_seq_cst);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	bool isReady = ready();
+
+	if (!isReady) {
+		const auto now = std::chrono::steady_clock::now();
+
+		if (deadline == std::chrono::steady_clock::time_point::max()) {
+			futexWait(signal, expected, std::chrono::nanoseconds::max(), FutexScope::Shared);
+		} else if (now < deadline) {
+			futexWait(signal, expected, deadline - now, FutexScope::Shared);
+		}
+
+		isReady = ready();
+	}
+
+	waiting.fetch_sub(1, std::memory_order_relaxed);
+
+	return isReady;
+}
+
+template <size_t size, IpcProducers producers>
+bool IpcQueue<size, producers>::trySend(std::span<const std::byte> message)
+{
+	if (m_Role != IpcRole::Producer)
+		throw std::range_error("Only a producer can send on an IPC queue.");
+
+	if (message.size() > MAX_MESSAGE_SIZE)
+		throw std::range_error("Message is too long for the IPC queue.");
+
+	bool sent;
+
+	if constexpr (producers == IpcProducers::Multiple) {
+		lock(m_Control->m_ProducerLock);
+		sent = write(message);
+		unlock(m_Control->m_ProducerLock);
+	} else {
+		sent = write(message);
+	}
+
+	if (sent) wakeConsumer();
+
+	return sent;
+}
+
+template <size_t size, IpcProducers producers>
+void IpcQueue<size, producers>::send(std::span<const std::byte> message)
+{
+	while (!trySend(message)) {
+		waitUntil(m_Control->m_SpaceSignal, m_Control->m_ProducersWaiting, [&]() { return hasRoomFor(message.size()); }, std::chrono::steady_clock::time_point::max());
+	}
+}
+
+template <size_t size, IpcProducers producers>
+template <typename Rep, typename Period>
+bool IpcQueue<size, producers>::sendFor(std::span<const std::byte> message, const std::chrono::duration<Rep, Period>& timeout)
+{
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(timeout);
+
+	while (!trySend(message)) {
+		if (std::chrono::steady_clock::now() >= deadline) return false;
+
+		waitUntil(m_Control->m_SpaceSignal, m_Control->m_ProducersWaiting, [&]() { return hasRoomFor(message.size()); }, deadline);
+	}
+
+	return true;
+}
+
+template <size_t size, IpcProducers producers>
+template <typename Handler>
+bool IpcQueue<size, producers>::tryReceive(Handler&& handler)
+{
+	if (m_Role != IpcRole::Consumer)
+		throw std::range_error("Only the consumer can receive from an IPC queue.");
+
+	uint64_t head = m_Control->m_Head.load(std::memory_order_relaxed);
+
+	if (head == m_CachedTail) {
+		m_CachedTail = m_Control->m_Tail.load(std::memory_order_acquire);
+		if (head == m_CachedTail) return false;
+	}
+
+	RecordHeader header;
+	std::memcpy(&header, m_Data + (size_t(head) & (size - 1)), sizeof(header));
+
+	// padding is always published together with the message after it, at the start of the buffer
+	if (header.kind == PADDING) {
+		if ((size_t(head) & (size - 1)) + sizeof(RecordHeader) + header.length != size)
+			throw std::range_error("IPC queue holds a corrupt record.");
+
+		head += sizeof(RecordHeader) + header.length;
+		std::memcpy(&header, m_Data + (size_t(head) & (size - 1)), sizeof(header));
+	}
+
+	// the mapping is shared with other processes, so never trust a record to stay inside the buffer
+	if (header.kind != MESSAGE || header.length > MAX_MESSAGE_SIZE || (size_t(head) & (size - 1)) + recordSize(header.length) > size)
+		throw std::range_error("IPC queue holds a corrupt record.");
+
+	handler(std::span<const std::byte>(m_Data + (size_t(head) & (size - 1)) + sizeof(RecordHeader), header.length));
+
+	m_Control->m_Head.store(head + recordSize(header.length), std::memory_order_release);
+	wakeProducers();
+
+	return true;
+}
+
+template <size_t size, IpcProducers producers>
+template <typename Handler>
+void IpcQueue<size, producers>::receive(Handler&& handler)
+{
+	while (!tryReceive(handler)) {
+		waitUntil(m_Control->m_DataSignal, m_Control->m_ConsumerWaiting, [&]() { return !isEmpty(); }, std::chrono::steady_clock::time_point::max());
+	}
+}
+
+template <size_t size, IpcProducers producers>
+template <typename Handler, typename Rep, typename Period>
+bool IpcQueue<size, producers>::receiveFor(Handler&& handler, const std::chrono::duration<Rep, Period>& timeout)
+{
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(timeout);
+
+	while (!tryReceive(handler)) {
+		if (std::chrono::steady_clock::now() >= deadline) return false;
+
+		waitUntil(m_Control->m_DataSignal, m_Control->m_ConsumerWaiting, [&]() { return !isEmpty(); }, deadline);
+	}
+
+	return true;
+}
+
+template <size_t size, IpcProducers producers>
+bool IpcQueue<size, producers>::isEmpty() const
+{
+	return m_Control->m_Head.load(std::memory_order_acquire) == m_Control->m_Tail.load(std::memory_order_acquire);
+}
+
+#endif
@@ -1,6 +1,55 @@
 #include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
 
+#include "AsyncChannel.h"
+#include "BlockingQueue.h"
+#include "ByteRingQueue.h"
+#include "IpcQueue.h"
+#include "MaskedQueue.h"
+#include "MpmcQueue.h"
+#include "PriorityQueue.h"
 #include "Queue.h"
+#include "SpscQueue.h"
+#include "TaskScheduler.h"
+#include "TimerWheel.h"
+#include "UnboundedQueue.h"
+
+DetachedTask countTo(AsyncChannel<int, 4>& channel, int count)
+{
+	for (int i = 1; i <= count; ++i) {
+		co_await channel.send(i);
+	}
+	channel.close();
+}
+
+DetachedTask addUp(AsyncChannel<int, 4>& channel, int& sum)
+{
+	while (const auto item = co_await channel.receive()) {
+		sum += *item;
+	}
+}
+
+uint64_t sumRange(TaskScheduler& scheduler, uint64_t first, uint64_t last)
+{
+	if (last - first <= 1000) {
+		uint64_t sum = 0;
+		for (uint64_t i = first; i < last; ++i) {
+			sum += i;
+		}
+		return sum;
+	}
+
+	const uint64_t middle = first + (last - first) / 2;
+	uint64_t left = 0, right = 0;
+	scheduler.join([&]() { left = sumRange(scheduler, first, middle); }, [&]() { right = sumRange(scheduler, middle, last); });
+
+	return left + right;
+}
 
 int main() {
 
@@ -36,5 +85,190 @@ int main() {
 
 	std::cout << queue2 << std::endl;
 
+	Queue<int, 8> burstRing;
+	const int burst[] = { 10, 20, 30, 40, 50, 60 };
+
+	burstRing.enqueueBulk(burst);
+	std::cout << "Front of a default constructed queue = " << burstRing.deQueue() << std::endl;
+
+	int drained[8];
+	burstRing.enqueueBulk(burst);
+	const size_t drainedCount = burstRing.dequeueBulk(drained, 8);
+	std::cout << "Drained " << drainedCount << " items in bulk, last = " << drained[drainedCount - 1] << std::endl;
+
+	SpscQueue<int, 8> spscQueue;
+
+	std::thread producer([&spscQueue]() {
+		for (int i = 1; i <= 100; ++i) {
+			while (!spscQueue.tryEnqueue(i)) {
+				std::this_thread::yield();
+			}
+		}
+	});
+
+	int received = 0, sum = 0;
+	while (received < 100) {
+		int value;
+
+		if (spscQueue.tryDequeue(value)) {
+			sum += value;
+			++received;
+		} else {
+			std::this_thread::yield();
+		}
+	}
+	producer.join();
+
+	std::cout << "Sum of 100 items handed between threads = " << sum << std::endl;
+
+	MpmcQueue<int, 16> mpmcQueue;
+	std::atomic<int> mpmcSum = 0;
+	std::vector<std::thread> workers;
+
+	for (int producer = 0; producer < 2; ++producer) {
+		workers.emplace_back([&mpmcQueue, producer]() {
+			for (int i = 1; i <= 50; ++i) {
+				mpmcQueue.enqueue(producer * 50 + i);
+			}
+		});
+	}
+
+	for (int consumer = 0; consumer < 2; ++consumer) {
+		workers.emplace_back([&mpmcQueue, &mpmcSum]() {
+			for (int i = 0; i < 50; ++i) {
+				mpmcSum += mpmcQueue.dequeue();
+			}
+		});
+	}
+
+	for (auto& worker : workers) {
+		worker.join();
+	}
+
+	std::cout << "Sum of 100 items shared between 2 producers and 2 consumers = " << mpmcSum << std::endl;
+
+	UnboundedQueue<int> burstQueue = { 1, 2, 3 };
+	std::cout << burstQueue << std::endl;
+
+	for (int i = 0; i < 100000; ++i) {
+		burstQueue.enQueue(i);
+	}
+	std::cout << "Capacity after a burst of 100000 = " << burstQueue.capacity() << std::endl;
+
+	while (burstQueue.currentSize() > 10) {
+		burstQueue.deQueue();
+	}
+	std::cout << "Capacity after draining to 10 = " << burstQueue.capacity() << ", front = " << burstQueue.front() << std::endl;
+
+	MaskedQueue<int, 5> maskedQueue = { 1, 2, 3, 4, 5 };
+	std::cout << "MaskedQueue of size 5 holds " << maskedQueue.MAX_SIZE << " elements" << std::endl;
+
+	for (int i = 6; !maskedQueue.isFull(); ++i) {
+		maskedQueue.deQueue();
+		maskedQueue.enQueue(i);
+		maskedQueue.enQueue(i + 100);
+	}
+	std::cout << maskedQueue << std::endl;
+
+	BlockingQueue<int> blockingQueue;
+	int blockingSum = 0;
+
+	std::thread blockingConsumer([&blockingQueue, &blockingSum]() {
+		int item;
+		while (blockingQueue.pop(item)) {
+			blockingSum += item;
+		}
+	});
+
+	for (int i = 1; i <= 100; ++i) {
+		blockingQueue.push(i);
+	}
+	blockingQueue.close();
+	blockingConsumer.join();
+
+	std::cout << "Sum of 100 items popped until the queue closed = " << blockingSum << std::endl;
+
+	int late;
+	std::cout << "Pop from a closed, drained queue within 10ms: " << std::boolalpha << blockingQueue.tryPopFor(late, std::chrono::milliseconds(10)) << std::endl;
+
+	ManualExecutor executor;
+	AsyncChannel<int, 4> channel(executor);
+	int channelSum = 0;
+
+	addUp(channel, channelSum);
+	countTo(channel, 100);
+	executor.run();
+
+	std::cout << "Sum of 100 items sent between two coroutines through a channel of 4 = " << channelSum << std::endl;
+
+	PriorityQueue<int> deadlines;
+	const int times[] = { 40, 10, 70, 30 };
+	deadlines.pushBulk(times);
+
+	SlotHandle retry = deadlines.pushWithHandle(90);
+	deadlines.decreaseKey(retry, 20);
+
+	std::cout << "Deadlines in order:";
+	while (!deadlines.isEmpty()) {
+		std::cout << " " << deadlines.pop();
+	}
+	std::cout << std::endl;
+
+	const auto start = std::chrono::steady_clock::now();
+	TimerWheel<int> timers(std::chrono::milliseconds(1), start);
+
+	timers.schedule(3, start + std::chrono::milliseconds(300));
+	timers.schedule(1, start + std::chrono::milliseconds(100));
+	SlotHandle cancelled = timers.schedule(2, start + std::chrono::milliseconds(200));
+	timers.cancel(cancelled);
+
+	std::cout << "Timers released in the first 250ms:";
+	DynamicArray<int> released = timers.advance(start + std::chrono::milliseconds(250));
+	for (size_t i = 0; i < released.len(); ++i) {
+		std::cout << " " << released[i];
+	}
+	std::cout << ", still waiting: " << timers.currentSize() << std::endl;
+
+	TaskScheduler scheduler(4);
+	uint64_t rangeSum = 0;
+	scheduler.run([&]() { rangeSum = sumRange(scheduler, 0, 1'000'000); });
+
+	std::cout << "Sum of 0 to 999999 split across " << scheduler.workerCount() << " workers = " << rangeSum << std::endl;
+
+	ByteRingQueue<256> logRing;
+
+	for (const char* line : { "started", "listening on port 8080" }) {
+		// reserve the most a line could take, then commit only what was written
+		std::span<std::byte> reserved = logRing.reserve(64);
+		const size_t written = std::min(std::strlen(line), reserved.size());
+
+		std::memcpy(reserved.data(), line, written);
+		logRing.commit(written);
+	}
+
+	std::cout << "Log records:";
+	for (std::span<const std::byte> record = logRing.peek(); !record.empty(); record = logRing.peek()) {
+		std::cout << " [" << std::string(reinterpret_cast<const char*>(record.data()), record.size()) << "]";
+		logRing.release();
+	}
+	std::cout << std::endl;
+
+#ifdef IPC_QUEUE_SUPPORTED
+	// both ends in one process here, normally they would be two programs opening the same name
+	{
+		IpcQueue<4096> outbox("/queue-demo", IpcRole::Producer);
+		IpcQueue<4096> inbox("/queue-demo", IpcRole::Consumer);
+
+		const std::string greeting = "hello from shared memory";
+		outbox.send(std::as_bytes(std::span(greeting)));
+
+		inbox.receive([](std::span<const std::byte> message) {
+			std::cout << "Received " << message.size() << " bytes: " << std::string(reinterpret_cast<const char*>(message.data()), message.size()) << std::endl;
+		});
+	}
+
+	IpcQueue<4096>::remove("/queue-demo");
+#endif
+
 	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,342 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <initializer_list>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "../DynamicArray/PageAllocation.h"
+
+/**
+ * @brief Where a masked queue keeps its elements.
+ */
+enum class QueueStorage
+{
+	// inside the queue object, like Queue, so a large queue on the stack can overflow it
+	Inline,
+	// in one cache line aligned heap allocation
+	Heap,
+	// straight from the OS, backed by 2 MB huge pages where the OS allows, so a large queue takes few TLB entries
+	HugePages
+};
+
+/**
+ * @brief A queue whose capacity is rounded up to a power of two, so positions are found with a mask instead of a division.
+ * The front and rear are free-running counters which are only masked when a slot is accessed, so the queue is full
+ * when they are a whole capacity apart and empty when they are equal, and no separate size has to be kept.
+ * @tparam T Datatype of queue.
+ * @tparam size Minimum number of elements in the queue, rounded up to a power of two.
+ * @tparam location Where the elements are kept.
+ */
+template <typename T, size_t size, QueueStorage location = QueueStorage::Heap>
+class MaskedQueue
+{
+	static_assert(size != 0, "Queue size must not be zero.");
+
+public:
+	/**
+	 * @brief The maximum size of the queue, the requested size rounded up to a power of two.
+	 */
+	static constexpr size_t MAX_SIZE = std::bit_ceil(size);
+
+private:
+	// raw storage so slots are only constructed while they hold an element
+	struct Slot
+	{
+		alignas(T) unsigned char storage[sizeof(T)];
+	};
+
+	static_assert(sizeof(Slot) == sizeof(T), "Slots must be laid out like an array of T.");
+
+	static constexpr size_t STORAGE_BYTES = MAX_SIZE * sizeof(Slot);
+	static constexpr size_t HEAP_ALIGNMENT = std::max<size_t>(64, alignof(T));
+
+	std::conditional_t<location == QueueStorage::Inline, std::array<Slot, MAX_SIZE>, Slot*> m_Slots;
+	size_t m_Front = 0, m_Rear = 0;
+
+	[[nodiscard]] T* slotAt(size_t index) const;
+
+	template <typename U>
+	void push(U&& item);
+
+public:
+	/**
+	 * @brief Constructs an empty queue, allocating its storage.
+	 */
+	MaskedQueue();
+
+	/**
+	 * @brief Constructs a queue with given elements.
+	 * @param elements Initializer list of elements.
+	 */
+	MaskedQueue(const std::initializer_list<T>& elements);
+
+	/**
+	 * @brief Copy a queue into another queue.
+	 * @param other The queue to copy from.
+	 */
+	MaskedQueue(const MaskedQueue<T, size, location>& other);
+
+	/**
+	 * @brief Copy a queue into another queue.
+	 * @param other The queue to copy from.
+	 * @returns A copy of the given queue.
+	 */
+	MaskedQueue<T, size, location>& operator=(const MaskedQueue<T, size, location>& other);
+
+	~MaskedQueue();
+
+	/**
+	 * @brief Enqueues an item at the end of the queue.
+	 * @param item Item to queue.
+	 */
+	void enQueue(const T& item);
+
+	/**
+	 * @brief Enqueues an item at the end of the queue by moving it.
+	 * @param item Item to queue.
+	 */
+	void enQueue(T&& item);
+
+	/**
+	 * @brief Dequeues the item at the front of the queue.
+	 * @return The dequeued item.
+	 */
+	T deQueue();
+
+	/**
+	 * @brief Enqueues as many items as there is room for at the end of the queue.
+	 * The items are copied in at most two contiguous runs, either side of the end of the storage.
+	 * @param items Items to queue, in order.
+	 * @return The number of items queued, from the start of the given items.
+	 */
+	size_t enqueueBulk(std::span<const T> items);
+
+	/**
+	 * @brief Dequeues up to a given number of items from the front of the queue.
+	 * The items are moved out in at most two contiguous runs.
+	 * @param out Buffer to write the dequeued items to, with room for at least maxCount items.
+	 * @param maxCount Most items to dequeue.
+	 * @return The number of items dequeued.
+	 */
+	size_t dequeueBulk(T* out, size_t maxCount);
+
+	/**
+	 * @brief Dequeue and destroy every element.
+	 */
+	void clear();
+
+	/**
+	 * @brief Returns the current number of elements in the queue.
+	 * @return The number of elements in the queue.
+	 */
+	[[nodiscard]] size_t currentSize() const;
+
+	/**
+	 * @brief Checks if the queue is empty.
+	 * @return True if the queue is empty else false.
+	 */
+	[[nodiscard]] bool isEmpty() const;
+
+	/**
+	 * @brief Checks if the queue is full.
+	 * @return True if the queue is full else false.
+	 */
+	[[nodiscard]] bool isFull() const;
+
+	template<typename U, size_t s, QueueStorage q>
+	friend std::ostream& operator<<(std::ostream& os, const MaskedQueue<U, s, q>& queue);
+};
+
+template <typename T, size_t size, QueueStorage location>
+MaskedQueue<T, size, location>::MaskedQueue()
+{
+	if constexpr (location == QueueStorage::Heap) {
+		m_Slots = static_cast<Slot*>(::operator new(STORAGE_BYTES, std::align_val_t(HEAP_ALIGNMENT)));
+	} else if constexpr (location == QueueStorage::HugePages) {
+		MemoryPlacement placement;
+		placement.pageBacked = true;
+		placement.hugePages = true;
+
+		m_Slots = static_cast<Slot*>(allocatePages(STORAGE_BYTES, placement));
+	}
+}
+
+template <typename T, size_t size, QueueStorage location>
+MaskedQueue<T, size, location>::MaskedQueue(const std::initializer_list<T>& elements) :
+	MaskedQueue()
+{
+	if (elements.size() > MAX_SIZE)
+		throw std::range_error("Too many elements given for maximum queue size.");
+
+	for (const T& element : elements) {
+		enQueue(element);
+	}
+}
+
+template <typename T, size_t size, QueueStorage location>
+MaskedQueue<T, size, location>::MaskedQueue(const MaskedQueue<T, size, location>& other) :
+	MaskedQueue()
+{
+	for (size_t index = other.m_Front; index != other.m_Rear; ++index) {
+		enQueue(*other.slotAt(index));
+	}
+}
+
+template <typename T, size_t size, QueueStorage location>
+MaskedQueue<T, size, location>& MaskedQueue<T, size, location>::operator=(const MaskedQueue<T, size, location>& other)
+{
+	if (this == &other) return *this;
+
+	clear();
+
+	for (size_t index = other.m_Front; index != other.m_Rear; ++index) {
+		enQueue(*other.slotAt(index));
+	}
+
+	return *this;
+}
+
+template <typename T, size_t size, QueueStorage location>
+MaskedQueue<T, size, location>::~MaskedQueue()
+{
+	clear();
+
+	if constexpr (location == QueueStorage::Heap) {
+		::operator delete(m_Slots, std::align_val_t(HEAP_ALIGNMENT));
+	} else if constexpr (location == QueueStorage::HugePages) {
+		freePages(m_Slots, STORAGE_BYTES);
+	}
+}
+
+template <typename T, size_t size, QueueStorage location>
+T* MaskedQueue<T, size, location>::slotAt(size_t index) const
+{
+	const Slot* slots;
+
+	if constexpr (location == QueueStorage::Inline) {
+		slots = m_Slots.data();
+	} else {
+		slots = m_Slots;
+	}
+
+	return std::launder(reinterpret_cast<T*>(const_cast<unsigned char*>(slots[index & (MAX_SIZE - 1)].storage)));
+}
+
+template <typename T, size_t size, QueueStorage location>
+template <typename U>
+void MaskedQueue<T, size, location>::push(U&& item)
+{
+	if (isFull())
+		throw std::range_error("Cannot add item to a full queue.");
+
+	new (slotAt(m_Rear)) T(std::forward<U>(item));
+	++m_Rear;
+}
+
+template <typename T, size_t size, QueueStorage location>
+void MaskedQueue<T, size, location>::enQueue(const T& item)
+{
+	push(item);
+}
+
+template <typename T, size_t size, QueueStorage location>
+void MaskedQueue<T, size, location>::enQueue(T&& item)
+{
+	push(std::move(item));
+}
+
+template <typename T, size_t size, QueueStorage location>
+T MaskedQueue<T, size, location>::deQueue()
+{
+	if (isEmpty())
+		throw std::range_error("Cannot remove item from empty queue.");
+
+	T* element = slotAt(m_Front);
+	T value = std::move(*element);
+
+	element->~T();
+	++m_Front;
+
+	return value;
+}
+
+template <typename T, size_t size, QueueStorage location>
+size_t MaskedQueue<T, size, location>::enqueueBulk(std::span<const T> items)
+{
+	const size_t count = std::min(items.size(), MAX_SIZE - currentSize());
+	const size_t beforeWrap = std::min(count, MAX_SIZE - (m_Rear & (MAX_SIZE - 1)));
+
+	std::uninitialized_copy_n(items.data(), beforeWrap, slotAt(m_Rear));
+	std::uninitialized_copy_n(items.data() + beforeWrap, count - beforeWrap, slotAt(0));
+
+	m_Rear += count;
+	return count;
+}
+
+template <typename T, size_t size, QueueStorage location>
+size_t MaskedQueue<T, size, location>::dequeueBulk(T* out, size_t maxCount)
+{
+	const size_t count = std::min(maxCount, currentSize());
+	const size_t beforeWrap = std::min(count, MAX_SIZE - (m_Front & (MAX_SIZE - 1)));
+
+	T* first = slotAt(m_Front);
+	std::move(first, first + beforeWrap, out);
+	std::destroy_n(first, beforeWrap);
+
+	T* wrapped = slotAt(0);
+	std::move(wrapped, wrapped + (count - beforeWrap), out + beforeWrap);
+	std::destroy_n(wrapped, count - beforeWrap);
+
+	m_Front += count;
+	return count;
+}
+
+template <typename T, size_t size, QueueStorage location>
+void MaskedQueue<T, size, location>::clear()
+{
+	if constexpr (!std::is_trivially_destructible_v<T>) {
+		for (size_t index = m_Front; index != m_Rear; ++index) {
+			slotAt(index)->~T();
+		}
+	}
+
+	m_Front = m_Rear = 0;
+}
+
+template <typename T, size_t size, QueueStorage location>
+size_t MaskedQueue<T, size, location>::currentSize() const
+{
+	// unsigned subtraction stays correct even once the counters wrap around
+	return m_Rear - m_Front;
+}
+
+template <typename T, size_t size, QueueStorage location>
+bool MaskedQueue<T, size, location>::isEmpty() const
+{
+	return m_Rear == m_Front;
+}
+
+template <typename T, size_t size, QueueStorage location>
+bool MaskedQueue<T, size, location>::isFull() const
+{
+	return m_Rear - m_Front == MAX_SIZE;
+}
+
+template<typename T, size_t size, QueueStorage location>
+std::ostream& operator<<(std::ostream& os, const MaskedQueue<T, size, location>& queue) {
+	os << "MaskedQueue = [";
+
+	for (size_t index = queue.m_Front; index != queue.m_Rear; ++index) {
+		os << *queue.slotAt(index) << (index + 1 != queue.m_Rear ? ", " : "");
+	}
+
+	return os << "] Front = " << queue.m_Front << " Rear = " << queue.m_Rear;
+}
@@ -0,0 +1,410 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <new>
+#include <span>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define MPMC_QUEUE_PAUSE() _mm_pause()
+#else
+	#define MPMC_QUEUE_PAUSE() ((void)0)
+#endif
+
+/**
+ * @brief A lock-free bounded queue any number of producer and consumer threads can use at once.
+ * Every slot carries a sequence number saying which turn it is ready for. A producer claims position p from the tail
+ * and may write the slot once its sequence is p, then sets it to p + 1. A consumer claims position p from the head
+ * and may read the slot once its sequence is p + 1, then sets it to p + size, ready for the producer one lap later.
+ * Producers and consumers only meet on the slot they hand over, and every slot sits on its own cache line.
+ * The try operations give up when the queue is full or empty. The blocking operations spin briefly and then sleep on
+ * the slot's sequence number until it is their turn.
+ * @tparam T Datatype of queue.
+ * @tparam size Maximum number of elements in the queue, a power of two.
+ */
+template <typename T, size_t size>
+class MpmcQueue
+{
+	static_assert(size != 0 && (size & (size - 1)) == 0, "Queue size must be a power of two.");
+
+private:
+	struct alignas(64) Slot
+	{
+		std::atomic<size_t> sequence;
+		alignas(T) unsigned char storage[sizeof(T)];
+	};
+
+	// spin this many times waiting for a turn before sleeping, about the length of a short critical section
+	static constexpr size_t SPINS_BEFORE_SLEEP = 128;
+
+	alignas(64) std::atomic<size_t> m_Head = 0;
+	alignas(64) std::atomic<size_t> m_Tail = 0;
+	// threads sleeping in a blocking operation, so hand overs only pay for a wake up when someone is asleep
+	alignas(64) std::atomic<size_t> m_Sleepers = 0;
+
+	alignas(64) std::array<Slot, size> m_Slots;
+
+	[[nodiscard]] static T* element(Slot& slot);
+
+	template <typename U>
+	bool tryPush(U&& item);
+
+	template <typename U>
+	void push(U&& item);
+
+	void waitForTurn(Slot& slot, size_t turn);
+	void publish(Slot& slot, size_t turn);
+	void publishBatch(size_t first, size_t count, size_t turnAhead);
+
+	size_t claimBatch(std::atomic<size_t>& index, size_t& first, size_t maxCount, size_t turnAhead);
+
+public:
+	/**
+	 * @brief The maximum size of the queue.
+	 */
+	static constexpr size_t MAX_SIZE = size;
+
+	/**
+	 * @brief Constructs an empty queue.
+	 */
+	MpmcQueue();
+
+	MpmcQueue(const MpmcQueue<T, size>& other) = delete;
+	MpmcQueue<T, size>& operator=(const MpmcQueue<T, size>& other) = delete;
+
+	~MpmcQueue();
+
+	/**
+	 * @brief Enqueues an item at the end of the queue if there is room.
+	 * @param item Item to queue.
+	 * @return True if the item was queued, false if the queue was full.
+	 */
+	bool tryEnqueue(const T& item);
+
+	/**
+	 * @brief Enqueues an item at the end of the queue by moving it, if there is room.
+	 * @param item Item to queue.
+	 * @return True if the item was queued, false if the queue was full.
+	 */
+	bool tryEnqueue(T&& item);
+
+	/**
+	 * @brief Dequeues the item at the front of the queue if there is one.
+	 * @param item Set to the dequeued item.
+	 * @return True if an item was dequeued, false if the queue was empty.
+	 */
+	bool tryDequeue(T& item);
+
+	/**
+	 * @brief Enqueues an item at the end of the queue, waiting for room if the queue is full.
+	 * @param item Item to queue.
+	 */
+	void enqueue(const T& item);
+
+	/**
+	 * @brief Enqueues an item at the end of the queue by moving it, waiting for room if the queue is full.
+	 * @param item Item to queue.
+	 */
+	void enqueue(T&& item);
+
+	/**
+	 * @brief Dequeues the item at the front of the queue, waiting for one if the queue is empty.
+	 * @return The dequeued item.
+	 */
+	T dequeue();
+
+	/**
+	 * @brief Enqueues as many items as there are free slots for at the end of the queue, without waiting.
+	 * The positions for the whole batch are claimed with a single compare and swap, and sleeping consumers are
+	 * checked for once, though every slot still gets its own sequence number.
+	 * @param items Items to queue, in order.
+	 * @return The number of items queued, from the start of the given items.
+	 */
+	size_t enqueueBulk(std::span<const T> items);
+
+	/**
+	 * @brief Dequeues up to a given number of items from the front of the queue, without waiting.
+	 * The positions for the whole batch are claimed with a single compare and swap.
+	 * @param out Buffer to write the dequeued items to, with room for at least maxCount items.
+	 * @param maxCount Most items to dequeue.
+	 * @return The number of items dequeued.
+	 */
+	size_t dequeueBulk(T* out, size_t maxCount);
+
+	/**
+	 * @brief Returns the current number of elements in the queue.
+	 * Called while other threads are working, this is only a snapshot, and counts items still being written or read.
+	 * @return The number of elements in the queue.
+	 */
+	[[nodiscard]] size_t currentSize() const;
+
+	/**
+	 * @brief Checks if the queue is empty.
+	 * @return True if the queue is empty else false.
+	 */
+	[[nodiscard]] bool isEmpty() const;
+};
+
+template <typename T, size_t size>
+MpmcQueue<T, size>::MpmcQueue()
+{
+	for (size_t i = 0; i < size; ++i) {
+		m_Slots[i].sequence.store(i, std::memory_order_relaxed);
+	}
+}
+
+template <typename T, size_t size>
+MpmcQueue<T, size>::~MpmcQueue()
+{
+	const size_t tail = m_Tail.load(std::memory_order_acquire);
+
+	for (size_t head = m_Head.load(std::memory_order_relaxed); head < tail; ++head) {
+		element(m_Slots[head & (size - 1)])->~T();
+	}
+}
+
+template <typename T, size_t size>
+T* MpmcQueue<T, size>::element(Slot& slot)
+{
+	return std::launder(reinterpret_cast<T*>(slot.storage));
+}
+
+template <typename T, size_t size>
+void MpmcQueue<T, size>::waitForTurn(Slot& slot, size_t turn)
+{
+	for (size_t spin = 0; spin < SPINS_BEFORE_SLEEP; ++spin) {
+		if (slot.sequence.load(std::memory_order_acquire) == turn) return;
+		MPMC_QUEUE_PAUSE();
+	}
+
+	// announce the sleep before the last check, so a hand over either sees the sleeper or happened before the check
+	m_Sleepers.fetch_add(1, std::memory_order_seq_cst);
+
+	for (size_t sequence = slot.sequence.load(std::memory_order_seq_cst); sequence != turn; sequence = slot.sequence.load(std::memory_order_acquire)) {
+		slot.sequence.wait(sequence, std::memory_order_acquire);
+	}
+
+	m_Sleepers.fetch_sub(1, std::memory_order_relaxed);
+}
+
+template <typename T, size_t size>
+void MpmcQueue<T, size>::publish(Slot& slot, size_t turn)
+{
+	// sequentially consistent with the sleeper's announcement, so either this sees it or the sleeper sees the new turn
+	slot.sequence.store(turn, std::memory_order_seq_cst);
+
+	if (m_Sleepers.load(std::memory_order_seq_cst) != 0) {
+		slot.sequence.notify_all();
+	}
+}
+
+template <typename T, size_t size>
+void MpmcQueue<T, size>::publishBatch(size_t first, size_t count, size_t turnAhead)
+{
+	for (size_t i = 0; i < count; ++i) {
+		m_Slots[(first + i) & (size - 1)].sequence.store(first + i + turnAhead, std::memory_order_release);
+	}
+
+	// one fence for the batch stands in for every store being sequentially consistent
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	if (m_Sleepers.load(std::memory_order_relaxed) != 0) {
+		for (size_t i = 0; i < count; ++i) {
+			m_Slots[(first + i) & (size - 1)].sequence.notify_all();
+		}
+	}
+}
+
+template <typename T, size_t size>
+size_t MpmcQueue<T, size>::claimBatch(std::atomic<size_t>& index, size_t& first, size_t maxCount, size_t turnAhead)
+{
+	if (maxCount == 0) return 0;
+
+	first = index.load(std::memory_order_relaxed);
+
+	for (;;) {
+		// count the slots ready for consecutive positions, a slot claimed by another thread but not yet published still
+		// looks ready, but then the index has moved on and the compare and swap fails
+		size_t count = 0;
+		while (count < maxCount && m_Slots[(first + count) & (size - 1)].sequence.load(std::memory_order_acquire) == first + count + turnAhead) {
+			++count;
+		}
+
+		if (count == 0) {
+			const size_t sequence = m_Slots[first & (size - 1)].sequence.load(std::memory_order_acquire);
+			if (static_cast<intptr_t>(sequence - (first + turnAhead)) < 0) return 0;
+
+			first = index.load(std::memory_order_relaxed);
+		} else if (index.compare_exchange_weak(first, first + count, std::memory_order_relaxed)) {
+			return count;
+		}
+	}
+}
+
+template <typename T, size_t size>
+template <typename U>
+bool MpmcQueue<T, size>::tryPush(U&& item)
+{
+	size_t tail = m_Tail.load(std::memory_order_relaxed);
+	Slot* slot;
+
+	for (;;) {
+		slot = &m_Slots[tail & (size - 1)];
+
+		const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+		const auto lag = static_cast<intptr_t>(sequence - tail);
+
+		if (lag == 0) {
+			// the slot is free for this position, claim the position if no other producer got there first
+			if (m_Tail.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed)) break;
+		} else if (lag < 0) {
+			// the slot still holds the element from the previous lap
+			return false;
+		} else {
+			tail = m_Tail.load(std::memory_order_relaxed);
+		}
+	}
+
+	new (slot->storage) T(std::forward<U>(item));
+	publish(*slot, tail + 1);
+
+	return true;
+}
+
+template <typename T, size_t size>
+template <typename U>
+void MpmcQueue<T, size>::push(U&& item)
+{
+	// take a ticket unconditionally, the slot is ours once the consumer from the previous lap has finished with it
+	const size_t tail = m_Tail.fetch_add(1, std::memory_order_relaxed);
+	Slot& slot = m_Slots[tail & (size - 1)];
+
+	waitForTurn(slot, tail);
+
+	new (slot.storage) T(std::forward<U>(item));
+	publish(slot, tail + 1);
+}
+
+template <typename T, size_t size>
+bool MpmcQueue<T, size>::tryEnqueue(const T& item)
+{
+	return tryPush(item);
+}
+
+template <typename T, size_t size>
+bool MpmcQueue<T, size>::tryEnqueue(T&& item)
+{
+	return tryPush(std::move(item));
+}
+
+template <typename T, size_t size>
+bool MpmcQueue<T, size>::tryDequeue(T& item)
+{
+	size_t head = m_Head.load(std::memory_order_relaxed);
+	Slot* slot;
+
+	for (;;) {
+		slot = &m_Slots[head & (size - 1)];
+
+		const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+		const auto lag = static_cast<intptr_t>(sequence - (head + 1));
+
+		if (lag == 0) {
+			if (m_Head.compare_exchange_weak(head, head + 1, std::memory_order_relaxed)) break;
+		} else if (lag < 0) {
+			// the producer for this position has not finished writing
+			return false;
+		} else {
+			head = m_Head.load(std::memory_order_relaxed);
+		}
+	}
+
+	T* stored = element(*slot);
+	item = std::move(*stored);
+	stored->~T();
+
+	publish(*slot, head + size);
+
+	return true;
+}
+
+template <typename T, size_t size>
+void MpmcQueue<T, size>::enqueue(const T& item)
+{
+	push(item);
+}
+
+template <typename T, size_t size>
+void MpmcQueue<T, size>::enqueue(T&& item)
+{
+	push(std::move(item));
+}
+
+template <typename T, size_t size>
+T MpmcQueue<T, size>::dequeue()
+{
+	const size_t head = m_Head.fetch_add(1, std::memory_order_relaxed);
+	Slot& slot = m_Slots[head & (size - 1)];
+
+	waitForTurn(slot, head + 1);
+
+	T* stored = element(slot);
+	T item = std::move(*stored);
+	stored->~T();
+
+	publish(slot, head + size);
+
+	return item;
+}
+
+template <typename T, size_t size>
+size_t MpmcQueue<T, size>::enqueueBulk(std::span<const T> items)
+{
+	size_t tail;
+	const size_t count = claimBatch(m_Tail, tail, items.size(), 0);
+	if (count == 0) return 0;
+
+	for (size_t i = 0; i < count; ++i) {
+		new (m_Slots[(tail + i) & (size - 1)].storage) T(items[i]);
+	}
+
+	publishBatch(tail, count, 1);
+	return count;
+}
+
+template <typename T, size_t size>
+size_t MpmcQueue<T, size>::dequeueBulk(T* out, size_t maxCount)
+{
+	size_t head;
+	const size_t count = claimBatch(m_Head, head, maxCount, 1);
+	if (count == 0) return 0;
+
+	for (size_t i = 0; i < count; ++i) {
+		T* stored = element(m_Slots[(head + i) & (size - 1)]);
+
+		out[i] = std::move(*stored);
+		stored->~T();
+	}
+
+	publishBatch(head, count, size);
+	return count;
+}
+
+template <typename T, size_t size>
+size_t MpmcQueue<T, size>::currentSize() const
+{
+	const size_t head = m_Head.load(std::memory_order_acquire);
+	const size_t tail = m_Tail.load(std::memory_order_acquire);
+
+	// blocking consumers can claim positions ahead of the producers, which reads as an empty queue
+	return tail > head ? tail - head : 0;
+}
+
+template <typename T, size_t size>
+bool MpmcQueue<T, size>::isEmpty() const
+{
+	return currentSize() == 0;
+}
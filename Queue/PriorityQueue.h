@@ -0,0 +1,519 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <stdexcept>
+#include <utility>
+
+#include "../DynamicArray/DynamicArray.h"
+#include "../DynamicArray/SlotMap.h"
+
+/**
+ * @brief A priority queue stored as a d-ary heap in one contiguous array.
+ * The item which comes first under Compare is at the top, so the default std::less pops the smallest item first,
+ * the opposite way round to std::priority_queue, which suits ordering by deadline.
+ * The root is at position 0 with only Arity - 1 children, at positions 1 to Arity - 1, so every other node's children
+ * start on a multiple of Arity of the cache line aligned array and, for small items, share one cache line, without any
+ * padding items before the root. Items pushed with pushWithHandle get a handle, like a slot map's,
+ * which stays valid until the item is popped or erased, and which can move it towards the top with decreaseKey.
+ * Keeping handles current means moving a slot index alongside every item, so the slot indices live in a parallel
+ * array which only exists while a handle is live, and the heap stays as dense as the items themselves.
+ * @tparam T Datatype of queue.
+ * @tparam Compare Ordering of the items, true when the first argument should be popped before the second.
+ * @tparam Arity Number of children of each node, 2, 4 or 8.
+ */
+template <typename T, typename Compare = std::less<T>, size_t Arity = 4>
+class PriorityQueue
+{
+	static_assert(Arity == 2 || Arity == 4 || Arity == 8, "Priority queue arity must be 2, 4 or 8.");
+
+private:
+	struct HandleSlot
+	{
+		// position of the item in m_Heap while in use, otherwise the next free slot
+		uint32_t positionOrNextFree = 0;
+		// starts at 1, so a default constructed handle is never live
+		uint32_t generation = 1;
+	};
+
+	static constexpr uint32_t NO_FREE_SLOT = UINT32_MAX;
+	// the slot of an item which was pushed without a handle
+	static constexpr uint32_t UNTRACKED = UINT32_MAX;
+
+	static constexpr size_t ROOT = 0;
+
+	DynamicArray<T> m_Heap;
+	// the slot of the item at each position of m_Heap, empty while there are no live handles
+	DynamicArray<uint32_t> m_HeapSlots;
+	DynamicArray<HandleSlot> m_Slots;
+	uint32_t m_FreeHead = NO_FREE_SLOT;
+	size_t m_LiveHandles = 0;
+	bool m_Tracking = false;
+	[[no_unique_address]] Compare m_Compare;
+
+	[[nodiscard]] static size_t firstChild(size_t position);
+	[[nodiscard]] static size_t parent(size_t position);
+
+	[[nodiscard]] bool isLive(const SlotHandle& handle) const;
+	[[nodiscard]] bool isTracking() const;
+	[[nodiscard]] uint32_t slotAt(size_t position) const;
+
+	uint32_t acquireSlot();
+	void releaseSlot(uint32_t slot);
+	void stopTrackingIfUnused();
+
+	void place(size_t position, T&& item, uint32_t slot);
+	[[nodiscard]] size_t bestChild(size_t first) const;
+
+	void siftUp(size_t position, T item, uint32_t slot);
+	void siftDown(size_t position, T item, uint32_t slot);
+
+	template <typename U>
+	void pushTracked(U&& item, uint32_t slot);
+
+public:
+	/**
+	 * @brief Constructs an empty priority queue.
+	 * @param compare Ordering of the items.
+	 */
+	explicit PriorityQueue(const Compare& compare = Compare());
+
+	/**
+	 * @brief Pushes an item onto the queue.
+	 * @param item Item to push.
+	 */
+	void push(const T& item);
+
+	/**
+	 * @brief Pushes an item onto the queue by moving it.
+	 * @param item Item to push.
+	 */
+	void push(T&& item);
+
+	/**
+	 * @brief Pushes an item onto the queue and tracks where it is, so it can later be found by its handle.
+	 * @param item Item to push.
+	 * @return Handle to the item, valid until it is popped or erased.
+	 */
+	SlotHandle pushWithHandle(const T& item);
+
+	/**
+	 * @brief Pushes many items onto the queue at once.
+	 * When the items at least double the queue it is rebuilt bottom up in O(n), rather than sifting each item up.
+	 * @param items Items to push.
+	 */
+	void pushBulk(std::span<const T> items);
+
+	/**
+	 * @brief Pops the item at the top of the queue.
+	 * The hole left at the top is moved down to a leaf by always taking the best child, without comparing against the
+	 * item which will fill it, then the last item is sifted up from there. Picking the best child is a branch free
+	 * select and the sift up almost always stops straight away, so there are few unpredictable branches. As a select
+	 * cannot run ahead to the next level the way a predicted branch does, the grandchildren are prefetched instead.
+	 * @return The popped item.
+	 */
+	T pop();
+
+	/**
+	 * @brief Returns the item at the top of the queue.
+	 * @return Constant reference to the top item.
+	 */
+	[[nodiscard]] const T& top() const;
+
+	/**
+	 * @brief Moves an item towards the top by giving it a value which comes no later than its current one.
+	 * @param handle Handle of the item.
+	 * @param item The item's new value.
+	 */
+	void decreaseKey(const SlotHandle& handle, const T& item);
+
+	/**
+	 * @brief Removes an item from anywhere in the queue.
+	 * @param handle Handle of the item.
+	 */
+	void erase(const SlotHandle& handle);
+
+	/**
+	 * @brief Returns whether a handle refers to an item which has not been popped or erased.
+	 * @param handle Handle to check.
+	 * @return If the handle is valid.
+	 */
+	[[nodiscard]] bool contains(const SlotHandle& handle) const;
+
+	/**
+	 * @brief Returns the item a handle refers to.
+	 * @param handle Handle of the item.
+	 * @return Constant reference to the item.
+	 */
+	[[nodiscard]] const T& at(const SlotHandle& handle) const;
+
+	/**
+	 * @brief Reserves space for a number of items, so pushing up to it does not reallocate.
+	 * @param count Number of items to reserve space for.
+	 */
+	void reserve(size_t count);
+
+	/**
+	 * @brief Removes every item, invalidating every handle.
+	 */
+	void clear();
+
+	/**
+	 * @brief Returns the current number of items in the queue.
+	 * @return The number of items in the queue.
+	 */
+	[[nodiscard]] size_t currentSize() const;
+
+	/**
+	 * @brief Checks if the queue is empty.
+	 * @return True if the queue is empty else false.
+	 */
+	[[nodiscard]] bool isEmpty() const;
+};
+
+template <typename T, typename Compare, size_t Arity>
+PriorityQueue<T, Compare, Arity>::PriorityQueue(const Compare& compare) :
+	m_Compare(compare)
+{
+	// a burst of pops would otherwise shrink the heap only for the next pushes to grow it again
+	m_Heap.setAutoShrink(false);
+	m_HeapSlots.setAutoShrink(false);
+}
+
+template <typename T, typename Compare, size_t Arity>
+size_t PriorityQueue<T, Compare, Arity>::firstChild(size_t position)
+{
+	// the root's children start at 1, every other node's start on a multiple of Arity
+	return Arity * position + (position == ROOT);
+}
+
+template <typename T, typename Compare, size_t Arity>
+size_t PriorityQueue<T, Compare, Arity>::parent(size_t position)
+{
+	return position / Arity;
+}
+
+template <typename T, typename Compare, size_t Arity>
+bool PriorityQueue<T, Compare, Arity>::isLive(const SlotHandle& handle) const
+{
+	return handle.index < m_Slots.len() && m_Slots[handle.index].generation == handle.generation;
+}
+
+template <typename T, typename Compare, size_t Arity>
+bool PriorityQueue<T, Compare, Arity>::isTracking() const
+{
+	return m_Tracking;
+}
+
+template <typename T, typename Compare, size_t Arity>
+uint32_t PriorityQueue<T, Compare, Arity>::slotAt(size_t position) const
+{
+	return isTracking() ? m_HeapSlots.data()[position] : UNTRACKED;
+}
+
+template <typename T, typename Compare, size_t Arity>
+uint32_t PriorityQueue<T, Compare, Arity>::acquireSlot()
+{
+	// the first live handle starts tracking every position, none of the items already there have a slot
+	if (!isTracking()) {
+		m_HeapSlots.resize(m_Heap.len(), UNTRACKED);
+		m_Tracking = true;
+	}
+
+	++m_LiveHandles;
+
+	if (m_FreeHead == NO_FREE_SLOT) {
+		m_Slots.append(HandleSlot());
+		return static_cast<uint32_t>(m_Slots.len() - 1);
+	}
+
+	const uint32_t slot = m_FreeHead;
+	m_FreeHead = m_Slots[slot].positionOrNextFree;
+
+	return slot;
+}
+
+template <typename T, typename Compare, size_t Arity>
+void PriorityQueue<T, Compare, Arity>::releaseSlot(uint32_t slot)
+{
+	// skip generation 0 when it wraps, a default constructed handle must never come back to life
+	if (++m_Slots[slot].generation == 0) m_Slots[slot].generation = 1;
+	m_Slots[slot].positionOrNextFree = m_FreeHead;
+	m_FreeHead = slot;
+
+	--m_LiveHandles;
+}
+
+template <typename T, typename Compare, size_t Arity>
+void PriorityQueue<T, Compare, Arity>::stopTrackingIfUnused()
+{
+	// with the last handle gone nothing needs finding, so stop moving slot indices around
+	if (m_LiveHandles == 0 && isTracking()) {
+		m_HeapSlots.clear();
+		m_Tracking = false;
+	}
+}
+
+template <typename T, typename Compare, size_t Arity>
+void PriorityQueue<T, Compare, Arity>::place(size_t position, T&& item, uint32_t slot)
+{
+	m_Heap.data()[position] = std::move(item);
+
+	if (isTracking()) {
+		m_HeapSlots.data()[position] = slot;
+		if (slot != UNTRACKED) m_Slots[slot].positionOrNextFree = static_cast<uint32_t>(position);
+	}
+}
+
+template <typename T, typename Compare, size_t Arity>
+size_t PriorityQueue<T, Compare, Arity>::bestChild(size_t first) const
+{
+	const T* heap = m_Heap.data();
+	size_t best = first;
+
+	// a full group has a fixed trip count the compiler can unroll, and each step is a conditional move rather than a branch
+	if (first != ROOT + 1 && first + Arity <= m_Heap.len()) {
+		for (size_t child = first + 1; child < first + Arity; ++child) {
+			best = m_Compare(heap[child], heap[best]) ? child : best;
+		}
+	} else {
+		// the root's group is one short, and ends where the next multiple of Arity starts
+		const size_t groupEnd = std::min((first | (Arity - 1)) + 1, m_Heap.len());
+
+		for (size_t child = first + 1; child < groupEnd; ++child) {
+			best = m_Compare(heap[child], heap[best]) ? child : best;
+		}
+	}
+
+	return best;
+}
+
+template <typename T, typename Compare, size_t Arity>
+void PriorityQueue<T, Compare, Arity>::siftUp(size_t position, T item, uint32_t slot)
+{
+	T* heap = m_Heap.data();
+
+	while (position > ROOT) {
+		const size_t above = parent(position);
+		if (!m_Compare(item, heap[above])) break;
+
+		place(position, std::move(heap[above]), slotAt(above));
+		position = above;
+	}
+
+	place(position, std::move(item), slot);
+}
+
+template <typename T, typename Compare, size_t Arity>
+void PriorityQueue<T, Compare, Arity>::siftDown(size_t position, T item, uint32_t slot)
+{
+	T* heap = m_Heap.data();
+
+	for (size_t child = firstChild(position); child < m_Heap.len(); child = firstChild(position)) {
+		const size_t best = bestChild(child);
+		if (!m_Compare(heap[best], item)) break;
+
+		place(position, std::move(heap[best]), slotAt(best));
+		position = best;
+	}
+
+	place(position, std::move(item), slot);
+}
+
+template <typename T, typename Compare, size_t Arity>
+template <typename U>
+void PriorityQueue<T, Compare, Arity>::pushTracked(U&& item, uint32_t slot)
+{
+	m_Heap.append(std::forward<U>(item));
+	if (isTracking()) m_HeapSlots.append(slot);
+
+	const size_t last = m_Heap.len() - 1;
+	siftUp(last, std::move(m_Heap[last]), slot);
+}
+
+template <typename T, typename Compare, size_t Arity>
+void PriorityQueue<T, Compare, Arity>::push(const T& item)
+{
+	pushTracked(item, UNTRACKED);
+}
+
+template <typename T, typename Compare, size_t Arity>
+void PriorityQueue<T, Compare, Arity>::push(T&& item)
+{
+	pushTracked(std::move(item), UNTRACKED);
+}
+
+template <typename T, typename Compare, size_t Arity>
+SlotHandle PriorityQueue<T, Compare, Arity>::pushWithHandle(const T& item)
+{
+	const uint32_t slot = acquireSlot();
+	pushTracked(item, slot);
+
+	return { slot, m_Slots[slot].generation };
+}
+
+template <typename T, typename Compare, size_t Arity>
+void PriorityQueue<T, Compare, Arity>::pushBulk(std::span<const T> items)
+{
+	const size_t oldSize = currentSize();
+
+	m_Heap.reserve(m_Heap.len() + items.size());
+	for (const T& item : items) {
+		m_Heap.append(item);
+	}
+
+	if (isTracking()) {
+		m_HeapSlots.resize(m_Heap.len(), UNTRACKED);
+	}
+
+	if (items.size() < oldSize) {
+		for (size_t position = m_Heap.len() - items.size(); position < m_Heap.len(); ++position) {
+			siftUp(position, std::move(m_Heap[position]), UNTRACKED);
+		}
+		return;
+	}
+
+	if (currentSize() < 2) return;
+
+	// Floyd's heap construction, most nodes are near the bottom and only sift down a level or two
+	for (size_t position = parent(m_Heap.len() - 1) + 1; position-- > ROOT;) {
+		siftDown(position, std::move(m_Heap[position]), slotAt(position));
+	}
+}
+
+template <typename T, typename Compare, size_t Arity>
+T PriorityQueue<T, Compare, Arity>::pop()
+{
+	if (isEmpty())
+		throw std::range_error("Cannot pop item from empty priority queue.");
+
+	T top = std::move(m_Heap[ROOT]);
+
+	if (const uint32_t topSlot = slotAt(ROOT); topSlot != UNTRACKED) {
+		releaseSlot(topSlot);
+	}
+
+	const uint32_t lastSlot = isTracking() ? m_HeapSlots.pop() : UNTRACKED;
+	T last = m_Heap.pop();
+
+	if (!isEmpty()) {
+		const T* heap = m_Heap.data();
+		size_t hole = ROOT;
+
+		for (size_t child = firstChild(hole); child < m_Heap.len(); child = firstChild(hole)) {
+			// the next level down is one of these children's groups, which sit side by side, so fetch them all now
+			if (firstChild(child) < m_Heap.len()) {
+				const char* grandchildren = reinterpret_cast<const char*>(heap + firstChild(child));
+
+				for (size_t offset = 0; offset < Arity * Arity * sizeof(T); offset += 64) {
+					DYNAMIC_ARRAY_PREFETCH_READ(grandchildren + offset);
+				}
+			}
+
+			const size_t best = bestChild(child);
+
+			place(hole, std::move(m_Heap.data()[best]), slotAt(best));
+			hole = best;
+		}
+
+		siftUp(hole, std::move(last), lastSlot);
+	}
+
+	stopTrackingIfUnused();
+
+	return top;
+}
+
+template <typename T, typename Compare, size_t Arity>
+const T& PriorityQueue<T, Compare, Arity>::top() const
+{
+	if (isEmpty())
+		throw std::range_error("Cannot get top of empty priority queue.");
+
+	return m_Heap[ROOT];
+}
+
+template <typename T, typename Compare, size_t Arity>
+void PriorityQueue<T, Compare, Arity>::decreaseKey(const SlotHandle& handle, const T& item)
+{
+	if (!isLive(handle))
+		throw std::range_error("Priority queue handle refers to a popped item.");
+
+	const size_t position = m_Slots[handle.index].positionOrNextFree;
+
+	if (m_Compare(m_Heap[position], item))
+		throw std::range_error("Cannot decrease a key to a value which comes after it.");
+
+	siftUp(position, item, handle.index);
+}
+
+template <typename T, typename Compare, size_t Arity>
+void PriorityQueue<T, Compare, Arity>::erase(const SlotHandle& handle)
+{
+	if (!isLive(handle))
+		throw std::range_error("Priority queue handle refers to a popped item.");
+
+	const size_t position = m_Slots[handle.index].positionOrNextFree;
+	releaseSlot(handle.index);
+
+	const uint32_t lastSlot = m_HeapSlots.pop();
+	T last = m_Heap.pop();
+
+	// the hole is filled with the last item, which may belong above or below it
+	if (position != m_Heap.len()) {
+		if (position > ROOT && m_Compare(last, m_Heap[parent(position)])) {
+			siftUp(position, std::move(last), lastSlot);
+		} else {
+			siftDown(position, std::move(last), lastSlot);
+		}
+	}
+
+	stopTrackingIfUnused();
+}
+
+template <typename T, typename Compare, size_t Arity>
+bool PriorityQueue<T, Compare, Arity>::contains(const SlotHandle& handle) const
+{
+	return isLive(handle);
+}
+
+template <typename T, typename Compare, size_t Arity>
+const T& PriorityQueue<T, Compare, Arity>::at(const SlotHandle& handle) const
+{
+	if (!isLive(handle))
+		throw std::range_error("Priority queue handle refers to a popped item.");
+
+	return m_Heap[m_Slots[handle.index].positionOrNextFree];
+}
+
+template <typename T, typename Compare, size_t Arity>
+void PriorityQueue<T, Compare, Arity>::reserve(size_t count)
+{
+	m_Heap.reserve(count);
+}
+
+template <typename T, typename Compare, size_t Arity>
+void PriorityQueue<T, Compare, Arity>::clear()
+{
+	for (size_t position = ROOT; position < m_HeapSlots.len(); ++position) {
+		if (m_HeapSlots[position] != UNTRACKED) releaseSlot(m_HeapSlots[position]);
+	}
+
+	m_HeapSlots.clear();
+	m_Tracking = false;
+	m_Heap.clear();
+}
+
+template <typename T, typename Compare, size_t Arity>
+size_t PriorityQueue<T, Compare, Arity>::currentSize() const
+{
+	return m_Heap.len();
+}
+
+template <typename T, typename Compare, size_t Arity>
+bool PriorityQueue<T, Compare, Arity>::isEmpty() const
+{
+	return m_Heap.isEmpty();
+}
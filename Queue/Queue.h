@@ -5,6 +5,8 @@
 #include <iostream>
 #include <array>
 #include <algorithm>
+#include <span>
+#include <utility>
 
 /**
  * @brief Queue data structure.
@@ -16,7 +18,8 @@ class Queue
 {
 private:
 	std::array<T, size> m_Data = {};
-	size_t m_Front = 0, m_Rear = 0, m_CurrentSize = 0;
+	// the rear is the index of the last item, so an empty queue's rear sits just before the front
+	size_t m_Front = 0, m_Rear = size - 1, m_CurrentSize = 0;
 
 public:
 	/**
@@ -29,12 +32,12 @@ public:
 	 * Iterates through each element and enqueues it.
 	 * @param elements Initializer list of elements.
 	*/
-	Queue<T, size>(const std::initializer_list<T>& elements);
+	Queue(const std::initializer_list<T>& elements);
 
 	/**
 	 * @brief Constructs and empty queue.
 	*/
-	Queue<T, size>() = default;
+	Queue() = default;
 
 	/**
 	 * @brief Enqueues an item at the end of the queue.
@@ -42,12 +45,36 @@ public:
 	*/
 	void enQueue(const T& item);
 
+	/**
+	 * @brief Enqueues an item at the end of the queue by moving it.
+	 * @param item Item to queue.
+	*/
+	void enQueue(T&& item);
+
 	/**
 	 * @brief Dequeues the item at the front of the queue.
 	 * @return The dequeued item.
 	*/
 	T deQueue();
 
+	/**
+	 * @brief Enqueues as many items as there is room for at the end of the queue.
+	 * The items are copied in at most two contiguous runs, either side of the end of the storage,
+	 * and the indices are updated once for the whole batch.
+	 * @param items Items to queue, in order.
+	 * @return The number of items queued, from the start of the given items.
+	*/
+	size_t enqueueBulk(std::span<const T> items);
+
+	/**
+	 * @brief Dequeues up to a given number of items from the front of the queue.
+	 * The items are copied out in at most two contiguous runs and the indices are updated once for the whole batch.
+	 * @param out Buffer to write the dequeued items to, with room for at least maxCount items.
+	 * @param maxCount Most items to dequeue.
+	 * @return The number of items dequeued.
+	*/
+	size_t dequeueBulk(T* out, size_t maxCount);
+
 	/**
 	 * @brief Returns the current number of elements in the queue.
 	 * @return The number of elements in the queue.
@@ -66,13 +93,13 @@ public:
 	*/
 	[[nodiscard]] bool isFull() const;
 	
-	template<typename T, size_t size>
-	friend std::ostream& operator<<(std::ostream& os, const Queue<T, size>& queue);
+	template<typename U, size_t s>
+	friend std::ostream& operator<<(std::ostream& os, const Queue<U, s>& queue);
 };
 
 template <typename T, size_t size>
 Queue<T, size>::Queue(const std::initializer_list<T>& elements) :
-	m_Rear(elements.size() - 1), m_CurrentSize(elements.size())
+	m_Rear((elements.size() + size - 1) % size), m_CurrentSize(elements.size())
 {
 	if (elements.size() > MAX_SIZE)
 		throw std::range_error("Too many elements given for maximum queue size.");
@@ -92,13 +119,26 @@ void Queue<T, size>::enQueue(const T& item)
 	++m_CurrentSize;
 }
 
+template<typename T, size_t size>
+void Queue<T, size>::enQueue(T&& item)
+{
+	if (isFull())
+		throw std::range_error("Cannot add item to a full queue.");
+
+	m_Rear = (m_Rear + 1) % MAX_SIZE;
+	m_Data[m_Rear] = std::move(item);
+
+	++m_CurrentSize;
+}
+
 template<typename T, size_t size>
 T Queue<T, size>::deQueue()
 {
 	if (isEmpty())
 		throw std::range_error("Cannot remove item from empty queue.");
 
-	const T& value = m_Data[m_Front];
+	// the slot is dead once dequeued, so the item can be moved out rather than copied
+	T value = std::move(m_Data[m_Front]);
 
 	m_Front = (m_Front + 1) % MAX_SIZE;
 	--m_CurrentSize;
@@ -106,6 +146,37 @@ T Queue<T, size>::deQueue()
 	return value;
 }
 
+template<typename T, size_t size>
+size_t Queue<T, size>::enqueueBulk(std::span<const T> items)
+{
+	const size_t count = std::min(items.size(), MAX_SIZE - m_CurrentSize);
+	const size_t start = (m_Rear + 1) % MAX_SIZE;
+	const size_t beforeWrap = std::min(count, MAX_SIZE - start);
+
+	std::copy_n(items.data(), beforeWrap, m_Data.begin() + start);
+	std::copy_n(items.data() + beforeWrap, count - beforeWrap, m_Data.begin());
+
+	m_Rear = (m_Rear + count) % MAX_SIZE;
+	m_CurrentSize += count;
+
+	return count;
+}
+
+template<typename T, size_t size>
+size_t Queue<T, size>::dequeueBulk(T* out, size_t maxCount)
+{
+	const size_t count = std::min(maxCount, m_CurrentSize);
+	const size_t beforeWrap = std::min(count, MAX_SIZE - m_Front);
+
+	std::move(m_Data.begin() + m_Front, m_Data.begin() + m_Front + beforeWrap, out);
+	std::move(m_Data.begin(), m_Data.begin() + (count - beforeWrap), out + beforeWrap);
+
+	m_Front = (m_Front + count) % MAX_SIZE;
+	m_CurrentSize -= count;
+
+	return count;
+}
+
 template<typename T, size_t size>
 size_t Queue<T, size>::currentSize() const
 {
@@ -0,0 +1,284 @@
+#pragma once
+
+#include <array>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <utility>
+
+/**
+ * @brief A lock-free bounded queue for exactly one producer thread and one consumer thread.
+ * The head and tail are free-running counters on their own cache lines, so the two threads never write to the same line,
+ * and each thread keeps a cached copy of the other's index so it only reads the shared one when the queue looks full or empty.
+ * The size must be a power of two, so a counter is turned into a position with a mask.
+ * @tparam T Datatype of queue.
+ * @tparam size Maximum number of elements in the queue, a power of two.
+ */
+template <typename T, size_t size>
+class SpscQueue
+{
+	static_assert(size != 0 && (size & (size - 1)) == 0, "Queue size must be a power of two.");
+
+private:
+	// raw storage so slots are only constructed while they hold an element
+	struct Slot
+	{
+		alignas(T) unsigned char storage[sizeof(T)];
+	};
+
+	// the consumer's line, written only by the consumer
+	alignas(64) std::atomic<size_t> m_Head = 0;
+	size_t m_CachedTail = 0;
+
+	// the producer's line, written only by the producer
+	alignas(64) std::atomic<size_t> m_Tail = 0;
+	size_t m_CachedHead = 0;
+
+	alignas(64) std::array<Slot, size> m_Slots;
+
+	static_assert(sizeof(Slot) == sizeof(T), "Slots must be laid out like an array of T.");
+
+	[[nodiscard]] T* slotAt(size_t index);
+
+	template <typename U>
+	bool push(U&& item);
+
+public:
+	/**
+	 * @brief The maximum size of the queue.
+	 */
+	static constexpr size_t MAX_SIZE = size;
+
+	/**
+	 * @brief Constructs an empty queue.
+	 */
+	SpscQueue() = default;
+
+	SpscQueue(const SpscQueue<T, size>& other) = delete;
+	SpscQueue<T, size>& operator=(const SpscQueue<T, size>& other) = delete;
+
+	~SpscQueue();
+
+	/**
+	 * @brief Enqueues an item at the end of the queue if there is room. Only the producer thread may call this.
+	 * @param item Item to queue.
+	 * @return True if the item was queued, false if the queue was full.
+	 */
+	bool tryEnqueue(const T& item);
+
+	/**
+	 * @brief Enqueues an item at the end of the queue by moving it, if there is room. Only the producer thread may call this.
+	 * @param item Item to queue.
+	 * @return True if the item was queued, false if the queue was full.
+	 */
+	bool tryEnqueue(T&& item);
+
+	/**
+	 * @brief Dequeues the item at the front of the queue if there is one. Only the consumer thread may call this.
+	 * @param item Set to the dequeued item.
+	 * @return True if an item was dequeued, false if the queue was empty.
+	 */
+	bool tryDequeue(T& item);
+
+	/**
+	 * @brief Enqueues an item at the end of the queue. Only the producer thread may call this.
+	 * @param item Item to queue.
+	 */
+	void enQueue(const T& item);
+
+	/**
+	 * @brief Dequeues the item at the front of the queue. Only the consumer thread may call this.
+	 * @return The dequeued item.
+	 */
+	T deQueue();
+
+	/**
+	 * @brief Enqueues as many items as there is room for at the end of the queue. Only the producer thread may call this.
+	 * The items are copied in at most two contiguous runs, either side of the end of the storage,
+	 * and published to the consumer with a single store of the tail.
+	 * @param items Items to queue, in order.
+	 * @return The number of items queued, from the start of the given items.
+	 */
+	size_t enqueueBulk(std::span<const T> items);
+
+	/**
+	 * @brief Dequeues up to a given number of items from the front of the queue. Only the consumer thread may call this.
+	 * The items are moved out in at most two contiguous runs and handed back to the producer with a single store of the head.
+	 * @param out Buffer to write the dequeued items to, with room for at least maxCount items.
+	 * @param maxCount Most items to dequeue.
+	 * @return The number of items dequeued.
+	 */
+	size_t dequeueBulk(T* out, size_t maxCount);
+
+	/**
+	 * @brief Returns the current number of elements in the queue.
+	 * Called while the other thread is working, this is only a snapshot.
+	 * @return The number of elements in the queue.
+	 */
+	[[nodiscard]] size_t currentSize() const;
+
+	/**
+	 * @brief Checks if the queue is empty.
+	 * @return True if the queue is empty else false.
+	 */
+	[[nodiscard]] bool isEmpty() const;
+
+	/**
+	 * @brief Checks if the queue is full.
+	 * @return True if the queue is full else false.
+	 */
+	[[nodiscard]] bool isFull() const;
+};
+
+template <typename T, size_t size>
+SpscQueue<T, size>::~SpscQueue()
+{
+	const size_t tail = m_Tail.load(std::memory_order_acquire);
+
+	for (size_t head = m_Head.load(std::memory_order_relaxed); head != tail; ++head) {
+		slotAt(head)->~T();
+	}
+}
+
+template <typename T, size_t size>
+T* SpscQueue<T, size>::slotAt(size_t index)
+{
+	return std::launder(reinterpret_cast<T*>(m_Slots[index & (size - 1)].storage));
+}
+
+template <typename T, size_t size>
+template <typename U>
+bool SpscQueue<T, size>::push(U&& item)
+{
+	const size_t tail = m_Tail.load(std::memory_order_relaxed);
+
+	// only reload the consumer's head when the cached one says the queue is full
+	if (tail - m_CachedHead == size) {
+		m_CachedHead = m_Head.load(std::memory_order_acquire);
+		if (tail - m_CachedHead == size) return false;
+	}
+
+	new (slotAt(tail)) T(std::forward<U>(item));
+
+	// release publishes the element before the consumer can see the new tail
+	m_Tail.store(tail + 1, std::memory_order_release);
+	return true;
+}
+
+template <typename T, size_t size>
+bool SpscQueue<T, size>::tryEnqueue(const T& item)
+{
+	return push(item);
+}
+
+template <typename T, size_t size>
+bool SpscQueue<T, size>::tryEnqueue(T&& item)
+{
+	return push(std::move(item));
+}
+
+template <typename T, size_t size>
+bool SpscQueue<T, size>::tryDequeue(T& item)
+{
+	const size_t head = m_Head.load(std::memory_order_relaxed);
+
+	// only reload the producer's tail when the cached one says the queue is empty
+	if (head == m_CachedTail) {
+		m_CachedTail = m_Tail.load(std::memory_order_acquire);
+		if (head == m_CachedTail) return false;
+	}
+
+	T* element = slotAt(head);
+	item = std::move(*element);
+	element->~T();
+
+	// release hands the slot back to the producer only once the element has been moved out
+	m_Head.store(head + 1, std::memory_order_release);
+	return true;
+}
+
+template <typename T, size_t size>
+void SpscQueue<T, size>::enQueue(const T& item)
+{
+	if (!tryEnqueue(item))
+		throw std::range_error("Cannot add item to a full queue.");
+}
+
+template <typename T, size_t size>
+T SpscQueue<T, size>::deQueue()
+{
+	T item;
+
+	if (!tryDequeue(item))
+		throw std::range_error("Cannot remove item from empty queue.");
+
+	return item;
+}
+
+template <typename T, size_t size>
+size_t SpscQueue<T, size>::enqueueBulk(std::span<const T> items)
+{
+	const size_t tail = m_Tail.load(std::memory_order_relaxed);
+
+	if (size - (tail - m_CachedHead) < items.size()) {
+		m_CachedHead = m_Head.load(std::memory_order_acquire);
+	}
+
+	const size_t count = std::min(items.size(), size - (tail - m_CachedHead));
+	if (count == 0) return 0;
+
+	// slots are laid out exactly like an array of T, so each run is one contiguous copy
+	const size_t beforeWrap = std::min(count, size - (tail & (size - 1)));
+
+	std::uninitialized_copy_n(items.data(), beforeWrap, slotAt(tail));
+	std::uninitialized_copy_n(items.data() + beforeWrap, count - beforeWrap, slotAt(0));
+
+	m_Tail.store(tail + count, std::memory_order_release);
+	return count;
+}
+
+template <typename T, size_t size>
+size_t SpscQueue<T, size>::dequeueBulk(T* out, size_t maxCount)
+{
+	const size_t head = m_Head.load(std::memory_order_relaxed);
+
+	if (m_CachedTail - head < maxCount) {
+		m_CachedTail = m_Tail.load(std::memory_order_acquire);
+	}
+
+	const size_t count = std::min(maxCount, m_CachedTail - head);
+	if (count == 0) return 0;
+
+	const size_t beforeWrap = std::min(count, size - (head & (size - 1)));
+
+	std::move(slotAt(head), slotAt(head) + beforeWrap, out);
+	std::destroy_n(slotAt(head), beforeWrap);
+	std::move(slotAt(0), slotAt(0) + (count - beforeWrap), out + beforeWrap);
+	std::destroy_n(slotAt(0), count - beforeWrap);
+
+	m_Head.store(head + count, std::memory_order_release);
+	return count;
+}
+
+template <typename T, size_t size>
+size_t SpscQueue<T, size>::currentSize() const
+{
+	// head first, so the tail read after it can never be behind it
+	const size_t head = m_Head.load(std::memory_order_acquire);
+	return m_Tail.load(std::memory_order_acquire) - head;
+}
+
+template <typename T, size_t size>
+bool SpscQueue<T, size>::isEmpty() const
+{
+	return currentSize() == 0;
+}
+
+template <typename T, size_t size>
+bool SpscQueue<T, size>::isFull() const
+{
+	return currentSize() == MAX_SIZE;
+}
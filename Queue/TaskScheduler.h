@@ -0,0 +1,412 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include "Futex.h"
+#include "UnboundedQueue.h"
+#include "WorkStealingDeque.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define TASK_SCHEDULER_PAUSE() _mm_pause()
+#else
+	#define TASK_SCHEDULER_PAUSE() ((void)0)
+#endif
+
+/**
+ * @brief A fork-join thread pool where every worker has its own work stealing deque.
+ * Work enters with run, and inside it join runs two functions, possibly in parallel: the second is pushed onto the
+ * worker's deque for another worker to steal while the first runs, and is popped back and run inline if nobody did.
+ * A worker with an empty deque steals the oldest task of a randomly chosen victim, so workers spread out over the
+ * deques rather than all contending for one. A worker which is waiting for a stolen task helps with other tasks
+ * until it is done. Workers which find nothing to do spin briefly and then park on a futex, and pushing a task only
+ * pays for a wake up when a worker is parked.
+ * Tasks live in the stack frames of run and join, so no task allocates.
+ */
+class TaskScheduler
+{
+public:
+	/**
+	 * @brief Times an idle worker looks for work before parking.
+	 */
+	static constexpr size_t SEARCHES_BEFORE_PARKING = 64;
+
+private:
+	struct Task
+	{
+		void (*m_Execute)(Task* task);
+		// tasks from run wake the thread waiting outside the pool when they finish
+		bool m_Root = false;
+		std::atomic<bool> m_Done = false;
+		std::exception_ptr m_Error;
+	};
+
+	template <typename Function>
+	struct FunctionTask : Task
+	{
+		Function& m_Function;
+
+		explicit FunctionTask(Function& function);
+		static void execute(Task* task);
+	};
+
+	struct alignas(64) Worker
+	{
+		TaskScheduler* m_Scheduler = nullptr;
+		size_t m_Index = 0;
+		uint64_t m_Random = 0;
+		WorkStealingDeque<Task*> m_Deque;
+	};
+
+	size_t m_WorkerCount;
+	std::unique_ptr<Worker[]> m_Workers;
+	std::unique_ptr<std::thread[]> m_Threads;
+
+	// tasks from run, waiting for any worker to take them
+	std::mutex m_InjectedMutex;
+	UnboundedQueue<Task*> m_Injected;
+	std::atomic<size_t> m_InjectedCount = 0;
+
+	// the word idle workers park on, changed whenever a parked worker should look for work again
+	alignas(64) std::atomic<uint32_t> m_Signal = 0;
+	std::atomic<uint32_t> m_Sleepers = 0;
+	std::atomic<bool> m_Stopping = false;
+
+	// the word threads in run park on, changed whenever a task from run finishes
+	alignas(64) std::atomic<uint32_t> m_RootsDone = 0;
+
+	static inline thread_local Worker* s_CurrentWorker = nullptr;
+
+	[[nodiscard]] Worker* currentWorker();
+
+	void workerLoop(Worker& worker);
+	void notify();
+	void park();
+	[[nodiscard]] bool hasWork();
+
+	bool findTask(Worker& worker, Task*& task);
+	bool takeInjected(Task*& task);
+	bool steal(Worker& worker, Task*& task);
+	void execute(Task* task);
+	void waitFor(Worker& worker, Task& task);
+
+	static void pause(size_t& spins);
+
+public:
+	/**
+	 * @brief Starts a pool of workers.
+	 * @param workerCount Number of worker threads, at least one.
+	 */
+	explicit TaskScheduler(size_t workerCount = std::max(1u, std::thread::hardware_concurrency()));
+
+	TaskScheduler(const TaskScheduler& other) = delete;
+	TaskScheduler& operator=(const TaskScheduler& other) = delete;
+
+	/**
+	 * @brief Stops and joins every worker. No run may still be waiting.
+	 */
+	~TaskScheduler();
+
+	/**
+	 * @brief Runs a function on the pool and waits for it to finish, rethrowing anything it throws.
+	 * Called from one of the pool's own workers the function simply runs inline.
+	 * @param function Function to run, which can use join to split its work.
+	 */
+	template <typename Function>
+	void run(Function&& function);
+
+	/**
+	 * @brief Runs two functions, the second possibly on another worker, and returns once both have finished.
+	 * If either throws, the exception is rethrown once both have finished. Outside the pool's workers the two
+	 * functions run one after the other on the calling thread.
+	 * @param first Function run by the calling worker.
+	 * @param second Function offered to other workers to steal.
+	 */
+	template <typename First, typename Second>
+	void join(First&& first, Second&& second);
+
+	/**
+	 * @brief Returns the number of worker threads.
+	 * @return The number of workers.
+	 */
+	[[nodiscard]] size_t workerCount() const;
+};
+
+template <typename Function>
+TaskScheduler::FunctionTask<Function>::FunctionTask(Function& function) :
+	m_Function(function)
+{
+	this->m_Execute = &FunctionTask<Function>::execute;
+}
+
+template <typename Function>
+void TaskScheduler::FunctionTask<Function>::execute(Task* task)
+{
+	auto* self = static_cast<FunctionTask<Function>*>(task);
+
+	try {
+		self->m_Function();
+	} catch (...) {
+		self->m_Error = std::current_exception();
+	}
+
+	// release, so whoever sees it done also sees everything the function wrote
+	self->m_Done.store(true, std::memory_order_release);
+}
+
+inline TaskScheduler::TaskScheduler(size_t workerCount) :
+	m_WorkerCount(std::max<size_t>(workerCount, 1)),
+	m_Workers(new Worker[m_WorkerCount]),
+	m_Threads(new std::thread[m_WorkerCount])
+{
+	for (size_t i = 0; i < m_WorkerCount; ++i) {
+		m_Workers[i].m_Scheduler = this;
+		m_Workers[i].m_Index = i;
+		// any odd seed keeps xorshift away from zero, and a different one per worker spreads their victims
+		m_Workers[i].m_Random = 0x9E3779B97F4A7C15ull * (2 * i + 1);
+	}
+
+	for (size_t i = 0; i < m_WorkerCount; ++i) {
+		m_Threads[i] = std::thread([this, i]() { workerLoop(m_Workers[i]); });
+	}
+}
+
+inline TaskScheduler::~TaskScheduler()
+{
+	m_Stopping.store(true, std::memory_order_seq_cst);
+	m_Signal.fetch_add(1, std::memory_order_seq_cst);
+	futexWakeAll(m_Signal);
+
+	for (size_t i = 0; i < m_WorkerCount; ++i) {
+		m_Threads[i].join();
+	}
+}
+
+inline TaskScheduler::Worker* TaskScheduler::currentWorker()
+{
+	Worker* worker = s_CurrentWorker;
+	return worker != nullptr && worker->m_Scheduler == this ? worker : nullptr;
+}
+
+inline void TaskScheduler::workerLoop(Worker& worker)
+{
+	// with a single hardware thread nothing can turn up while spinning
+	static const bool singleCore = std::thread::hardware_concurrency() <= 1;
+
+	s_CurrentWorker = &worker;
+	size_t searches = 0;
+
+	while (!m_Stopping.load(std::memory_order_acquire)) {
+		Task* task;
+
+		if (findTask(worker, task)) {
+			execute(task);
+			searches = 0;
+			continue;
+		}
+
+		if (!singleCore && ++searches < SEARCHES_BEFORE_PARKING) {
+			TASK_SCHEDULER_PAUSE();
+			continue;
+		}
+
+		park();
+		searches = 0;
+	}
+
+	s_CurrentWorker = nullptr;
+}
+
+inline void TaskScheduler::notify()
+{
+	// sequentially consistent with a worker announcing it will park, so either this sees the sleeper or it sees the task
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	if (m_Sleepers.load(std::memory_order_relaxed) != 0) {
+		m_Signal.fetch_add(1, std::memory_order_release);
+		futexWakeOne(m_Signal);
+	}
+}
+
+inline void TaskScheduler::park()
+{
+	// announce the sleep before the last look, so a push either sees the sleeper or happened before the look
+	m_Sleepers.fetch_add(1, std::memory_order_seq_cst);
+	const uint32_t signal = m_Signal.load(std::memory_order_seq_cst);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	if (!hasWork() && !m_Stopping.load(std::memory_order_seq_cst)) {
+		futexWait(m_Signal, signal);
+	}
+
+	m_Sleepers.fetch_sub(1, std::memory_order_relaxed);
+}
+
+inline bool TaskScheduler::hasWork()
+{
+	if (m_InjectedCount.load(std::memory_order_relaxed) != 0) return true;
+
+	for (size_t i = 0; i < m_WorkerCount; ++i) {
+		if (!m_Workers[i].m_Deque.isEmpty()) return true;
+	}
+
+	return false;
+}
+
+inline bool TaskScheduler::findTask(Worker& worker, Task*& task)
+{
+	return worker.m_Deque.pop(task) || takeInjected(task) || steal(worker, task);
+}
+
+inline bool TaskScheduler::takeInjected(Task*& task)
+{
+	// skip the lock when there is plainly nothing to take
+	if (m_InjectedCount.load(std::memory_order_relaxed) == 0) return false;
+
+	std::lock_guard<std::mutex> lock(m_InjectedMutex);
+	if (m_Injected.isEmpty()) return false;
+
+	task = m_Injected.deQueue();
+	m_InjectedCount.fetch_sub(1, std::memory_order_relaxed);
+
+	return true;
+}
+
+inline bool TaskScheduler::steal(Worker& worker, Task*& task)
+{
+	if (m_WorkerCount == 1) return false;
+
+	// xorshift64, cheap and good enough to stop idle workers all picking the same victim
+	worker.m_Random ^= worker.m_Random << 13;
+	worker.m_Random ^= worker.m_Random >> 7;
+	worker.m_Random ^= worker.m_Random << 17;
+
+	const size_t first = worker.m_Random % m_WorkerCount;
+
+	for (size_t i = 0; i < m_WorkerCount; ++i) {
+		const size_t victim = (first + i) % m_WorkerCount;
+
+		if (victim != worker.m_Index && m_Workers[victim].m_Deque.steal(task)) return true;
+	}
+
+	return false;
+}
+
+inline void TaskScheduler::execute(Task* task)
+{
+	// read before running, a finished task's frame may be gone the moment it is marked done
+	const bool root = task->m_Root;
+
+	task->m_Execute(task);
+
+	if (root) {
+		m_RootsDone.fetch_add(1, std::memory_order_release);
+		futexWakeAll(m_RootsDone);
+	}
+}
+
+inline void TaskScheduler::waitFor(Worker& worker, Task& task)
+{
+	size_t spins = 0;
+
+	while (!task.m_Done.load(std::memory_order_acquire)) {
+		Task* other;
+
+		// help with other work rather than sit idle while the thief finishes
+		if (findTask(worker, other)) {
+			execute(other);
+		} else {
+			pause(spins);
+		}
+	}
+}
+
+inline void TaskScheduler::pause(size_t& spins)
+{
+	constexpr size_t SPINS_BEFORE_YIELD = 64;
+	static const bool singleCore = std::thread::hardware_concurrency() <= 1;
+
+	if (singleCore || ++spins % SPINS_BEFORE_YIELD == 0) {
+		std::this_thread::yield();
+	} else {
+		TASK_SCHEDULER_PAUSE();
+	}
+}
+
+template <typename Function>
+void TaskScheduler::run(Function&& function)
+{
+	if (currentWorker() != nullptr) {
+		function();
+		return;
+	}
+
+	FunctionTask<std::remove_reference_t<Function>> task(function);
+	task.m_Root = true;
+
+	{
+		std::lock_guard<std::mutex> lock(m_InjectedMutex);
+		m_Injected.enQueue(&task);
+		m_InjectedCount.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	notify();
+
+	for (;;) {
+		const uint32_t finished = m_RootsDone.load(std::memory_order_acquire);
+		if (task.m_Done.load(std::memory_order_acquire)) break;
+
+		futexWait(m_RootsDone, finished);
+	}
+
+	if (task.m_Error) std::rethrow_exception(task.m_Error);
+}
+
+template <typename First, typename Second>
+void TaskScheduler::join(First&& first, Second&& second)
+{
+	Worker* worker = currentWorker();
+
+	if (worker == nullptr) {
+		first();
+		second();
+		return;
+	}
+
+	FunctionTask<std::remove_reference_t<Second>> task(second);
+	worker->m_Deque.push(&task);
+	notify();
+
+	std::exception_ptr error;
+
+	try {
+		first();
+	} catch (...) {
+		error = std::current_exception();
+	}
+
+	// everything first pushed has been joined, so the task is at the bottom unless it was stolen
+	Task* popped;
+
+	if (worker->m_Deque.pop(popped)) {
+		execute(popped);
+	} else {
+		waitFor(*worker, task);
+	}
+
+	if (error) std::rethrow_exception(error);
+	if (task.m_Error) std::rethrow_exception(task.m_Error);
+}
+
+inline size_t TaskScheduler::workerCount() const
+{
+	return m_WorkerCount;
+}
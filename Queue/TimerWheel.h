@@ -0,0 +1,403 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+
+#include "../DynamicArray/DynamicArray.h"
+#include "../DynamicArray/SlotMap.h"
+
+/**
+ * @brief A queue of delayed items, each released once the time it was scheduled for has passed.
+ * Time is counted in ticks of a fixed resolution from when the wheel was constructed. The wheel is a hierarchy of
+ * levels of 64 slots, where a slot of level L covers 64^L ticks, and each item sits in the slot of the lowest level
+ * which can tell its tick apart from the current one. Each slot is an intrusive list threaded through the item
+ * nodes, so scheduling and cancelling are O(1) and never move other items. As time passes a higher slot is emptied
+ * down into the levels below it the moment time reaches its range, and an item is released from level 0 at its tick.
+ * A bit mask of the occupied slots of each level lets advance jump straight over empty slots, so advancing a long way
+ * costs the slots which hold items rather than the ticks that passed.
+ * Items further off than the levels can hold wait on an overflow list until the top level comes round again.
+ * @tparam T Datatype of the items.
+ * @tparam Clock Clock the deadlines are measured by.
+ */
+template <typename T, typename Clock = std::chrono::steady_clock>
+class TimerWheel
+{
+public:
+	using TimePoint = typename Clock::time_point;
+	using Duration = typename Clock::duration;
+
+	/**
+	 * @brief Number of bits of the tick each level covers, so a level has 64 slots, one bit each in its mask.
+	 */
+	static constexpr size_t SLOT_BITS = 6;
+	static constexpr size_t SLOT_COUNT = size_t(1) << SLOT_BITS;
+
+	/**
+	 * @brief Number of levels, covering 2^36 ticks, so a little over two years at a 1ms tick.
+	 */
+	static constexpr size_t LEVEL_COUNT = 6;
+
+private:
+	static constexpr uint32_t NO_NODE = UINT32_MAX;
+	// the list of a node which is free, and the list of items beyond the top level
+	static constexpr uint32_t NO_LIST = UINT32_MAX;
+	static constexpr uint32_t OVERFLOW_LIST = LEVEL_COUNT * SLOT_COUNT;
+
+	struct Node
+	{
+		T item;
+		uint64_t expiry;
+		// neighbours in the node's list while scheduled, next is the next free node while free
+		uint32_t prev;
+		uint32_t next;
+		uint32_t list;
+		uint32_t generation;
+	};
+
+	DynamicArray<Node> m_Nodes;
+	uint32_t m_FreeHead = NO_NODE;
+
+	uint32_t m_Heads[OVERFLOW_LIST + 1];
+	uint64_t m_Occupied[LEVEL_COUNT] = {};
+
+	TimePoint m_Start;
+	Duration m_Tick;
+	// every item due at or before this tick has been released
+	uint64_t m_Now = 0;
+	size_t m_CurrentSize = 0;
+
+	[[nodiscard]] uint64_t ticksUntil(TimePoint time, bool roundUp) const;
+	[[nodiscard]] bool isLive(const SlotHandle& handle) const;
+
+	uint32_t acquireNode();
+	void releaseNode(uint32_t index);
+
+	void link(uint32_t index, uint32_t list);
+	void unlink(uint32_t index);
+	void insert(uint32_t index);
+
+public:
+	/**
+	 * @brief Constructs an empty wheel.
+	 * @param tick Resolution of the wheel, deadlines are rounded up to a whole tick.
+	 * @param start Time to count ticks from, no item is released before it.
+	 */
+	explicit TimerWheel(Duration tick, TimePoint start = Clock::now());
+
+	/**
+	 * @brief Schedules an item to be released once a deadline has passed.
+	 * A deadline which has already passed is released by the next advance which moves on a tick.
+	 * @param item Item to release.
+	 * @param deadline Time after which the item is released.
+	 * @return Handle to cancel the item with, valid until it is released or cancelled.
+	 */
+	SlotHandle schedule(T item, TimePoint deadline);
+
+	/**
+	 * @brief Schedules an item to be released once a delay has passed since the wheel's current time.
+	 * @param item Item to release.
+	 * @param delay Time from now after which the item is released.
+	 * @return Handle to cancel the item with, valid until it is released or cancelled.
+	 */
+	SlotHandle scheduleAfter(T item, Duration delay);
+
+	/**
+	 * @brief Cancels a scheduled item, so it is never released.
+	 * @param handle Handle of the item.
+	 * @return True if the item was cancelled, false if it had already been released or cancelled.
+	 */
+	bool cancel(const SlotHandle& handle);
+
+	/**
+	 * @brief Returns whether a handle refers to an item which is still scheduled.
+	 * @param handle Handle to check.
+	 * @return If the item is scheduled.
+	 */
+	[[nodiscard]] bool contains(const SlotHandle& handle) const;
+
+	/**
+	 * @brief Moves the wheel's time forward, releasing every item whose deadline is at or before it.
+	 * Items are released in order of their tick. Moving time backwards does nothing.
+	 * @param now The new current time.
+	 * @param expired Array the released items are appended to, so a caller can reuse one without allocating.
+	 * @return The number of items released.
+	 */
+	size_t advance(TimePoint now, DynamicArray<T>& expired);
+
+	/**
+	 * @brief Moves the wheel's time forward, releasing every item whose deadline is at or before it.
+	 * @param now The new current time.
+	 * @return The released items, in order of their tick.
+	 */
+	DynamicArray<T> advance(TimePoint now);
+
+	/**
+	 * @brief Returns the wheel's current time, the last time advanced to rounded down to a tick.
+	 * @return The current time.
+	 */
+	[[nodiscard]] TimePoint currentTime() const;
+
+	/**
+	 * @brief Reserves space for a number of scheduled items, so scheduling up to it does not reallocate.
+	 * @param count Number of items to reserve space for.
+	 */
+	void reserve(size_t count);
+
+	/**
+	 * @brief Returns the current number of scheduled items.
+	 * @return The number of scheduled items.
+	 */
+	[[nodiscard]] size_t currentSize() const;
+
+	/**
+	 * @brief Checks if no items are scheduled.
+	 * @return True if the wheel is empty else false.
+	 */
+	[[nodiscard]] bool isEmpty() const;
+};
+
+template <typename T, typename Clock>
+TimerWheel<T, Clock>::TimerWheel(Duration tick, TimePoint start) :
+	m_Start(start),
+	m_Tick(tick)
+{
+	if (tick <= Duration::zero())
+		throw std::range_error("Timer wheel tick must be positive.");
+
+	std::fill(std::begin(m_Heads), std::end(m_Heads), NO_NODE);
+}
+
+template <typename T, typename Clock>
+uint64_t TimerWheel<T, Clock>::ticksUntil(TimePoint time, bool roundUp) const
+{
+	if (time <= m_Start) return 0;
+
+	// subtracted unsigned so even TimePoint::max() from a negative start cannot overflow
+	const uint64_t elapsed = static_cast<uint64_t>(time.time_since_epoch().count()) - static_cast<uint64_t>(m_Start.time_since_epoch().count());
+	const uint64_t tick = static_cast<uint64_t>(m_Tick.count());
+
+	// divide before rounding up, adding tick - 1 first would overflow for far deadlines
+	const uint64_t ticks = elapsed / tick;
+	return roundUp && elapsed % tick != 0 ? ticks + 1 : ticks;
+}
+
+template <typename T, typename Clock>
+bool TimerWheel<T, Clock>::isLive(const SlotHandle& handle) const
+{
+	return handle.index < m_Nodes.len() && m_Nodes[handle.index].generation == handle.generation;
+}
+
+template <typename T, typename Clock>
+uint32_t TimerWheel<T, Clock>::acquireNode()
+{
+	if (m_FreeHead == NO_NODE) {
+		// generations start at 1, so a default constructed handle is never live
+		m_Nodes.append(Node{ T(), 0, NO_NODE, NO_NODE, NO_LIST, 1 });
+		return static_cast<uint32_t>(m_Nodes.len() - 1);
+	}
+
+	const uint32_t index = m_FreeHead;
+	m_FreeHead = m_Nodes[index].next;
+
+	return index;
+}
+
+template <typename T, typename Clock>
+void TimerWheel<T, Clock>::releaseNode(uint32_t index)
+{
+	Node& node = m_Nodes[index];
+
+	// bumping the generation makes every handle to the item stale, skipping 0 when it wraps
+	if (++node.generation == 0) node.generation = 1;
+	node.list = NO_LIST;
+	node.next = m_FreeHead;
+	m_FreeHead = index;
+
+	--m_CurrentSize;
+}
+
+template <typename T, typename Clock>
+void TimerWheel<T, Clock>::link(uint32_t index, uint32_t list)
+{
+	Node* nodes = m_Nodes.data();
+	const uint32_t head = m_Heads[list];
+
+	nodes[index].list = list;
+	nodes[index].prev = NO_NODE;
+	nodes[index].next = head;
+	if (head != NO_NODE) nodes[head].prev = index;
+	m_Heads[list] = index;
+
+	if (list != OVERFLOW_LIST) {
+		m_Occupied[list / SLOT_COUNT] |= uint64_t(1) << (list % SLOT_COUNT);
+	}
+}
+
+template <typename T, typename Clock>
+void TimerWheel<T, Clock>::unlink(uint32_t index)
+{
+	Node* nodes = m_Nodes.data();
+	const Node& node = nodes[index];
+
+	if (node.prev != NO_NODE) nodes[node.prev].next = node.next;
+	else m_Heads[node.list] = node.next;
+
+	if (node.next != NO_NODE) nodes[node.next].prev = node.prev;
+
+	if (m_Heads[node.list] == NO_NODE && node.list != OVERFLOW_LIST) {
+		m_Occupied[node.list / SLOT_COUNT] &= ~(uint64_t(1) << (node.list % SLOT_COUNT));
+	}
+}
+
+template <typename T, typename Clock>
+void TimerWheel<T, Clock>::insert(uint32_t index)
+{
+	const uint64_t expiry = m_Nodes[index].expiry;
+
+	// the highest bit where the expiry differs from now picks the level, and the expiry's digit there the slot,
+	// so the slot is always ahead of now's digit and is reached before anything in the level above
+	const size_t level = (std::bit_width(expiry ^ m_Now) - 1) / SLOT_BITS;
+
+	if (level >= LEVEL_COUNT) {
+		link(index, OVERFLOW_LIST);
+		return;
+	}
+
+	const size_t slot = (expiry >> (level * SLOT_BITS)) & (SLOT_COUNT - 1);
+	link(index, static_cast<uint32_t>(level * SLOT_COUNT + slot));
+}
+
+template <typename T, typename Clock>
+SlotHandle TimerWheel<T, Clock>::schedule(T item, TimePoint deadline)
+{
+	const uint32_t index = acquireNode();
+	Node& node = m_Nodes[index];
+
+	node.item = std::move(item);
+	// a deadline which has passed goes in the next tick, as the current one has already been released
+	node.expiry = std::max(ticksUntil(deadline, true), m_Now + 1);
+
+	insert(index);
+	++m_CurrentSize;
+
+	return { index, node.generation };
+}
+
+template <typename T, typename Clock>
+SlotHandle TimerWheel<T, Clock>::scheduleAfter(T item, Duration delay)
+{
+	return schedule(std::move(item), currentTime() + delay);
+}
+
+template <typename T, typename Clock>
+bool TimerWheel<T, Clock>::cancel(const SlotHandle& handle)
+{
+	if (!isLive(handle)) return false;
+
+	unlink(handle.index);
+	releaseNode(handle.index);
+
+	return true;
+}
+
+template <typename T, typename Clock>
+bool TimerWheel<T, Clock>::contains(const SlotHandle& handle) const
+{
+	return isLive(handle);
+}
+
+template <typename T, typename Clock>
+size_t TimerWheel<T, Clock>::advance(TimePoint now, DynamicArray<T>& expired)
+{
+	const uint64_t target = ticksUntil(now, false);
+	size_t released = 0;
+
+	while (m_Now < target) {
+		// the lowest occupied level holds the next event, a tick to release at level 0 or a slot to empty above it
+		size_t level = 0;
+		while (level < LEVEL_COUNT && m_Occupied[level] == 0) {
+			++level;
+		}
+
+		uint64_t next;
+		uint32_t list;
+
+		if (level < LEVEL_COUNT) {
+			const size_t slot = std::countr_zero(m_Occupied[level]);
+			const size_t above = (level + 1) * SLOT_BITS;
+
+			next = (m_Now >> above << above) | (uint64_t(slot) << (level * SLOT_BITS));
+			list = static_cast<uint32_t>(level * SLOT_COUNT + slot);
+		} else if (m_Heads[OVERFLOW_LIST] != NO_NODE) {
+			constexpr size_t TOP = LEVEL_COUNT * SLOT_BITS;
+
+			next = ((m_Now >> TOP) + 1) << TOP;
+			list = OVERFLOW_LIST;
+		} else {
+			break;
+		}
+
+		if (next > target) break;
+
+		m_Now = next;
+
+		uint32_t index = m_Heads[list];
+		m_Heads[list] = NO_NODE;
+		if (list != OVERFLOW_LIST) m_Occupied[level] &= ~(uint64_t(1) << (list % SLOT_COUNT));
+
+		while (index != NO_NODE) {
+			const uint32_t following = m_Nodes[index].next;
+
+			if (m_Nodes[index].expiry <= m_Now) {
+				expired.append(std::move(m_Nodes[index].item));
+				releaseNode(index);
+				++released;
+			} else {
+				insert(index);
+			}
+
+			index = following;
+		}
+	}
+
+	m_Now = std::max(m_Now, target);
+
+	return released;
+}
+
+template <typename T, typename Clock>
+DynamicArray<T> TimerWheel<T, Clock>::advance(TimePoint now)
+{
+	DynamicArray<T> expired;
+	advance(now, expired);
+
+	return expired;
+}
+
+template <typename T, typename Clock>
+typename TimerWheel<T, Clock>::TimePoint TimerWheel<T, Clock>::currentTime() const
+{
+	return m_Start + m_Tick * static_cast<typename Duration::rep>(m_Now);
+}
+
+template <typename T, typename Clock>
+void TimerWheel<T, Clock>::reserve(size_t count)
+{
+	m_Nodes.reserve(count);
+}
+
+template <typename T, typename Clock>
+size_t TimerWheel<T, Clock>::currentSize() const
+{
+	return m_CurrentSize;
+}
+
+template <typename T, typename Clock>
+bool TimerWheel<T, Clock>::isEmpty() const
+{
+	return m_CurrentSize == 0;
+}
@@ -0,0 +1,437 @@
+#pragma once
+
+#include <algorithm>
+#include <initializer_list>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+/**
+ * @brief A queue with no maximum size, stored as a linked list of fixed size segments.
+ * The queue grows by linking a new segment at the rear and shrinks by unlinking the emptied one at the front,
+ * so elements are never copied or moved once queued, and memory follows how many elements are queued rather than
+ * the most there have ever been. Emptied segments are kept on a short free list to be reused, so a queue which
+ * stays around the same depth stops allocating.
+ * @tparam T Datatype of queue.
+ */
+template <typename T>
+class UnboundedQueue
+{
+public:
+	/**
+	 * @brief Number of elements in each segment, enough to fill about a page.
+	 */
+	static constexpr size_t SEGMENT_SIZE = std::max<size_t>(8, 4096 / sizeof(T));
+
+	/**
+	 * @brief Most emptied segments kept for reuse, further emptied segments are freed.
+	 */
+	static constexpr size_t MAX_FREE_SEGMENTS = 4;
+
+private:
+	// raw storage so slots are only constructed while they hold an element
+	struct Slot
+	{
+		alignas(T) unsigned char storage[sizeof(T)];
+	};
+
+	struct Segment
+	{
+		Segment* next = nullptr;
+		Slot slots[SEGMENT_SIZE];
+	};
+
+	// elements run from m_FrontIndex in the front segment to m_RearIndex in the rear segment
+	Segment* m_Front = nullptr;
+	Segment* m_Rear = nullptr;
+	size_t m_FrontIndex = 0, m_RearIndex = 0, m_CurrentSize = 0;
+
+	Segment* m_FreeList = nullptr;
+	size_t m_FreeCount = 0, m_SegmentCount = 0;
+
+	[[nodiscard]] static T* slotAt(Segment* segment, size_t index);
+
+	Segment* acquireSegment();
+	void releaseSegment(Segment* segment);
+
+	template <typename U>
+	void push(U&& item);
+
+public:
+	/**
+	 * @brief Constructs an empty queue.
+	 */
+	UnboundedQueue() = default;
+
+	/**
+	 * @brief Constructs a queue with given elements.
+	 * @param elements Initializer list of elements.
+	 */
+	UnboundedQueue(const std::initializer_list<T>& elements);
+
+	/**
+	 * @brief Copy a queue into another queue.
+	 * @param other The queue to copy from.
+	 */
+	UnboundedQueue(const UnboundedQueue<T>& other);
+
+	/**
+	 * @brief Copy a queue into another queue.
+	 * @param other The queue to copy from.
+	 * @returns A copy of the given queue.
+	 */
+	UnboundedQueue<T>& operator=(const UnboundedQueue<T>& other);
+
+	/**
+	 * @brief Move a queue into another queue.
+	 * @param other The queue to move from.
+	 */
+	UnboundedQueue(UnboundedQueue<T>&& other) noexcept;
+
+	/**
+	 * @brief Move a queue into another queue.
+	 */
+	UnboundedQueue<T>& operator=(UnboundedQueue<T>&& other) noexcept;
+
+	~UnboundedQueue();
+
+	/**
+	 * @brief Enqueues an item at the end of the queue.
+	 * @param item Item to queue.
+	 */
+	void enQueue(const T& item);
+
+	/**
+	 * @brief Enqueues an item at the end of the queue by moving it.
+	 * @param item Item to queue.
+	 */
+	void enQueue(T&& item);
+
+	/**
+	 * @brief Dequeues the item at the front of the queue.
+	 * @return The dequeued item.
+	 */
+	T deQueue();
+
+	/**
+	 * @brief Returns a reference to the item at the front of the queue.
+	 * @return Reference to the front item.
+	 */
+	[[nodiscard]] T& front();
+
+	/**
+	 * @brief Returns the current number of elements in the queue.
+	 * @return The number of elements in the queue.
+	 */
+	[[nodiscard]] size_t currentSize() const;
+
+	/**
+	 * @brief Checks if the queue is empty.
+	 * @return True if the queue is empty else false.
+	 */
+	[[nodiscard]] bool isEmpty() const;
+
+	/**
+	 * @brief Returns the number of elements the allocated segments can hold, including those on the free list.
+	 * @return Number of elements the queue has memory for.
+	 */
+	[[nodiscard]] size_t capacity() const;
+
+	/**
+	 * @brief Dequeue and destroy every element, keeping at most the free list's worth of segments.
+	 */
+	void clear();
+
+	/**
+	 * @brief Free every segment on the free list.
+	 */
+	void shrinkToFit();
+
+	template<typename U>
+	friend std::ostream& operator<<(std::ostream& os, const UnboundedQueue<U>& queue);
+};
+
+template <typename T>
+UnboundedQueue<T>::UnboundedQueue(const std::initializer_list<T>& elements)
+{
+	try {
+		for (const T& element : elements) {
+			enQueue(element);
+		}
+	} catch (...) {
+		// the destructor does not run for a constructor that throws, so free what was already queued
+		clear();
+		shrinkToFit();
+		delete m_Front;
+		throw;
+	}
+}
+
+template <typename T>
+UnboundedQueue<T>::UnboundedQueue(const UnboundedQueue<T>& other)
+{
+	size_t index = other.m_FrontIndex;
+
+	try {
+		for (Segment* segment = other.m_Front; segment != nullptr; segment = segment->next, index = 0) {
+			const size_t end = segment == other.m_Rear ? other.m_RearIndex : SEGMENT_SIZE;
+
+			for (; index < end; ++index) {
+				enQueue(*slotAt(segment, index));
+			}
+		}
+	} catch (...) {
+		// the destructor does not run for a constructor that throws, so free the elements and segments copied so far
+		clear();
+		shrinkToFit();
+		delete m_Front;
+		throw;
+	}
+}
+
+template <typename T>
+UnboundedQueue<T>& UnboundedQueue<T>::operator=(const UnboundedQueue<T>& other)
+{
+	if (this == &other) return *this;
+
+	UnboundedQueue<T> copy(other);
+	return *this = std::move(copy);
+}
+
+template <typename T>
+UnboundedQueue<T>::UnboundedQueue(UnboundedQueue<T>&& other) noexcept :
+	m_Front(other.m_Front), m_Rear(other.m_Rear), m_FrontIndex(other.m_FrontIndex), m_RearIndex(other.m_RearIndex),
+	m_CurrentSize(other.m_CurrentSize), m_FreeList(other.m_FreeList), m_FreeCount(other.m_FreeCount), m_SegmentCount(other.m_SegmentCount)
+{
+	other.m_Front = other.m_Rear = other.m_FreeList = nullptr;
+	other.m_FrontIndex = other.m_RearIndex = other.m_CurrentSize = other.m_FreeCount = other.m_SegmentCount = 0;
+}
+
+template <typename T>
+UnboundedQueue<T>& UnboundedQueue<T>::operator=(UnboundedQueue<T>&& other) noexcept
+{
+	if (this == &other) return *this;
+
+	clear();
+	shrinkToFit();
+
+	// clear keeps the last emptied segment linked in as the front, ready for reuse
+	delete m_Front;
+
+	m_Front = other.m_Front;
+	m_Rear = other.m_Rear;
+	m_FrontIndex = other.m_FrontIndex;
+	m_RearIndex = other.m_RearIndex;
+	m_CurrentSize = other.m_CurrentSize;
+	m_FreeList = other.m_FreeList;
+	m_FreeCount = other.m_FreeCount;
+	m_SegmentCount = other.m_SegmentCount;
+
+	other.m_Front = other.m_Rear = other.m_FreeList = nullptr;
+	other.m_FrontIndex = other.m_RearIndex = other.m_CurrentSize = other.m_FreeCount = other.m_SegmentCount = 0;
+
+	return *this;
+}
+
+template <typename T>
+UnboundedQueue<T>::~UnboundedQueue()
+{
+	clear();
+	shrinkToFit();
+
+	delete m_Front;
+}
+
+template <typename T>
+T* UnboundedQueue<T>::slotAt(Segment* segment, size_t index)
+{
+	return std::launder(reinterpret_cast<T*>(segment->slots[index].storage));
+}
+
+template <typename T>
+typename UnboundedQueue<T>::Segment* UnboundedQueue<T>::acquireSegment()
+{
+	if (m_FreeList == nullptr) {
+		++m_SegmentCount;
+		return new Segment;
+	}
+
+	Segment* segment = m_FreeList;
+	m_FreeList = segment->next;
+	--m_FreeCount;
+
+	segment->next = nullptr;
+	return segment;
+}
+
+template <typename T>
+void UnboundedQueue<T>::releaseSegment(Segment* segment)
+{
+	if (m_FreeCount == MAX_FREE_SEGMENTS) {
+		--m_SegmentCount;
+		delete segment;
+		return;
+	}
+
+	segment->next = m_FreeList;
+	m_FreeList = segment;
+	++m_FreeCount;
+}
+
+template <typename T>
+template <typename U>
+void UnboundedQueue<T>::push(U&& item)
+{
+	if (m_Rear != nullptr && m_RearIndex != SEGMENT_SIZE) {
+		new (slotAt(m_Rear, m_RearIndex)) T(std::forward<U>(item));
+
+		++m_RearIndex;
+		++m_CurrentSize;
+		return;
+	}
+
+	// link a fresh segment rather than growing, so queued elements stay where they are,
+	// but only once the element is built in it, so a throwing constructor leaves the queue as it was
+	Segment* segment = acquireSegment();
+
+	try {
+		new (slotAt(segment, 0)) T(std::forward<U>(item));
+	} catch (...) {
+		releaseSegment(segment);
+		throw;
+	}
+
+	if (m_Rear == nullptr) {
+		m_Front = segment;
+		m_FrontIndex = 0;
+	} else {
+		m_Rear->next = segment;
+	}
+
+	m_Rear = segment;
+	m_RearIndex = 1;
+	++m_CurrentSize;
+}
+
+template <typename T>
+void UnboundedQueue<T>::enQueue(const T& item)
+{
+	push(item);
+}
+
+template <typename T>
+void UnboundedQueue<T>::enQueue(T&& item)
+{
+	push(std::move(item));
+}
+
+template <typename T>
+T UnboundedQueue<T>::deQueue()
+{
+	if (isEmpty())
+		throw std::range_error("Cannot remove item from empty queue.");
+
+	T* element = slotAt(m_Front, m_FrontIndex);
+	T value = std::move(*element);
+
+	element->~T();
+	++m_FrontIndex;
+	--m_CurrentSize;
+
+	if (m_CurrentSize == 0) {
+		// the last element was in the rear segment, so start again at its top instead of cycling through the free list
+		m_FrontIndex = m_RearIndex = 0;
+	} else if (m_FrontIndex == SEGMENT_SIZE) {
+		Segment* emptied = m_Front;
+
+		m_Front = m_Front->next;
+		m_FrontIndex = 0;
+
+		releaseSegment(emptied);
+	}
+
+	return value;
+}
+
+template <typename T>
+T& UnboundedQueue<T>::front()
+{
+	if (isEmpty())
+		throw std::range_error("Cannot get front of empty queue.");
+
+	return *slotAt(m_Front, m_FrontIndex);
+}
+
+template <typename T>
+size_t UnboundedQueue<T>::currentSize() const
+{
+	return m_CurrentSize;
+}
+
+template <typename T>
+bool UnboundedQueue<T>::isEmpty() const
+{
+	return m_CurrentSize == 0;
+}
+
+template <typename T>
+size_t UnboundedQueue<T>::capacity() const
+{
+	return m_SegmentCount * SEGMENT_SIZE;
+}
+
+template <typename T>
+void UnboundedQueue<T>::clear()
+{
+	while (!isEmpty()) {
+		slotAt(m_Front, m_FrontIndex)->~T();
+		++m_FrontIndex;
+		--m_CurrentSize;
+
+		if (m_FrontIndex == SEGMENT_SIZE && m_CurrentSize != 0) {
+			Segment* emptied = m_Front;
+
+			m_Front = m_Front->next;
+			m_FrontIndex = 0;
+
+			releaseSegment(emptied);
+		}
+	}
+
+	if (m_Front != nullptr) {
+		m_FrontIndex = m_RearIndex = 0;
+		m_Rear = m_Front;
+	}
+}
+
+template <typename T>
+void UnboundedQueue<T>::shrinkToFit()
+{
+	while (m_FreeList != nullptr) {
+		Segment* segment = m_FreeList;
+		m_FreeList = segment->next;
+
+		delete segment;
+		--m_SegmentCount;
+	}
+
+	m_FreeCount = 0;
+}
+
+template<typename T>
+std::ostream& operator<<(std::ostream& os, const UnboundedQueue<T>& queue) {
+	os << "UnboundedQueue = [";
+
+	size_t index = queue.m_FrontIndex, printed = 0;
+
+	for (auto* segment = queue.m_Front; printed < queue.m_CurrentSize; segment = segment->next, index = 0) {
+		const size_t end = segment == queue.m_Rear ? queue.m_RearIndex : UnboundedQueue<T>::SEGMENT_SIZE;
+
+		for (; index < end; ++index, ++printed) {
+			os << *UnboundedQueue<T>::slotAt(segment, index) << (printed + 1 < queue.m_CurrentSize ? ", " : "");
+		}
+	}
+
+	return os << "]";
+}
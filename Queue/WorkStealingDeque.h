@@ -0,0 +1,189 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+/**
+ * @brief A Chase-Lev work stealing deque: one owner thread pushes and pops at the bottom, any thread steals from the
+ * top. The owner works on its newest items, which are still warm in its cache, while thieves take the oldest, which in
+ * fork-join code are the largest pieces of work left. The owner only synchronises with thieves when they race for the
+ * last item, so pushes and pops cost a store and a fence rather than a lock.
+ * Items live in a circular array which the owner replaces with one twice the size when it fills. A thief may still be
+ * reading the old array, so replaced arrays are only freed with the deque, which at most doubles its memory.
+ * @tparam T Datatype of the items, trivially copyable since thieves may read a slot while the owner rewrites it,
+ * usually a pointer to a task.
+ */
+template <typename T>
+class WorkStealingDeque
+{
+	static_assert(std::is_trivially_copyable_v<T>, "Work stealing deque items must be trivially copyable.");
+
+private:
+	struct Buffer
+	{
+		size_t mask;
+		std::unique_ptr<std::atomic<T>[]> slots;
+		// the array this one replaced, kept alive for thieves which loaded it before the swap
+		std::unique_ptr<Buffer> previous;
+
+		explicit Buffer(size_t capacity) : mask(capacity - 1), slots(new std::atomic<T>[capacity]) {}
+
+		T load(int64_t index) const { return slots[size_t(index) & mask].load(std::memory_order_relaxed); }
+		void store(int64_t index, T item) { slots[size_t(index) & mask].store(item, std::memory_order_relaxed); }
+	};
+
+	// signed, as the owner's pop moves bottom below top for a moment when the deque is empty
+	alignas(64) std::atomic<int64_t> m_Top = 0;
+	alignas(64) std::atomic<int64_t> m_Bottom = 0;
+	std::atomic<Buffer*> m_Buffer;
+	// owns the current array, and through it every array it replaced
+	std::unique_ptr<Buffer> m_Storage;
+
+	Buffer* grow(Buffer* buffer, int64_t top, int64_t bottom);
+
+public:
+	/**
+	 * @brief Constructs an empty deque.
+	 * @param capacity Number of items held before the array first grows, rounded up to a power of two.
+	 */
+	explicit WorkStealingDeque(size_t capacity = 64);
+
+	WorkStealingDeque(const WorkStealingDeque<T>& other) = delete;
+	WorkStealingDeque<T>& operator=(const WorkStealingDeque<T>& other) = delete;
+
+	/**
+	 * @brief Pushes an item at the bottom. Only the owner thread may call this.
+	 * @param item Item to push.
+	 */
+	void push(T item);
+
+	/**
+	 * @brief Pops the newest item from the bottom. Only the owner thread may call this.
+	 * @param item Set to the popped item.
+	 * @return True if an item was popped, false if the deque was empty or a thief took the last item.
+	 */
+	bool pop(T& item);
+
+	/**
+	 * @brief Steals the oldest item from the top. Any thread may call this.
+	 * @param item Set to the stolen item.
+	 * @return True if an item was stolen, false if the deque was empty or another thread took the item first,
+	 * either way the caller usually moves on to another deque.
+	 */
+	bool steal(T& item);
+
+	/**
+	 * @brief Returns the current number of items in the deque.
+	 * Called while other threads are working, this is only a snapshot.
+	 * @return The number of items in the deque.
+	 */
+	[[nodiscard]] size_t currentSize() const;
+
+	/**
+	 * @brief Checks if the deque is empty.
+	 * @return True if the deque is empty else false.
+	 */
+	[[nodiscard]] bool isEmpty() const;
+};
+
+template <typename T>
+WorkStealingDeque<T>::WorkStealingDeque(size_t capacity) :
+	m_Storage(std::make_unique<Buffer>(std::bit_ceil(std::max<size_t>(capacity, 2))))
+{
+	m_Buffer.store(m_Storage.get(), std::memory_order_relaxed);
+}
+
+template <typename T>
+typename WorkStealingDeque<T>::Buffer* WorkStealingDeque<T>::grow(Buffer* buffer, int64_t top, int64_t bottom)
+{
+	auto bigger = std::make_unique<Buffer>(2 * (buffer->mask + 1));
+
+	for (int64_t i = top; i < bottom; ++i) {
+		bigger->store(i, buffer->load(i));
+	}
+
+	bigger->previous = std::move(m_Storage);
+	m_Storage = std::move(bigger);
+
+	// release, so a thief which loads the new array also sees the items copied into it
+	m_Buffer.store(m_Storage.get(), std::memory_order_release);
+
+	return m_Storage.get();
+}
+
+template <typename T>
+void WorkStealingDeque<T>::push(T item)
+{
+	const int64_t bottom = m_Bottom.load(std::memory_order_relaxed);
+	const int64_t top = m_Top.load(std::memory_order_acquire);
+	Buffer* buffer = m_Buffer.load(std::memory_order_relaxed);
+
+	if (bottom - top > int64_t(buffer->mask)) {
+		buffer = grow(buffer, top, bottom);
+	}
+
+	buffer->store(bottom, item);
+
+	// release, the item must be visible before the bottom that lets thieves reach it
+	m_Bottom.store(bottom + 1, std::memory_order_release);
+}
+
+template <typename T>
+bool WorkStealingDeque<T>::pop(T& item)
+{
+	const int64_t bottom = m_Bottom.load(std::memory_order_relaxed) - 1;
+	Buffer* buffer = m_Buffer.load(std::memory_order_relaxed);
+
+	// claim the bottom item before looking at top, a thief which has not yet read bottom will now see it taken
+	m_Bottom.store(bottom, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t top = m_Top.load(std::memory_order_relaxed);
+
+	if (top > bottom) {
+		m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+		return false;
+	}
+
+	item = buffer->load(bottom);
+	if (top < bottom) return true;
+
+	// the last item, which a thief may be taking at the same time, so race it for top
+	const bool won = m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+	m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+
+	return won;
+}
+
+template <typename T>
+bool WorkStealingDeque<T>::steal(T& item)
+{
+	int64_t top = m_Top.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	const int64_t bottom = m_Bottom.load(std::memory_order_acquire);
+
+	if (top >= bottom) return false;
+
+	// read the item before claiming it, once top moves on the owner may overwrite the slot
+	item = m_Buffer.load(std::memory_order_acquire)->load(top);
+
+	return m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+}
+
+template <typename T>
+size_t WorkStealingDeque<T>::currentSize() const
+{
+	const int64_t bottom = m_Bottom.load(std::memory_order_acquire);
+	const int64_t top = m_Top.load(std::memory_order_acquire);
+
+	return bottom > top ? size_t(bottom - top) : 0;
+}
+
+template <typename T>
+bool WorkStealingDeque<T>::isEmpty() const
+{
+	return currentSize() == 0;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../DynamicArrayBenchmark/Benchmark.h"
+#include "../Queue/BlockingQueue.h"
+#include "../Queue/MpmcQueue.h"
+#include "Threads.h"
+
+/**
+ * @brief Measure the one way latency of handing a single item to a thread waiting in a blocking pop.
+ * One item bounces between two threads through a pair of queues, so every hand over finds the other thread waiting,
+ * either still spinning or parked in the kernel.
+ * @tparam QueueType Queue to bounce the item through, default constructible.
+ * @param report Report to add the results to.
+ * @param counters Hardware counters to read, these only count the calling thread.
+ * @param cores Cores to pin the two threads to.
+ * @param container Name of the queue in the report.
+ * @param send Pushes an item to a queue, waiting if it must.
+ * @param receive Pops an item from a queue, waiting until there is one.
+ */
+template <typename QueueType, typename Send, typename Receive>
+void benchmarkWakeup(BenchmarkReport& report, PerfCounters& counters, const std::vector<size_t>& cores, const std::string& container, Send send, Receive receive)
+{
+	constexpr size_t ROUND_TRIPS = 1 << 14;
+
+	volatile uint64_t sink = 0;
+
+	const auto noAllocations = []() { return size_t(0); };
+
+	// a hand over is one item crossing one queue, so each round trip is two of them
+	BenchmarkResult result = measure(counters, 2 * ROUND_TRIPS, noAllocations, []() { return std::make_unique<std::array<QueueType, 2>>(); }, [&](std::unique_ptr<std::array<QueueType, 2>>& queues) {
+		QueueType& ping = (*queues)[0];
+		QueueType& pong = (*queues)[1];
+
+		std::thread echo([&]() {
+			pinCurrentThread(cores, 1);
+
+			for (size_t i = 0; i < ROUND_TRIPS; ++i) {
+				send(pong, receive(ping) + 1);
+			}
+		});
+
+		uint64_t value = 0;
+
+		for (size_t i = 0; i < ROUND_TRIPS; ++i) {
+			send(ping, value);
+			value = receive(pong);
+		}
+
+		echo.join();
+		sink = value;
+	});
+
+	result.suite = "blocking";
+	result.container = container;
+	result.type = "uint64_t";
+	result.operation = "wakeup_latency";
+	report.add(result);
+}
+
+/**
+ * @brief Compare the wake up latency of the blocking queue against the blocking operations of the lock-free queue.
+ * @param report Report to add the results to.
+ * @param counters Hardware counters to read.
+ * @param cores Cores to pin the two threads to.
+ */
+inline void benchmarkBlocking(BenchmarkReport& report, PerfCounters& counters, const std::vector<size_t>& cores)
+{
+	constexpr size_t CAPACITY = 1024;
+
+	using Blocking = BlockingQueue<uint64_t>;
+	using LockFree = MpmcQueue<uint64_t, CAPACITY>;
+
+	pinCurrentThread(cores, 0);
+
+	benchmarkWakeup<Blocking>(report, counters, cores, "BlockingQueue",
+		[](Blocking& queue, uint64_t item) { queue.push(item); },
+		[](Blocking& queue) { uint64_t item = 0; queue.pop(item); return item; });
+
+	benchmarkWakeup<LockFree>(report, counters, cores, "MpmcQueue blocking",
+		[](LockFree& queue, uint64_t item) { queue.enqueue(item); },
+		[](LockFree& queue) { return queue.dequeue(); });
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../DynamicArrayBenchmark/Benchmark.h"
+#include "../Queue/MpmcQueue.h"
+#include "../Queue/SpscQueue.h"
+#include "LockedQueue.h"
+#include "Threads.h"
+
+/**
+ * @brief Measure one producer streaming items to one consumer in bursts through the bulk operations.
+ * @tparam QueueType Queue with enqueueBulk and dequeueBulk, default constructible.
+ * @param report Report to add the results to.
+ * @param counters Hardware counters to read, these only count the consumer thread.
+ * @param cores Cores to pin the consumer and producer to, in that order.
+ * @param container Name of the queue in the report.
+ * @param capacity Capacity of the queue, reported as the size.
+ */
+template <typename QueueType>
+void benchmarkBurstHandoff(BenchmarkReport& report, PerfCounters& counters, const std::vector<size_t>& cores, const std::string& container, size_t capacity)
+{
+	constexpr size_t ITEM_COUNT = 1 << 20;
+
+	volatile uint64_t sink = 0;
+
+	const auto noAllocations = []() { return size_t(0); };
+
+	for (const size_t burst : { size_t(1), size_t(32), size_t(256) }) {
+		BenchmarkResult result = measure(counters, ITEM_COUNT, noAllocations, []() { return std::make_unique<QueueType>(); }, [&](std::unique_ptr<QueueType>& queue) {
+			std::thread producer([&]() {
+				pinCurrentThread(cores, 1);
+
+				std::vector<uint64_t> items(burst);
+				size_t spins = 0;
+
+				for (uint64_t sent = 0; sent < ITEM_COUNT;) {
+					const size_t count = std::min<size_t>(burst, ITEM_COUNT - sent);
+
+					for (size_t i = 0; i < count; ++i) {
+						items[i] = sent + i;
+					}
+
+					// a burst may only partly fit, the rest goes in the next call
+					for (size_t queued = 0; queued < count;) {
+						const size_t added = queue->enqueueBulk(std::span<const uint64_t>(items.data() + queued, count - queued));
+						queued += added;
+
+						if (added == 0) spinPause(spins);
+					}
+
+					sent += count;
+				}
+			});
+
+			std::vector<uint64_t> items(burst);
+			uint64_t sum = 0;
+			size_t spins = 0;
+
+			for (size_t received = 0; received < ITEM_COUNT;) {
+				const size_t count = queue->dequeueBulk(items.data(), burst);
+
+				for (size_t i = 0; i < count; ++i) {
+					sum += items[i];
+				}
+				received += count;
+
+				if (count == 0) spinPause(spins);
+			}
+
+			producer.join();
+			sink = sum;
+		});
+
+		result.suite = "bulk";
+		result.container = container;
+		result.type = "uint64_t";
+		result.operation = "throughput_burst_" + std::to_string(burst);
+		result.size = capacity;
+		report.add(result);
+	}
+}
+
+/**
+ * @brief Compare moving items in bursts of 1, 32 and 256 through every bounded queue, with one producer and one consumer.
+ * @param report Report to add the results to.
+ * @param counters Hardware counters to read.
+ * @param cores Cores to pin the two threads to.
+ */
+inline void benchmarkBulk(BenchmarkReport& report, PerfCounters& counters, const std::vector<size_t>& cores)
+{
+	constexpr size_t CAPACITY = 1024;
+
+	pinCurrentThread(cores, 0);
+
+	benchmarkBurstHandoff<SpscQueue<uint64_t, CAPACITY>>(report, counters, cores, "SpscQueue", CAPACITY);
+	benchmarkBurstHandoff<MpmcQueue<uint64_t, CAPACITY>>(report, counters, cores, "MpmcQueue", CAPACITY);
+	benchmarkBurstHandoff<LockedQueue<uint64_t, CAPACITY>>(report, counters, cores, "Queue+mutex", CAPACITY);
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../DynamicArrayBenchmark/Benchmark.h"
+#include "../Queue/ByteRingQueue.h"
+#include "../Queue/SpscQueue.h"
+#include "Threads.h"
+
+/**
+ * @brief Stand-ins for writing a log record and reading one back, touching every byte as a real encoder would.
+ */
+struct LogRecord
+{
+	static constexpr size_t MIN_LENGTH = 16;
+	static constexpr size_t MAX_LENGTH = 4096;
+
+	static void serialize(std::byte* into, size_t length, uint64_t sequence)
+	{
+		std::memcpy(into, &sequence, sizeof(sequence));
+		std::memset(into + sizeof(sequence), int(sequence & 0xff), length - sizeof(sequence));
+	}
+
+	static uint64_t checksum(std::span<const std::byte> record)
+	{
+		uint64_t sum = 0;
+
+		for (size_t i = 0; i + sizeof(uint64_t) <= record.size(); i += sizeof(uint64_t)) {
+			uint64_t word;
+			std::memcpy(&word, record.data() + i, sizeof(word));
+			sum += word;
+		}
+
+		return sum;
+	}
+};
+
+/**
+ * @brief Compare streaming variable length records through the byte ring, written and read in place, against the
+ * serialize, copy, enqueue, copy cycle of a queue of byte vectors. Records run from 16 bytes to 4 KB.
+ * @param report Report to add the results to.
+ * @param counters Hardware counters to read, these only count the consumer thread.
+ * @param cores Cores to pin the consumer and producer to, in that order.
+ */
+inline void benchmarkByteRing(BenchmarkReport& report, PerfCounters& counters, const std::vector<size_t>& cores)
+{
+	constexpr size_t RECORD_COUNT = 1 << 16;
+	constexpr size_t RING_SIZE = 1 << 21;
+	constexpr size_t QUEUE_SIZE = 1024;
+
+	using Ring = ByteRingQueue<RING_SIZE>;
+	using Records = SpscQueue<std::vector<std::byte>, QUEUE_SIZE>;
+
+	pinCurrentThread(cores, 0);
+
+	std::vector<size_t> lengths(RECORD_COUNT);
+	std::mt19937_64 random(RECORD_COUNT);
+	std::uniform_int_distribution<size_t> length(LogRecord::MIN_LENGTH, LogRecord::MAX_LENGTH);
+	for (size_t& item : lengths) {
+		item = length(random);
+	}
+
+	volatile uint64_t sink = 0;
+
+	const auto noAllocations = []() { return size_t(0); };
+
+	const auto record = [&](const std::string& container, size_t size, BenchmarkResult result) {
+		result.suite = "bytering";
+		result.container = container;
+		result.type = "bytes";
+		result.operation = "throughput";
+		result.size = size;
+		report.add(result);
+	};
+
+	record("ByteRingQueue", RING_SIZE, measure(counters, RECORD_COUNT, noAllocations, []() { return std::make_unique<Ring>(); }, [&](std::unique_ptr<Ring>& ring) {
+		std::thread producer([&]() {
+			pinCurrentThread(cores, 1);
+
+			size_t spins = 0;
+			for (size_t i = 0; i < RECORD_COUNT; ++i) {
+				std::span<std::byte> reserved;
+				while ((reserved = ring->reserve(lengths[i])).empty()) spinPause(spins);
+
+				LogRecord::serialize(reserved.data(), reserved.size(), i);
+				ring->commit();
+			}
+		});
+
+		uint64_t sum = 0;
+		size_t spins = 0;
+
+		for (size_t i = 0; i < RECORD_COUNT; ++i) {
+			std::span<const std::byte> peeked;
+			while ((peeked = ring->peek()).empty()) spinPause(spins);
+
+			sum += LogRecord::checksum(peeked);
+			ring->release();
+		}
+
+		producer.join();
+		sink = sum;
+	}));
+
+	// each record is serialized to a scratch buffer, copied into a vector to queue, and copied out again to read
+	record("SpscQueue<vector>", QUEUE_SIZE, measure(counters, RECORD_COUNT, noAllocations, []() { return std::make_unique<Records>(); }, [&](std::unique_ptr<Records>& queue) {
+		std::thread producer([&]() {
+			pinCurrentThread(cores, 1);
+
+			std::vector<std::byte> scratch(LogRecord::MAX_LENGTH);
+			size_t spins = 0;
+
+			for (size_t i = 0; i < RECORD_COUNT; ++i) {
+				LogRecord::serialize(scratch.data(), lengths[i], i);
+
+				std::vector<std::byte> item(scratch.begin(), scratch.begin() + lengths[i]);
+				while (!queue->tryEnqueue(std::move(item))) spinPause(spins);
+			}
+		});
+
+		std::vector<std::byte> scratch(LogRecord::MAX_LENGTH);
+		uint64_t sum = 0;
+		size_t spins = 0;
+
+		for (size_t i = 0; i < RECORD_COUNT; ++i) {
+			std::vector<std::byte> item;
+			while (!queue->tryDequeue(item)) spinPause(spins);
+
+			std::memcpy(scratch.data(), item.data(), item.size());
+			sum += LogRecord::checksum(std::span<const std::byte>(scratch.data(), item.size()));
+		}
+
+		producer.join();
+		sink = sum;
+	}));
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../DynamicArrayBenchmark/Benchmark.h"
+#include "../Queue/AsyncChannel.h"
+#include "../Queue/BlockingQueue.h"
+#include "Threads.h"
+
+/**
+ * @brief Three coroutine stages joined by two channels, all run by one executor on the calling thread.
+ */
+template <size_t capacity>
+struct ChannelPipeline
+{
+	ManualExecutor executor;
+	AsyncChannel<uint64_t, capacity> doubling{ executor };
+	AsyncChannel<uint64_t, capacity> summing{ executor };
+	uint64_t sum = 0;
+
+	static DetachedTask source(ChannelPipeline& pipeline, size_t itemCount)
+	{
+		for (uint64_t i = 0; i < itemCount; ++i) {
+			co_await pipeline.doubling.send(i);
+		}
+		pipeline.doubling.close();
+	}
+
+	static DetachedTask doubler(ChannelPipeline& pipeline)
+	{
+		while (const auto item = co_await pipeline.doubling.receive()) {
+			co_await pipeline.summing.send(*item * 2);
+		}
+		pipeline.summing.close();
+	}
+
+	static DetachedTask sink(ChannelPipeline& pipeline)
+	{
+		while (const auto item = co_await pipeline.summing.receive()) {
+			pipeline.sum += *item;
+		}
+	}
+};
+
+/**
+ * @brief Measure items passing through a three stage pipeline, built from coroutines and channels on one thread
+ * against a thread per stage joined by blocking queues.
+ * @param report Report to add the results to.
+ * @param counters Hardware counters to read, these only count the calling thread.
+ * @param cores Cores to pin the threads to.
+ */
+inline void benchmarkChannel(BenchmarkReport& report, PerfCounters& counters, const std::vector<size_t>& cores)
+{
+	constexpr size_t CAPACITY = 64;
+	constexpr size_t ITEM_COUNT = 1 << 18;
+
+	using Pipeline = ChannelPipeline<CAPACITY>;
+
+	volatile uint64_t sink = 0;
+
+	const auto noAllocations = []() { return size_t(0); };
+
+	const auto record = [&](const std::string& container, BenchmarkResult result) {
+		result.suite = "channel";
+		result.container = container;
+		result.type = "uint64_t";
+		result.operation = "pipeline_3_stages";
+		result.size = CAPACITY;
+		report.add(result);
+	};
+
+	pinCurrentThread(cores, 0);
+
+	record("AsyncChannel", measure(counters, ITEM_COUNT, noAllocations, []() { return std::make_unique<Pipeline>(); }, [&](std::unique_ptr<Pipeline>& pipeline) {
+		// the sink and doubler start first and suspend on their empty channels, then the source drives everything
+		Pipeline::sink(*pipeline);
+		Pipeline::doubler(*pipeline);
+		Pipeline::source(*pipeline, ITEM_COUNT);
+
+		pipeline->executor.run();
+		sink = pipeline->sum;
+	}));
+
+	record("BlockingQueue threads", measure(counters, ITEM_COUNT, noAllocations, []() { return std::make_unique<std::array<BlockingQueue<uint64_t>, 2>>(); }, [&](std::unique_ptr<std::array<BlockingQueue<uint64_t>, 2>>& queues) {
+		BlockingQueue<uint64_t>& doubling = (*queues)[0];
+		BlockingQueue<uint64_t>& summing = (*queues)[1];
+
+		std::thread source([&]() {
+			pinCurrentThread(cores, 1);
+
+			for (uint64_t i = 0; i < ITEM_COUNT; ++i) {
+				doubling.push(i);
+			}
+			doubling.close();
+		});
+
+		std::thread doubler([&]() {
+			pinCurrentThread(cores, 2);
+
+			uint64_t item;
+			while (doubling.pop(item)) {
+				summing.push(item * 2);
+			}
+			summing.close();
+		});
+
+		uint64_t sum = 0, item;
+		while (summing.pop(item)) {
+			sum += item;
+		}
+
+		source.join();
+		doubler.join();
+		sink = sum;
+	}));
+}
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "../DynamicArrayBenchmark/Benchmark.h"
+#include "../Queue/IpcQueue.h"
+#include "Threads.h"
+
+#ifdef IPC_QUEUE_SUPPORTED
+
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+/**
+ * @brief Two IpcQueues in shared memory, one each way between a parent and a child process.
+ * The memory is created before the fork and each process attaches its ends after it.
+ */
+class SharedMemoryLink
+{
+private:
+	using Ring = IpcQueue<1 << 16>;
+
+	int m_Files[2];
+	std::optional<Ring> m_Outbound, m_Inbound;
+
+public:
+	SharedMemoryLink()
+	{
+		for (int i = 0; i < 2; ++i) {
+			// unlinked at once, the descriptor is all the two processes need
+			const std::string name = "/queue-benchmark-" + std::to_string(getpid()) + "-" + std::to_string(i);
+
+			m_Files[i] = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+			if (m_Files[i] < 0) throw std::system_error(errno, std::generic_category(), "shm_open");
+
+			Ring::remove(name);
+		}
+	}
+
+	~SharedMemoryLink()
+	{
+		m_Outbound.reset();
+		m_Inbound.reset();
+		close(m_Files[0]);
+		close(m_Files[1]);
+	}
+
+	void attach(bool parent)
+	{
+		m_Outbound.emplace(m_Files[parent ? 0 : 1], IpcRole::Producer);
+		m_Inbound.emplace(m_Files[parent ? 1 : 0], IpcRole::Consumer);
+	}
+
+	void send(std::span<const std::byte> message) { m_Outbound->send(message); }
+
+	void receive(std::span<std::byte> message)
+	{
+		m_Inbound->receive([&](std::span<const std::byte> received) { std::memcpy(message.data(), received.data(), received.size()); });
+	}
+};
+
+/**
+ * @brief A unix domain socket pair between a parent and a child process, which copies each message into the kernel and
+ * out again. Sequenced packets keep the message boundaries, as the queue does.
+ */
+class SocketLink
+{
+private:
+	int m_Sockets[2];
+	int m_Own = -1;
+
+public:
+	SocketLink()
+	{
+		if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, m_Sockets) != 0) throw std::system_error(errno, std::generic_category(), "socketpair");
+	}
+
+	~SocketLink()
+	{
+		close(m_Sockets[0]);
+		close(m_Sockets[1]);
+	}
+
+	void attach(bool parent) { m_Own = m_Sockets[parent ? 0 : 1]; }
+
+	void send(std::span<const std::byte> message) { ::send(m_Own, message.data(), message.size(), 0); }
+
+	void receive(std::span<std::byte> message) { recv(m_Own, message.data(), message.size(), 0); }
+};
+
+/**
+ * @brief Measure the one way latency of a message between two processes.
+ * One message bounces between a parent and a forked child, so every hand over finds the other process waiting.
+ * @tparam Link Two way link with attach, send and receive, created before the fork.
+ * @param report Report to add the results to.
+ * @param counters Hardware counters to read, these only count the parent.
+ * @param cores Cores to pin the two processes to.
+ * @param container Name of the link in the report.
+ * @param messageSize Number of bytes in the message.
+ */
+template <typename Link>
+void benchmarkRoundTrip(BenchmarkReport& report, PerfCounters& counters, const std::vector<size_t>& cores, const std::string& container, size_t messageSize)
+{
+	constexpr size_t ROUND_TRIPS = 1 << 14;
+
+	const auto noAllocations = []() { return size_t(0); };
+
+	// a hand over is one message crossing one way, so each round trip is two of them
+	BenchmarkResult result = measure(counters, 2 * ROUND_TRIPS, noAllocations, []() { return std::make_unique<Link>(); }, [&](std::unique_ptr<Link>& link) {
+		std::vector<std::byte> message(messageSize);
+
+		const pid_t echo = fork();
+		if (echo < 0) throw std::system_error(errno, std::generic_category(), "fork");
+
+		if (echo == 0) {
+			pinCurrentThread(cores, 1);
+			link->attach(false);
+
+			for (size_t i = 0; i < ROUND_TRIPS; ++i) {
+				link->receive(message);
+				message[0] = std::byte(uint8_t(message[0]) + 1);
+				link->send(message);
+			}
+
+			// skip the destructors, the parent still owns everything
+			_exit(0);
+		}
+
+		link->attach(true);
+
+		for (size_t i = 0; i < ROUND_TRIPS; ++i) {
+			link->send(message);
+			link->receive(message);
+		}
+
+		waitpid(echo, nullptr, 0);
+	});
+
+	result.suite = "ipc";
+	result.container = container;
+	result.type = "bytes";
+	result.operation = "one_way_latency";
+	result.size = messageSize;
+	report.add(result);
+}
+
+/**
+ * @brief Compare the one way latency of the shared memory queue against a unix domain socket, for small and larger
+ * messages.
+ * @param report Report to add the results to.
+ * @param counters Hardware counters to read.
+ * @param cores Cores to pin the two processes to.
+ */
+inline void benchmarkIpc(BenchmarkReport& report, PerfCounters& counters, const std::vector<size_t>& cores)
+{
+	pinCurrentThread(cores, 0);
+
+	for (size_t messageSize : { size_t(8), size_t(256), size_t(4096) }) {
+		benchmarkRoundTrip<SharedMemoryLink>(report, counters, cores, "IpcQueue", messageSize);
+		benchmarkRoundTrip<SocketLink>(report, counters, cores, "Unix socket", messageSize);
+	}
+}
+
+#else
+
+inline void benchmarkIpc(BenchmarkReport&, PerfCounters&, const std::vector<size_t>&) {}
+
+#endif
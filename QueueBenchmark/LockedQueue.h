@@ -0,0 +1,48 @@
+#pragma once
+
+#include <mutex>
+#include <span>
+
+#include "../Queue/Queue.h"
+
+/**
+ * @brief A Queue shared behind a mutex, the baseline the lock-free queues are measured against.
+ */
+template <typename T, size_t size>
+class LockedQueue
+{
+private:
+	Queue<T, size> m_Queue;
+	std::mutex m_Mutex;
+
+public:
+	bool tryEnqueue(const T& item)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		if (m_Queue.isFull()) return false;
+
+		m_Queue.enQueue(item);
+		return true;
+	}
+
+	bool tryDequeue(T& item)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		if (m_Queue.isEmpty()) return false;
+
+		item = m_Queue.deQueue();
+		return true;
+	}
+
+	size_t enqueueBulk(std::span<const T> items)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		return m_Queue.enqueueBulk(items);
+	}
+
+	size_t dequeueBulk(T* out, size_t maxCount)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		return m_Queue.dequeueBulk(out, maxCount);
+	}
+};
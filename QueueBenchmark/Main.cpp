@@ -0,0 +1,131 @@
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../DynamicArrayBenchmark/Benchmark.h"
+#include "BlockingBenchmarks.h"
+#include "BulkBenchmarks.h"
+#include "ByteRingBenchmarks.h"
+#include "ChannelBenchmarks.h"
+#include "IpcBenchmarks.h"
+#include "MaskedBenchmarks.h"
+#include "MpmcBenchmarks.h"
+#include "PriorityBenchmarks.h"
+#include "SchedulerBenchmarks.h"
+#include "SpscBenchmarks.h"
+#include "TimerBenchmarks.h"
+
+/**
+ * @brief Benchmark the concurrent queues against a Queue shared behind a mutex, masked against modulo indexing,
+ * the wake up latency of the blocking queues, a pipeline of coroutine channels against one of threads,
+ * d-ary heaps, the timer wheel against a heap of timers, the work stealing scheduler against one shared queue,
+ * the shared memory queue between processes against a unix socket, and variable length records written in place
+ * in the byte ring against copying them through a queue of vectors.
+ * Usage: QueueBenchmark [--suite spsc|mpmc|bulk|masked|blocking|channel|priority|timer|scheduler|ipc|bytering|all] [--max-threads N] [--max-heap N] [--max-timers N] [--cores 0,2,...] [--json FILE] [--csv FILE]
+ * Results are written as CSV to stdout unless a JSON or CSV file is given.
+ * Threads are pinned round robin to the given cores. Without --cores nothing is pinned.
+ * The mpmc suite doubles the thread count from 1 up to the max threads, which defaults to 64.
+ * The scheduler suite does the same with workers, but no further than the hardware threads.
+ * The priority suite goes up in powers of ten from 10^3 items to the max heap, which defaults to 10^6. 10^8 needs ~3 GB.
+ * The timer suite goes up the same way from 10^3 outstanding timers to the max timers, which defaults to 10^6.
+ * The ipc suite forks a second process, and only runs on POSIX systems.
+ */
+int main(int argc, char** argv)
+{
+	std::string suite = "spsc", jsonPath, csvPath;
+	size_t maxThreads = 64, maxHeap = 1'000'000, maxTimers = 1'000'000;
+	std::vector<size_t> cores;
+
+	for (int i = 1; i + 1 < argc; i += 2) {
+		const std::string option = argv[i], value = argv[i + 1];
+
+		if (option == "--suite") suite = value;
+		else if (option == "--max-threads") maxThreads = std::stoull(value);
+		else if (option == "--max-heap") maxHeap = std::stoull(value);
+		else if (option == "--max-timers") maxTimers = std::stoull(value);
+		else if (option == "--json") jsonPath = value;
+		else if (option == "--csv") csvPath = value;
+		else if (option == "--cores") {
+			std::stringstream list(value);
+			std::string core;
+
+			while (std::getline(list, core, ',')) {
+				cores.push_back(std::stoull(core));
+			}
+		} else {
+			std::cerr << "Unknown option " << option << std::endl;
+			return 1;
+		}
+	}
+
+	BenchmarkReport report;
+	PerfCounters counters;
+
+	if (counters.usesTimeStampCounter()) {
+		std::cerr << "Hardware counters are unavailable, cycles are time stamp counter reference cycles and the other counter columns will be empty." << std::endl;
+	} else if (!counters.total(HardwareCounter::Cycles)) {
+		std::cerr << "Hardware counters are unavailable, counter columns will be empty." << std::endl;
+	}
+
+	if (suite == "spsc" || suite == "all") {
+		benchmarkSpsc(report, counters, cores);
+	}
+
+	if (suite == "mpmc" || suite == "all") {
+		benchmarkMpmc(report, counters, maxThreads, cores);
+	}
+
+	if (suite == "bulk" || suite == "all") {
+		benchmarkBulk(report, counters, cores);
+	}
+
+	if (suite == "masked" || suite == "all") {
+		benchmarkMasked(report, counters);
+	}
+
+	if (suite == "blocking" || suite == "all") {
+		benchmarkBlocking(report, counters, cores);
+	}
+
+	if (suite == "channel" || suite == "all") {
+		benchmarkChannel(report, counters, cores);
+	}
+
+	if (suite == "priority" || suite == "all") {
+		benchmarkPriority(report, counters, maxHeap);
+	}
+
+	if (suite == "timer" || suite == "all") {
+		benchmarkTimer(report, counters, maxTimers);
+	}
+
+	if (suite == "scheduler" || suite == "all") {
+		benchmarkScheduler(report, counters, maxThreads);
+	}
+
+	if (suite == "ipc" || suite == "all") {
+		benchmarkIpc(report, counters, cores);
+	}
+
+	if (suite == "bytering" || suite == "all") {
+		benchmarkByteRing(report, counters, cores);
+	}
+
+	if (!jsonPath.empty()) {
+		std::ofstream json(jsonPath);
+		report.writeJson(json);
+	}
+
+	if (!csvPath.empty()) {
+		std::ofstream csv(csvPath);
+		report.writeCsv(csv);
+	}
+
+	if (jsonPath.empty() && csvPath.empty()) {
+		report.writeCsv(std::cout);
+	}
+
+	return 0;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "../DynamicArrayBenchmark/Benchmark.h"
+#include "../Queue/MaskedQueue.h"
+#include "../Queue/Queue.h"
+
+/**
+ * @brief Measure single threaded enqueues and dequeues on one queue type.
+ * Steady state keeps the queue half full and alternates an enqueue with a dequeue, so the cost is the index arithmetic.
+ * Fill and drain walks the whole storage once, so a large queue's cost is its page and TLB misses.
+ * @tparam QueueType Queue with enQueue and deQueue, default constructible.
+ * @param report Report to add the results to.
+ * @param counters Hardware counters to read, cycles per op is the figure to compare.
+ * @param container Name of the queue in the report.
+ * @param count Requested size of the queue.
+ */
+template <typename QueueType>
+void benchmarkQueueIndexing(BenchmarkReport& report, PerfCounters& counters, const std::string& container, size_t count)
+{
+	constexpr size_t PAIR_COUNT = 1 << 20;
+
+	volatile uint64_t sink = 0;
+
+	const auto noAllocations = []() { return size_t(0); };
+
+	const auto record = [&](const std::string& operation, BenchmarkResult result) {
+		result.suite = "masked";
+		result.container = container;
+		result.type = "uint64_t";
+		result.operation = operation;
+		result.size = count;
+		report.add(result);
+	};
+
+	const auto halfFull = [count]() {
+		auto queue = std::make_unique<QueueType>();
+
+		for (uint64_t i = 0; i < count / 2; ++i) {
+			queue->enQueue(i);
+		}
+
+		return queue;
+	};
+
+	record("enqueue_dequeue", measure(counters, 2 * PAIR_COUNT, noAllocations, halfFull, [&](std::unique_ptr<QueueType>& queue) {
+		uint64_t sum = 0;
+
+		for (uint64_t i = 0; i < PAIR_COUNT; ++i) {
+			queue->enQueue(i);
+			sum += queue->deQueue();
+		}
+
+		sink = sum;
+	}));
+
+	record("fill_drain", measure(counters, 2 * count, noAllocations, []() { return std::make_unique<QueueType>(); }, [&](std::unique_ptr<QueueType>& queue) {
+		uint64_t sum = 0;
+
+		for (uint64_t i = 0; i < count; ++i) {
+			queue->enQueue(i);
+		}
+
+		for (size_t i = 0; i < count; ++i) {
+			sum += queue->deQueue();
+		}
+
+		sink = sum;
+	}));
+}
+
+/**
+ * @brief Compare Queue's modulo indexing against a masked queue with its storage inline, on the heap and on huge pages,
+ * for a queue which fits in cache and one which spans many pages. Both sizes are deliberately not powers of two.
+ * @param report Report to add the results to.
+ * @param counters Hardware counters to read.
+ */
+inline void benchmarkMasked(BenchmarkReport& report, PerfCounters& counters)
+{
+	constexpr size_t SMALL = 1000;
+	constexpr size_t LARGE = 3'000'000;
+
+	benchmarkQueueIndexing<Queue<uint64_t, SMALL>>(report, counters, "Queue", SMALL);
+	benchmarkQueueIndexing<MaskedQueue<uint64_t, SMALL, QueueStorage::Inline>>(report, counters, "MaskedQueue inline", SMALL);
+	benchmarkQueueIndexing<MaskedQueue<uint64_t, SMALL, QueueStorage::Heap>>(report, counters, "MaskedQueue heap", SMALL);
+
+	benchmarkQueueIndexing<Queue<uint64_t, LARGE>>(report, counters, "Queue", LARGE);
+	benchmarkQueueIndexing<MaskedQueue<uint64_t, LARGE, QueueStorage::Heap>>(report, counters, "MaskedQueue heap", LARGE);
+	benchmarkQueueIndexing<MaskedQueue<uint64_t, LARGE, QueueStorage::HugePages>>(report, counters, "MaskedQueue huge pages", LARGE);
+}
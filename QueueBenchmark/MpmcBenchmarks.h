@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../DynamicArrayBenchmark/Benchmark.h"
+#include "../Queue/MpmcQueue.h"
+#include "LockedQueue.h"
+#include "Threads.h"
+
+/**
+ * @brief Move a fixed number of items through a queue shared by half the threads producing and half consuming.
+ * A single thread alternates between enqueueing and dequeueing.
+ * @tparam Blocking Use the blocking enqueue and dequeue instead of spinning on the try operations.
+ * @param queue Queue to move the items through.
+ * @param threadCount Number of producer and consumer threads in total.
+ * @param itemCount Number of items to move.
+ * @param cores Cores to pin the threads to.
+ * @returns Sum of every item dequeued.
+ */
+template <bool Blocking, typename QueueType>
+uint64_t transferItems(QueueType& queue, size_t threadCount, size_t itemCount, const std::vector<size_t>& cores)
+{
+	const auto enqueue = [&queue](uint64_t item, size_t& spins) {
+		if constexpr (Blocking) {
+			queue.enqueue(item);
+		} else {
+			while (!queue.tryEnqueue(item)) spinPause(spins);
+		}
+	};
+
+	const auto dequeue = [&queue](size_t& spins) {
+		if constexpr (Blocking) {
+			return queue.dequeue();
+		} else {
+			uint64_t item;
+			while (!queue.tryDequeue(item)) spinPause(spins);
+			return item;
+		}
+	};
+
+	if (threadCount == 1) {
+		uint64_t sum = 0;
+		size_t spins = 0;
+
+		for (uint64_t i = 0; i < itemCount; ++i) {
+			enqueue(i, spins);
+			sum += dequeue(spins);
+		}
+
+		return sum;
+	}
+
+	const size_t producerCount = threadCount / 2, consumerCount = threadCount - producerCount;
+
+	std::vector<std::thread> threads;
+	std::vector<uint64_t> sums(consumerCount);
+
+	for (size_t producer = 0; producer < producerCount; ++producer) {
+		threads.emplace_back([&, producer]() {
+			pinCurrentThread(cores, producer);
+
+			size_t spins = 0;
+			for (uint64_t i = itemCount * producer / producerCount; i < itemCount * (producer + 1) / producerCount; ++i) {
+				enqueue(i, spins);
+			}
+		});
+	}
+
+	for (size_t consumer = 0; consumer < consumerCount; ++consumer) {
+		threads.emplace_back([&, consumer]() {
+			pinCurrentThread(cores, producerCount + consumer);
+
+			uint64_t sum = 0;
+			size_t spins = 0;
+
+			for (size_t i = itemCount * consumer / consumerCount; i < itemCount * (consumer + 1) / consumerCount; ++i) {
+				sum += dequeue(spins);
+			}
+			sums[consumer] = sum;
+		});
+	}
+
+	for (auto& thread : threads) {
+		thread.join();
+	}
+
+	uint64_t sum = 0;
+	for (const uint64_t consumerSum : sums) {
+		sum += consumerSum;
+	}
+
+	return sum;
+}
+
+/**
+ * @brief Measure how throughput through one shared queue scales from one thread up to a maximum, doubling each time.
+ * The lock-free queue is measured spinning on its try operations and sleeping in its blocking ones,
+ * against a Queue behind a mutex.
+ * @param report Report to add the results to.
+ * @param counters Hardware counters to read, these only count the calling thread, which only works in the single thread runs.
+ * @param maxThreads Largest number of threads to measure.
+ * @param cores Cores to pin the threads to.
+ */
+inline void benchmarkMpmc(BenchmarkReport& report, PerfCounters& counters, size_t maxThreads, const std::vector<size_t>& cores)
+{
+	constexpr size_t CAPACITY = 1024;
+	constexpr size_t ITEM_COUNT = 1 << 20;
+
+	using LockFree = MpmcQueue<uint64_t, CAPACITY>;
+	using Locked = LockedQueue<uint64_t, CAPACITY>;
+
+	volatile uint64_t sink = 0;
+
+	const auto noAllocations = []() { return size_t(0); };
+
+	for (size_t threadCount = 1; threadCount <= maxThreads; threadCount *= 2) {
+		const auto record = [&](const std::string& container, BenchmarkResult result) {
+			result.suite = "mpmc";
+			result.container = container;
+			result.type = "uint64_t";
+			result.operation = "throughput_" + std::to_string(threadCount) + "_threads";
+			result.size = CAPACITY;
+			report.add(result);
+		};
+
+		record("MpmcQueue", measure(counters, ITEM_COUNT, noAllocations, []() { return std::make_unique<LockFree>(); }, [&](std::unique_ptr<LockFree>& queue) {
+			sink = transferItems<false>(*queue, threadCount, ITEM_COUNT, cores);
+		}));
+
+		record("MpmcQueue blocking", measure(counters, ITEM_COUNT, noAllocations, []() { return std::make_unique<LockFree>(); }, [&](std::unique_ptr<LockFree>& queue) {
+			sink = transferItems<true>(*queue, threadCount, ITEM_COUNT, cores);
+		}));
+
+		record("Queue+mutex", measure(counters, ITEM_COUNT, noAllocations, []() { return std::make_unique<Locked>(); }, [&](std::unique_ptr<Locked>& queue) {
+			sink = transferItems<false>(*queue, threadCount, ITEM_COUNT, cores);
+		}));
+	}
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "../DynamicArrayBenchmark/Benchmark.h"
+#include "../Queue/PriorityQueue.h"
+
+/**
+ * @brief std::priority_queue ordered smallest first, with the same operations as PriorityQueue, as a baseline.
+ */
+class StdPriorityQueue
+{
+private:
+	std::priority_queue<uint64_t, std::vector<uint64_t>, std::greater<uint64_t>> m_Queue;
+
+public:
+	void pushBulk(std::span<const uint64_t> items)
+	{
+		// construction from a range heapifies in O(n), like PriorityQueue's bulk push into an empty queue
+		m_Queue = decltype(m_Queue)(items.begin(), items.end());
+	}
+
+	void push(uint64_t item)
+	{
+		m_Queue.push(item);
+	}
+
+	uint64_t pop()
+	{
+		const uint64_t item = m_Queue.top();
+		m_Queue.pop();
+
+		return item;
+	}
+};
+
+/**
+ * @brief Measure building a heap from scratch, popping from it, and holding it at a steady size by popping the top
+ * and pushing a later item, the way a deadline scheduler does.
+ * @tparam QueueType Priority queue of uint64_t with pushBulk, push and pop, default constructible.
+ * @param report Report to add the results to.
+ * @param counters Hardware counters to read.
+ * @param container Name of the queue in the report.
+ * @param values Items to fill the heap with.
+ */
+template <typename QueueType>
+void benchmarkHeap(BenchmarkReport& report, PerfCounters& counters, const std::string& container, const std::vector<uint64_t>& values)
+{
+	const size_t count = values.size();
+	const size_t popCount = std::min<size_t>(count, 1 << 16);
+
+	volatile uint64_t sink = 0;
+
+	const auto noAllocations = []() { return size_t(0); };
+	const auto filled = [&]() {
+		auto queue = std::make_unique<QueueType>();
+		queue->pushBulk(values);
+
+		return queue;
+	};
+
+	const auto record = [&](const std::string& operation, BenchmarkResult result) {
+		result.suite = "priority";
+		result.container = container;
+		result.type = "uint64_t";
+		result.operation = operation;
+		result.size = count;
+		report.add(result);
+	};
+
+	record("heapify", measure(counters, count, noAllocations, []() { return std::make_unique<QueueType>(); }, [&](std::unique_ptr<QueueType>& queue) {
+		queue->pushBulk(values);
+	}));
+
+	record("pop", measure(counters, popCount, noAllocations, filled, [&](std::unique_ptr<QueueType>& queue) {
+		uint64_t sum = 0;
+
+		for (size_t i = 0; i < popCount; ++i) {
+			sum += queue->pop();
+		}
+		sink = sum;
+	}));
+
+	// each pushed item is a random distance later than the one popped, so it lands at a random depth like a rescheduled timer
+	record("pop_push", measure(counters, popCount, noAllocations, filled, [&](std::unique_ptr<QueueType>& queue) {
+		for (size_t i = 0; i < popCount; ++i) {
+			queue->push(queue->pop() + (values[i] >> 1));
+		}
+		sink = queue->pop();
+	}));
+}
+
+/**
+ * @brief Compare binary, 4-ary and 8-ary PriorityQueues, and std::priority_queue, from 10^3 items up to a maximum.
+ * @param report Report to add the results to.
+ * @param counters Hardware counters to read.
+ * @param maxSize Largest number of items, each size is ten times the last.
+ */
+inline void benchmarkPriority(BenchmarkReport& report, PerfCounters& counters, size_t maxSize)
+{
+	std::mt19937_64 random(maxSize);
+
+	for (size_t count = 1000; count <= maxSize; count *= 10) {
+		std::vector<uint64_t> values(count);
+
+		for (uint64_t& value : values) {
+			value = random();
+		}
+
+		benchmarkHeap<PriorityQueue<uint64_t, std::less<uint64_t>, 2>>(report, counters, "PriorityQueue 2-ary", values);
+		benchmarkHeap<PriorityQueue<uint64_t, std::less<uint64_t>, 4>>(report, counters, "PriorityQueue 4-ary", values);
+		benchmarkHeap<PriorityQueue<uint64_t, std::less<uint64_t>, 8>>(report, counters, "PriorityQueue 8-ary", values);
+		benchmarkHeap<StdPriorityQueue>(report, counters, "std::priority_queue", values);
+	}
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../DynamicArrayBenchmark/Benchmark.h"
+#include "../Queue/TaskScheduler.h"
+#include "SharedQueueScheduler.h"
+
+/**
+ * @brief Fork-join workloads which split recursively with join, run on either scheduler.
+ * Each stops splitting at a grain size, below which the work is done serially.
+ */
+struct ForkJoin
+{
+	static constexpr size_t SUM_GRAIN = 4096;
+	static constexpr size_t SORT_GRAIN = 4096;
+
+	template <typename Scheduler>
+	static uint64_t sum(Scheduler& scheduler, const uint64_t* items, size_t count)
+	{
+		if (count <= SUM_GRAIN) return std::accumulate(items, items + count, uint64_t(0));
+
+		uint64_t left = 0, right = 0;
+		scheduler.join([&]() { left = sum(scheduler, items, count / 2); }, [&]() { right = sum(scheduler, items + count / 2, count - count / 2); });
+
+		return left + right;
+	}
+
+	// no grain at all, so this is almost nothing but the cost of join
+	template <typename Scheduler>
+	static uint64_t fib(Scheduler& scheduler, uint32_t n)
+	{
+		if (n < 2) return n;
+
+		uint64_t left = 0, right = 0;
+		scheduler.join([&]() { left = fib(scheduler, n - 1); }, [&]() { right = fib(scheduler, n - 2); });
+
+		return left + right;
+	}
+
+	template <typename Scheduler>
+	static void sort(Scheduler& scheduler, uint64_t* first, uint64_t* last)
+	{
+		if (size_t(last - first) <= SORT_GRAIN) {
+			std::sort(first, last);
+			return;
+		}
+
+		// partition around the median of three, then sort the two sides in parallel
+		uint64_t pivots[3] = { first[0], first[(last - first) / 2], last[-1] };
+		std::sort(pivots, pivots + 3);
+
+		uint64_t* lower = std::partition(first, last, [pivot = pivots[1]](uint64_t item) { return item < pivot; });
+		uint64_t* upper = std::partition(lower, last, [pivot = pivots[1]](uint64_t item) { return item == pivot; });
+
+		scheduler.join([&]() { sort(scheduler, first, lower); }, [&]() { sort(scheduler, upper, last); });
+	}
+};
+
+/**
+ * @brief Measure the fork-join workloads on one scheduler with a number of workers.
+ * The scheduler is started once, outside the measurement, and each run enters it with run.
+ * @tparam Scheduler Scheduler with run and join, constructed from a worker count.
+ * @param report Report to add the results to.
+ * @param counters Hardware counters to read, these only count the calling thread, which only waits.
+ * @param container Name of the scheduler in the report.
+ * @param workerCount Number of workers.
+ */
+template <typename Scheduler>
+void benchmarkForkJoin(BenchmarkReport& report, PerfCounters& counters, const std::string& container, size_t workerCount)
+{
+	constexpr size_t SUM_COUNT = 1 << 22;
+	constexpr uint32_t FIB_N = 25;
+	constexpr size_t SORT_COUNT = 1 << 20;
+
+	Scheduler scheduler(workerCount);
+	volatile uint64_t sink = 0;
+
+	const auto noAllocations = []() { return size_t(0); };
+
+	const auto record = [&](const std::string& workload, size_t size, BenchmarkResult result) {
+		result.suite = "scheduler";
+		result.container = container;
+		result.type = "uint64_t";
+		result.operation = workload + "_" + std::to_string(workerCount) + "_threads";
+		result.size = size;
+		report.add(result);
+	};
+
+	std::vector<uint64_t> items(SORT_COUNT);
+	std::mt19937_64 random(SORT_COUNT);
+	for (uint64_t& item : items) {
+		item = random();
+	}
+
+	std::vector<uint64_t> numbers(SUM_COUNT);
+	std::iota(numbers.begin(), numbers.end(), uint64_t(0));
+
+	record("sum", SUM_COUNT, measure(counters, SUM_COUNT, noAllocations, []() { return 0; }, [&](int&) {
+		scheduler.run([&]() { sink = ForkJoin::sum(scheduler, numbers.data(), numbers.size()); });
+	}));
+
+	// fib(n) joins fib(n + 1) - 1 times, the figure is per join
+	uint64_t previous = 0, current = 1;
+	for (uint32_t n = 0; n < FIB_N; ++n) {
+		current += previous;
+		previous = current - previous;
+	}
+	const uint64_t fibJoins = current - 1;
+
+	record("fib", FIB_N, measure(counters, fibJoins, noAllocations, []() { return 0; }, [&](int&) {
+		scheduler.run([&]() { sink = ForkJoin::fib(scheduler, FIB_N); });
+	}));
+
+	record("sort", SORT_COUNT, measure(counters, SORT_COUNT, noAllocations, [&]() { return items; }, [&](std::vector<uint64_t>& unsorted) {
+		scheduler.run([&]() { ForkJoin::sort(scheduler, unsorted.data(), unsorted.data() + unsorted.size()); });
+		sink = unsorted[0];
+	}));
+}
+
+/**
+ * @brief Compare the work stealing scheduler against a pool sharing one locked queue on fork-join workloads,
+ * doubling the workers from one up to a maximum.
+ * @param report Report to add the results to.
+ * @param counters Hardware counters to read.
+ * @param maxThreads Largest number of workers, capped at the number of hardware threads.
+ */
+inline void benchmarkScheduler(BenchmarkReport& report, PerfCounters& counters, size_t maxThreads)
+{
+	const size_t workerLimit = std::min<size_t>(maxThreads, std::max(1u, std::thread::hardware_concurrency()));
+
+	for (size_t workerCount = 1; workerCount <= workerLimit; workerCount *= 2) {
+		benchmarkForkJoin<TaskScheduler>(report, counters, "TaskScheduler", workerCount);
+		benchmarkForkJoin<SharedQueueScheduler>(report, counters, "SharedQueueScheduler", workerCount);
+	}
+}
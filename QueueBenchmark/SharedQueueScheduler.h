@@ -0,0 +1,195 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+
+#include "../DynamicArray/Deque.h"
+
+/**
+ * @brief A fork-join pool whose workers all share one queue behind a mutex, the baseline the work stealing
+ * TaskScheduler is measured against. It has the same run and join: idle workers take the oldest task, and a worker
+ * waiting in join takes the newest, its own task if nobody took it, as helping with the oldest would nest one big task
+ * inside another until the stack ran out. Every push and take goes through the one lock.
+ */
+class SharedQueueScheduler
+{
+private:
+	struct Task
+	{
+		void (*m_Execute)(Task* task);
+		std::atomic<bool> m_Done = false;
+		std::exception_ptr m_Error;
+	};
+
+	template <typename Function>
+	struct FunctionTask : Task
+	{
+		Function& m_Function;
+
+		explicit FunctionTask(Function& function) : m_Function(function)
+		{
+			this->m_Execute = [](Task* task) {
+				auto* self = static_cast<FunctionTask<Function>*>(task);
+
+				try {
+					self->m_Function();
+				} catch (...) {
+					self->m_Error = std::current_exception();
+				}
+
+				self->m_Done.store(true, std::memory_order_release);
+			};
+		}
+	};
+
+	std::mutex m_Mutex;
+	std::condition_variable m_Ready, m_Finished;
+	Deque<Task*> m_Queue;
+	bool m_Stopping = false;
+
+	size_t m_WorkerCount;
+	std::unique_ptr<std::thread[]> m_Threads;
+
+	static inline thread_local SharedQueueScheduler* s_Current = nullptr;
+
+	void push(Task* task)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Queue.pushBack(task);
+		}
+
+		m_Ready.notify_one();
+	}
+
+	bool tryTakeNewest(Task*& task)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		if (m_Queue.isEmpty()) return false;
+
+		task = m_Queue.popBack();
+		return true;
+	}
+
+	void waitFor(Task& task)
+	{
+		while (!task.m_Done.load(std::memory_order_acquire)) {
+			Task* other;
+
+			if (tryTakeNewest(other)) other->m_Execute(other);
+			else std::this_thread::yield();
+		}
+	}
+
+	void workerLoop()
+	{
+		s_Current = this;
+
+		for (;;) {
+			Task* task;
+
+			{
+				std::unique_lock<std::mutex> lock(m_Mutex);
+				m_Ready.wait(lock, [this]() { return m_Stopping || !m_Queue.isEmpty(); });
+
+				if (m_Queue.isEmpty()) return;
+				task = m_Queue.popFront();
+			}
+
+			task->m_Execute(task);
+		}
+	}
+
+public:
+	explicit SharedQueueScheduler(size_t workerCount = std::max(1u, std::thread::hardware_concurrency())) :
+		m_WorkerCount(std::max<size_t>(workerCount, 1)),
+		m_Threads(new std::thread[m_WorkerCount])
+	{
+		for (size_t i = 0; i < m_WorkerCount; ++i) {
+			m_Threads[i] = std::thread([this]() { workerLoop(); });
+		}
+	}
+
+	~SharedQueueScheduler()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Stopping = true;
+		}
+
+		m_Ready.notify_all();
+
+		for (size_t i = 0; i < m_WorkerCount; ++i) {
+			m_Threads[i].join();
+		}
+	}
+
+	template <typename Function>
+	void run(Function&& function)
+	{
+		if (s_Current == this) {
+			function();
+			return;
+		}
+
+		bool finished = false;
+
+		auto root = [&]() {
+			std::exception_ptr error;
+
+			try {
+				function();
+			} catch (...) {
+				error = std::current_exception();
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(m_Mutex);
+				finished = true;
+				m_Finished.notify_all();
+			}
+
+			if (error) std::rethrow_exception(error);
+		};
+
+		FunctionTask<decltype(root)> task(root);
+		push(&task);
+
+		// the caller is not a worker, so it sleeps rather than help
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_Finished.wait(lock, [&finished]() { return finished; });
+		}
+
+		// the worker marks the task done just after, and the task must outlive that
+		while (!task.m_Done.load(std::memory_order_acquire)) {
+			std::this_thread::yield();
+		}
+
+		if (task.m_Error) std::rethrow_exception(task.m_Error);
+	}
+
+	template <typename First, typename Second>
+	void join(First&& first, Second&& second)
+	{
+		if (s_Current != this) {
+			first();
+			second();
+			return;
+		}
+
+		FunctionTask<std::remove_reference_t<Second>> task(second);
+		push(&task);
+
+		first();
+		waitFor(task);
+
+		if (task.m_Error) std::rethrow_exception(task.m_Error);
+	}
+};
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../DynamicArrayBenchmark/Benchmark.h"
+#include "../Queue/SpscQueue.h"
+#include "LockedQueue.h"
+#include "Threads.h"
+
+/**
+ * @brief Measure one producer streaming items to one consumer, and the one way latency of handing a single item over.
+ * Throughput keeps the queue busy so batches of items move per cache line transfer. Latency bounces one item between
+ * two threads through a pair of queues, so every hand over waits for the line holding the index to cross cores.
+ * @tparam QueueType Queue with tryEnqueue and tryDequeue, default constructible.
+ * @param report Report to add the results to.
+ * @param counters Hardware counters to read, these only count the consumer thread.
+ * @param cores Cores to pin the consumer and producer to, in that order.
+ * @param container Name of the queue in the report.
+ * @param capacity Capacity of the queue, reported as the size.
+ */
+template <typename QueueType>
+void benchmarkHandoff(BenchmarkReport& report, PerfCounters& counters, const std::vector<size_t>& cores, const std::string& container, size_t capacity)
+{
+	constexpr size_t ITEM_COUNT = 1 << 20;
+	constexpr size_t ROUND_TRIPS = 1 << 14;
+
+	volatile uint64_t sink = 0;
+
+	const auto noAllocations = []() { return size_t(0); };
+
+	const auto record = [&](const std::string& operation, BenchmarkResult result) {
+		result.suite = "spsc";
+		result.container = container;
+		result.type = "uint64_t";
+		result.operation = operation;
+		result.size = capacity;
+		report.add(result);
+	};
+
+	record("throughput", measure(counters, ITEM_COUNT, noAllocations, []() { return std::make_unique<QueueType>(); }, [&](std::unique_ptr<QueueType>& queue) {
+		std::thread producer([&]() {
+			pinCurrentThread(cores, 1);
+
+			size_t spins = 0;
+			for (uint64_t i = 0; i < ITEM_COUNT; ++i) {
+				while (!queue->tryEnqueue(i)) spinPause(spins);
+			}
+		});
+
+		uint64_t sum = 0;
+		size_t spins = 0;
+
+		for (size_t i = 0; i < ITEM_COUNT; ++i) {
+			uint64_t value;
+			while (!queue->tryDequeue(value)) spinPause(spins);
+			sum += value;
+		}
+
+		producer.join();
+		sink = sum;
+	}));
+
+	// a hand over is one item crossing one queue, so each round trip is two of them
+	record("handoff_latency", measure(counters, 2 * ROUND_TRIPS, noAllocations, []() { return std::make_unique<std::array<QueueType, 2>>(); }, [&](std::unique_ptr<std::array<QueueType, 2>>& queues) {
+		QueueType& ping = (*queues)[0];
+		QueueType& pong = (*queues)[1];
+
+		std::thread echo([&]() {
+			pinCurrentThread(cores, 1);
+
+			size_t spins = 0;
+			for (size_t i = 0; i < ROUND_TRIPS; ++i) {
+				uint64_t value;
+				while (!ping.tryDequeue(value)) spinPause(spins);
+				while (!pong.tryEnqueue(value + 1)) spinPause(spins);
+			}
+		});
+
+		uint64_t value = 0;
+		size_t spins = 0;
+
+		for (size_t i = 0; i < ROUND_TRIPS; ++i) {
+			while (!ping.tryEnqueue(value)) spinPause(spins);
+			while (!pong.tryDequeue(value)) spinPause(spins);
+		}
+
+		echo.join();
+		sink = value;
+	}));
+}
+
+/**
+ * @brief Compare the lock-free single producer single consumer queue against a Queue behind a mutex.
+ * @param report Report to add the results to.
+ * @param counters Hardware counters to read.
+ * @param cores Cores to pin the two threads to, pinning them to different physical cores measures the cross core hand over.
+ */
+inline void benchmarkSpsc(BenchmarkReport& report, PerfCounters& counters, const std::vector<size_t>& cores)
+{
+	constexpr size_t CAPACITY = 1024;
+
+	pinCurrentThread(cores, 0);
+
+	benchmarkHandoff<SpscQueue<uint64_t, CAPACITY>>(report, counters, cores, "SpscQueue", CAPACITY);
+	benchmarkHandoff<LockedQueue<uint64_t, CAPACITY>>(report, counters, cores, "Queue+mutex", CAPACITY);
+}
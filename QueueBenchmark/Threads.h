@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define QUEUE_BENCHMARK_PAUSE() _mm_pause()
+#else
+	#define QUEUE_BENCHMARK_PAUSE() ((void)0)
+#endif
+
+#ifdef _WIN32
+	#define NOMINMAX
+	#include <windows.h>
+#elif defined(__linux__)
+	#include <pthread.h>
+	#include <sched.h>
+#endif
+
+/**
+ * @brief Pin the calling thread to one of a list of cores, picked round robin by thread index.
+ * An empty list leaves the thread wherever the scheduler puts it.
+ * @param cores Cores to pin threads to.
+ * @param thread Index of the calling thread.
+ */
+inline void pinCurrentThread(const std::vector<size_t>& cores, size_t thread)
+{
+	if (cores.empty()) return;
+
+	const size_t core = cores[thread % cores.size()];
+
+#ifdef _WIN32
+	SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << core);
+#elif defined(__linux__)
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(core, &set);
+
+	pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+	(void)core;
+#endif
+}
+
+/**
+ * @brief Wait politely inside a spin loop.
+ * Each call pauses the core, and every few thousand calls the thread yields, so a spinning thread
+ * sharing a core with the thread it waits for does not burn its whole time slice. With a single hardware thread
+ * spinning can never see progress, so every call yields.
+ * @param spins Number of times the caller has spun so far, advanced by the call.
+ */
+inline void spinPause(size_t& spins)
+{
+	constexpr size_t SPINS_BEFORE_YIELD = 4096;
+	static const bool singleCore = std::thread::hardware_concurrency() <= 1;
+
+	if (singleCore || ++spins % SPINS_BEFORE_YIELD == 0) {
+		std::this_thread::yield();
+	} else {
+		QUEUE_BENCHMARK_PAUSE();
+	}
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../DynamicArrayBenchmark/Benchmark.h"
+#include "../Queue/PriorityQueue.h"
+#include "../Queue/TimerWheel.h"
+
+/**
+ * @brief TimerWheel with deadlines given as whole milliseconds, for the benchmarks.
+ */
+class WheelTimers
+{
+private:
+	using Clock = std::chrono::steady_clock;
+
+	TimerWheel<uint64_t> m_Wheel{ std::chrono::milliseconds(1), Clock::time_point() };
+	DynamicArray<uint64_t> m_Expired;
+
+public:
+	SlotHandle schedule(uint64_t deadline)
+	{
+		return m_Wheel.schedule(deadline, Clock::time_point() + std::chrono::milliseconds(deadline));
+	}
+
+	void cancel(const SlotHandle& handle)
+	{
+		m_Wheel.cancel(handle);
+	}
+
+	size_t advance(uint64_t now)
+	{
+		m_Expired.clear();
+		return m_Wheel.advance(Clock::time_point() + std::chrono::milliseconds(now), m_Expired);
+	}
+};
+
+/**
+ * @brief PriorityQueue of deadlines with handles, the usual heap based timer queue, as a baseline.
+ */
+class HeapTimers
+{
+private:
+	PriorityQueue<uint64_t> m_Heap;
+
+public:
+	SlotHandle schedule(uint64_t deadline)
+	{
+		return m_Heap.pushWithHandle(deadline);
+	}
+
+	void cancel(const SlotHandle& handle)
+	{
+		if (m_Heap.contains(handle)) m_Heap.erase(handle);
+	}
+
+	size_t advance(uint64_t now)
+	{
+		size_t released = 0;
+
+		while (!m_Heap.isEmpty() && m_Heap.top() <= now) {
+			m_Heap.pop();
+			++released;
+		}
+
+		return released;
+	}
+};
+
+/**
+ * @brief Measure timer churn with a number of timers outstanding.
+ * Most timeouts are cancelled before they fire, so schedule_cancel cancels the oldest timer and schedules a new one.
+ * advance lets every timer run out, moving time on a millisecond at a time while scheduling one more timer each tick.
+ * @tparam Timers Timer queue with schedule, cancel and advance, default constructible.
+ * @param report Report to add the results to.
+ * @param counters Hardware counters to read.
+ * @param container Name of the timer queue in the report.
+ * @param delays Delay in milliseconds of each outstanding timer.
+ */
+template <typename Timers>
+void benchmarkTimers(BenchmarkReport& report, PerfCounters& counters, const std::string& container, const std::vector<uint64_t>& delays)
+{
+	constexpr size_t OP_COUNT = 1 << 16;
+
+	using State = std::pair<std::unique_ptr<Timers>, std::vector<SlotHandle>>;
+
+	const size_t count = delays.size();
+	volatile size_t sink = 0;
+
+	const auto noAllocations = []() { return size_t(0); };
+	const auto scheduled = [&]() {
+		State state(std::make_unique<Timers>(), std::vector<SlotHandle>(count));
+
+		for (size_t i = 0; i < count; ++i) {
+			state.second[i] = state.first->schedule(delays[i]);
+		}
+
+		return state;
+	};
+
+	const auto record = [&](const std::string& operation, BenchmarkResult result) {
+		result.suite = "timer";
+		result.container = container;
+		result.type = "uint64_t";
+		result.operation = operation;
+		result.size = count;
+		report.add(result);
+	};
+
+	record("schedule_cancel", measure(counters, OP_COUNT, noAllocations, scheduled, [&](State& state) {
+		auto& [timers, handles] = state;
+
+		for (size_t i = 0; i < OP_COUNT; ++i) {
+			const size_t oldest = i % count;
+
+			timers->cancel(handles[oldest]);
+			handles[oldest] = timers->schedule(delays[(i * 7) % count]);
+		}
+	}));
+
+	record("advance", measure(counters, count + OP_COUNT, noAllocations, scheduled, [&](State& state) {
+		auto& timers = state.first;
+		size_t released = 0;
+
+		for (uint64_t now = 1; now <= OP_COUNT; ++now) {
+			timers->schedule(now + delays[now % count]);
+			released += timers->advance(now);
+		}
+
+		sink = released + timers->advance(UINT32_MAX);
+	}));
+}
+
+/**
+ * @brief Compare the timer wheel against a heap of timers, from 10^3 outstanding timers up to a maximum.
+ * @param report Report to add the results to.
+ * @param counters Hardware counters to read.
+ * @param maxCount Largest number of outstanding timers, each count is ten times the last.
+ */
+inline void benchmarkTimer(BenchmarkReport& report, PerfCounters& counters, size_t maxCount)
+{
+	std::mt19937_64 random(maxCount);
+
+	// timeouts spread from a millisecond to a minute
+	std::uniform_int_distribution<uint64_t> delay(1, 60'000);
+
+	for (size_t count = 1000; count <= maxCount; count *= 10) {
+		std::vector<uint64_t> delays(count);
+
+		for (uint64_t& value : delays) {
+			value = delay(random);
+		}
+
+		benchmarkTimers<WheelTimers>(report, counters, "TimerWheel", delays);
+		benchmarkTimers<HeapTimers>(report, counters, "PriorityQueue timers", delays);
+	}
+}